@@ -0,0 +1,103 @@
+//
+// flush_benchmark.cpp
+//
+// Throughput of writing SSTs: building one SST from a sorted memtable-sized
+// run (a flush), and ingesting through VeloxDB, which also merges levels.
+//
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include "VeloxDB.h"
+#include "DiskBTree.h"
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+constexpr int REPEATS = 5;
+constexpr int INGEST_KEYS = 200000;
+constexpr int MEMTABLE_SIZE = 10000;
+const std::string VALUE(100, 'v');
+const std::string DB_NAME = "benchmark_db";
+const std::string SST_NAME = "benchmark_flush.sst";
+
+int main() {
+    std::string outputDir = "./flush_throughput";
+    std::string outputFilePath = outputDir + "/flush_throughput.csv";
+    if (!fs::exists(outputDir)) {
+        fs::create_directories(outputDir);
+    }
+
+    std::ofstream csvFile(outputFilePath);
+    csvFile << "Workload,Keys,Throughput(keys/s),Throughput(MB/s)\n";
+
+    // Flush: one SST per sorted run
+    for (int numKeys : {10000, 50000, 100000}) {
+        std::vector<KeyValueWrapper> run;
+        run.reserve(numKeys);
+        for (int i = 0; i < numKeys; ++i) {
+            run.emplace_back(i, VALUE);
+        }
+
+        double seconds = 0;
+        uintmax_t bytes = 0;
+        for (int repeat = 0; repeat < REPEATS; ++repeat) {
+            fs::remove(SST_NAME);
+            auto start = high_resolution_clock::now();
+            {
+                DiskBTree sst(SST_NAME, run);
+            }
+            seconds += duration<double>(high_resolution_clock::now() - start).count();
+            bytes += fs::file_size(SST_NAME);
+        }
+        fs::remove(SST_NAME);
+
+        double keysPerSecond = numKeys * REPEATS / seconds;
+        double mbPerSecond = bytes / seconds / (1024.0 * 1024.0);
+        std::cout << "flush " << numKeys << " keys: " << keysPerSecond << " keys/s, " << mbPerSecond << " MB/s"
+                  << std::endl;
+        csvFile << "flush," << numKeys << "," << keysPerSecond << "," << mbPerSecond << "\n";
+    }
+
+    // Ingest: flushes plus level merges
+    if (fs::exists(DB_NAME)) {
+        fs::remove_all(DB_NAME);
+    }
+    {
+        auto db = std::make_unique<VeloxDB>(MEMTABLE_SIZE);
+        db->Open(DB_NAME);
+        auto start = high_resolution_clock::now();
+        WriteBatch batch;
+        for (int i = 0; i < INGEST_KEYS; ++i) {
+            batch.Put(i, VALUE);
+            if (batch.Count() == 1000) {
+                db->Write(batch);
+                batch.Clear();
+            }
+        }
+        db->Write(batch);
+        double seconds = duration<double>(high_resolution_clock::now() - start).count();
+        db->Close();
+
+        uintmax_t bytes = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(DB_NAME)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".sst") {
+                bytes += entry.file_size();
+            }
+        }
+        double keysPerSecond = INGEST_KEYS / seconds;
+        double mbPerSecond = bytes / seconds / (1024.0 * 1024.0);
+        std::cout << "ingest " << INGEST_KEYS << " keys: " << keysPerSecond << " keys/s, " << mbPerSecond
+                  << " MB/s of live SSTs" << std::endl;
+        csvFile << "ingest," << INGEST_KEYS << "," << keysPerSecond << "," << mbPerSecond << "\n";
+    }
+    fs::remove_all(DB_NAME);
+    csvFile.close();
+
+    std::cout << "Benchmark completed. Results saved to " << outputFilePath << std::endl;
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+// merge_benchmark.cpp
+//
+// k-way merge throughput: loser tree (MergingIterator) vs. a binary heap that
+// copies every entry, for k = 2..16 sorted inputs.
+//
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <fstream>
+#include <queue>
+#include <vector>
+#include "Memtable.h"
+#include "MergingIterator.h"
+
+using namespace std::chrono;
+
+constexpr int ENTRIES_PER_INPUT = 100000;
+constexpr size_t MIN_K = 2;
+constexpr size_t MAX_K = 16;
+constexpr int ROUNDS = 3;
+
+// Build k memtables whose keys interleave: input i holds i, i + k, i + 2k, ...
+std::vector<std::unique_ptr<Memtable>> buildInputs(size_t k) {
+    std::vector<std::unique_ptr<Memtable>> inputs;
+    for (size_t i = 0; i < k; ++i) {
+        auto memtable = std::make_unique<Memtable>(ENTRIES_PER_INPUT + 1);
+        for (int j = 0; j < ENTRIES_PER_INPUT; ++j) {
+            int key = static_cast<int>(i) + j * static_cast<int>(k);
+            memtable->put(KeyValueWrapper(key, key));
+        }
+        inputs.push_back(std::move(memtable));
+    }
+    return inputs;
+}
+
+// Merge through the loser tree; returns a checksum so the loop is not optimized away
+long long mergeWithLoserTree(const std::vector<std::unique_ptr<Memtable>>& inputs) {
+    std::vector<std::unique_ptr<Iterator>> children;
+    for (const auto& memtable : inputs) {
+        children.push_back(memtable->newIterator());
+    }
+    MergingIterator it(std::move(children));
+    long long checksum = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        checksum += std::get<int>(it.key());
+    }
+    return checksum;
+}
+
+// Baseline: priority queue of (entry copy, input index)
+long long mergeWithHeap(const std::vector<std::unique_ptr<Memtable>>& inputs) {
+    using HeapEntry = std::pair<KeyValueWrapper, size_t>;
+    auto greater = [](const HeapEntry& a, const HeapEntry& b) {
+        if (b.first < a.first) return true;
+        if (a.first < b.first) return false;
+        return a.second > b.second;
+    };
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, decltype(greater)> heap(greater);
+
+    std::vector<std::unique_ptr<Iterator>> children;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        children.push_back(inputs[i]->newIterator());
+        children[i]->SeekToFirst();
+        if (children[i]->Valid()) heap.emplace(children[i]->entry(), i);
+    }
+
+    long long checksum = 0;
+    while (!heap.empty()) {
+        HeapEntry top = heap.top();
+        heap.pop();
+        checksum += top.first.kv.int_key();
+        Iterator* child = children[top.second].get();
+        child->Next();
+        if (child->Valid()) heap.emplace(child->entry(), top.second);
+    }
+    return checksum;
+}
+
+int main() {
+    std::ofstream csvFile("merge_benchmark.csv");
+    csvFile << "K,TotalEntries,LoserTreeMs,HeapMs,LoserTreeMEntriesPerSec,HeapMEntriesPerSec\n";
+
+    for (size_t k = MIN_K; k <= MAX_K; ++k) {
+        auto inputs = buildInputs(k);
+        size_t totalEntries = k * ENTRIES_PER_INPUT;
+
+        double loserTreeMs = 0, heapMs = 0;
+        for (int round = 0; round < ROUNDS; ++round) {
+            auto start = high_resolution_clock::now();
+            long long loserChecksum = mergeWithLoserTree(inputs);
+            auto mid = high_resolution_clock::now();
+            long long heapChecksum = mergeWithHeap(inputs);
+            auto end = high_resolution_clock::now();
+
+            if (loserChecksum != heapChecksum) {
+                std::cerr << "Checksum mismatch for k = " << k << std::endl;
+                return 1;
+            }
+            loserTreeMs += duration<double, std::milli>(mid - start).count();
+            heapMs += duration<double, std::milli>(end - mid).count();
+        }
+        loserTreeMs /= ROUNDS;
+        heapMs /= ROUNDS;
+
+        double loserRate = totalEntries / (loserTreeMs * 1000.0);
+        double heapRate = totalEntries / (heapMs * 1000.0);
+        std::cout << "k = " << k << ": loser tree " << loserTreeMs << " ms (" << loserRate
+                  << " M entries/s), heap " << heapMs << " ms (" << heapRate << " M entries/s)" << std::endl;
+        csvFile << k << "," << totalEntries << "," << loserTreeMs << "," << heapMs << ","
+                << loserRate << "," << heapRate << "\n";
+    }
+
+    csvFile.close();
+    std::cout << "Benchmark completed. Results saved to merge_benchmark.csv" << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+//
+// mt_get_benchmark.cpp
+//
+// Get throughput with 1 to hardware_concurrency reader threads on the same
+// database. Reads share the LSM tree and use positional reads on each SST.
+//
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <filesystem>
+#include "VeloxDB.h"
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+constexpr int NUM_KEYS = 500000;
+constexpr int MEMTABLE_SIZE = 10000;
+constexpr int GETS_PER_THREAD = 5000;
+const std::string DB_NAME = "benchmark_db";
+
+int main() {
+    std::string outputDir = "./mt_get_throughput";
+    std::string outputFilePath = outputDir + "/mt_get_throughput.csv";
+    if (!fs::exists(outputDir)) {
+        fs::create_directories(outputDir);
+    }
+    if (fs::exists(DB_NAME)) {
+        fs::remove_all(DB_NAME);
+    }
+
+    auto db = std::make_unique<VeloxDB>(MEMTABLE_SIZE);
+    db->Open(DB_NAME);
+
+    WriteBatch batch;
+    for (int i = 0; i < NUM_KEYS; ++i) {
+        batch.Put(i, i);
+        if (batch.Count() == 1000) {
+            db->Write(batch);
+            batch.Clear();
+        }
+    }
+    db->Write(batch);
+
+    std::ofstream csvFile(outputFilePath);
+    csvFile << "Threads,TotalGets,Seconds,GetsPerSecond\n";
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        std::atomic<long long> misses{0};
+        std::vector<std::thread> threads;
+        auto start = high_resolution_clock::now();
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&db, &misses, t]() {
+                std::mt19937 rng(t + 1);
+                std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+                for (int i = 0; i < GETS_PER_THREAD; ++i) {
+                    if (db->Get(keyDist(rng)).isEmpty()) misses++;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double seconds = duration<double>(high_resolution_clock::now() - start).count();
+
+        if (misses.load() != 0) {
+            std::cerr << "Missing keys: " << misses.load() << std::endl;
+            return 1;
+        }
+        long long totalGets = static_cast<long long>(numThreads) * GETS_PER_THREAD;
+        std::cout << numThreads << " threads: " << totalGets / seconds << " gets/s" << std::endl;
+        csvFile << numThreads << "," << totalGets << "," << seconds << "," << totalGets / seconds << "\n";
+    }
+    csvFile.close();
+
+    db->Close();
+    fs::remove_all(DB_NAME);
+    std::cout << "Benchmark completed. Results saved to " << outputFilePath << std::endl;
+    return 0;
+}
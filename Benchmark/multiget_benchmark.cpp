@@ -0,0 +1,101 @@
+//
+// multiget_benchmark.cpp
+//
+// Per-key latency of MultiGet against a loop of Gets, for request sizes of
+// 100 to 1000 random keys and I/O queue depths of 1 and 8.
+//
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <filesystem>
+#include "VeloxDB.h"
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+constexpr int NUM_KEYS = 500000;
+constexpr int MEMTABLE_SIZE = 10000;
+constexpr int REQUESTS_PER_SIZE = 20;
+const std::string DB_NAME = "benchmark_db";
+
+int main() {
+    std::string outputDir = "./multiget_latency";
+    std::string outputFilePath = outputDir + "/multiget_latency.csv";
+    if (!fs::exists(outputDir)) {
+        fs::create_directories(outputDir);
+    }
+    if (fs::exists(DB_NAME)) {
+        fs::remove_all(DB_NAME);
+    }
+
+    auto db = std::make_unique<VeloxDB>(MEMTABLE_SIZE);
+    db->Open(DB_NAME);
+
+    // Populate with 2x the key range so half of the lookups miss
+    WriteBatch batch;
+    for (int i = 0; i < NUM_KEYS; ++i) {
+        batch.Put(i * 2, i);
+        if (batch.Count() == 1000) {
+            db->Write(batch);
+            batch.Clear();
+        }
+    }
+    db->Write(batch);
+
+    std::ofstream csvFile(outputFilePath);
+    csvFile << "QueueDepth,KeysPerRequest,GetLoopLatency(us/key),MultiGetLatency(us/key),Speedup\n";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> keyDist(0, NUM_KEYS * 2 - 1);
+    for (size_t queueDepth : {1, 8}) {
+        db->setIOQueueDepth(queueDepth);
+        for (size_t keysPerRequest : {100, 250, 500, 1000}) {
+            double getLoopUs = 0, multiGetUs = 0;
+            for (int request = 0; request < REQUESTS_PER_SIZE; ++request) {
+                std::vector<int> keys(keysPerRequest);
+                for (auto& key : keys) {
+                    key = keyDist(rng);
+                }
+
+                auto start = high_resolution_clock::now();
+                size_t foundByGet = 0;
+                for (int key : keys) {
+                    if (!db->Get(key).isEmpty()) foundByGet++;
+                }
+                auto mid = high_resolution_clock::now();
+                std::vector<KeyValueWrapper> results = db->MultiGet(keys);
+                auto end = high_resolution_clock::now();
+
+                size_t foundByMultiGet = 0;
+                for (const auto& result : results) {
+                    if (!result.isEmpty()) foundByMultiGet++;
+                }
+                if (foundByGet != foundByMultiGet) {
+                    std::cerr << "MultiGet and Get disagree" << std::endl;
+                    return 1;
+                }
+                getLoopUs += duration<double, std::micro>(mid - start).count();
+                multiGetUs += duration<double, std::micro>(end - mid).count();
+            }
+
+            double totalKeys = static_cast<double>(keysPerRequest) * REQUESTS_PER_SIZE;
+            double getLoopLatency = getLoopUs / totalKeys;
+            double multiGetLatency = multiGetUs / totalKeys;
+            std::cout << "queue depth " << queueDepth << ", " << keysPerRequest << " keys/request: Get loop "
+                      << getLoopLatency << " us/key, MultiGet " << multiGetLatency << " us/key" << std::endl;
+            csvFile << queueDepth << "," << keysPerRequest << "," << getLoopLatency << "," << multiGetLatency << ","
+                    << getLoopLatency / multiGetLatency << "\n";
+        }
+    }
+    csvFile.close();
+
+    db->Close();
+    fs::remove_all(DB_NAME);
+    std::cout << "Benchmark completed. Results saved to " << outputFilePath << std::endl;
+    return 0;
+}
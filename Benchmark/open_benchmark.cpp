@@ -0,0 +1,101 @@
+//
+// open_benchmark.cpp
+//
+// Time to open a database whose level holds thousands of SSTs. The sequential open does
+// what loading them used to take: open the SSTs one by one and read the first leaf of each
+// for its smallest key. The database open reads the manifest log (SSTs opened in parallel,
+// smallest keys from the manifest). Both find the SSTs in the page cache.
+//
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include "LSMTree.h"
+#include "Manifest.h"
+#include "DiskBTree.h"
+#include "SortedRun.h"
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+constexpr int KEYS_PER_SST = 64;
+const std::string VALUE(100, 'v');
+const std::string DB_NAME = "benchmark_open_db";
+
+// One level of numSSTs SSTs with consecutive key ranges, listed in a manifest log
+std::vector<std::string> createDatabase(int numSSTs) {
+    if (fs::exists(DB_NAME)) {
+        fs::remove_all(DB_NAME);
+    }
+    fs::create_directories(DB_NAME);
+
+    VersionEdit snapshot;
+    snapshot.nextFileNumber = static_cast<uint64_t>(numSSTs);
+    snapshot.levelCapacities = {{1, static_cast<size_t>(numSSTs) * KEYS_PER_SST}};
+    std::vector<std::string> paths;
+    for (int i = 0; i < numSSTs; ++i) {
+        std::vector<KeyValueWrapper> run;
+        for (int j = 0; j < KEYS_PER_SST; ++j) {
+            run.emplace_back(i * KEYS_PER_SST + j, VALUE);
+        }
+        std::string fileName = "L1_SSTable_" + std::to_string(i) + ".sst";
+        paths.push_back(DB_NAME + "/" + fileName);
+        DiskBTree sst(paths.back(), run);
+        snapshot.addedFiles.push_back({1, fileName, run.front()});
+    }
+    ManifestLog(DB_NAME + "/manifest.log", snapshot);
+    return paths;
+}
+
+// Open the SSTs one by one into a run that reads their smallest keys, and return the seconds it took
+double timeSequentialOpen(const std::vector<std::string>& paths) {
+    auto start = high_resolution_clock::now();
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+    for (const auto& path : paths) {
+        ssts.push_back(std::make_shared<DiskBTree>(path));
+    }
+    SortedRun run(std::move(ssts));
+    return duration<double>(high_resolution_clock::now() - start).count();
+}
+
+// Open the database, check one key, and return the seconds the constructor took
+double timeOpen(int numSSTs) {
+    auto start = high_resolution_clock::now();
+    LSMTree lsmTree(1000, DB_NAME);
+    double seconds = duration<double>(high_resolution_clock::now() - start).count();
+
+    int key = numSSTs * KEYS_PER_SST / 2;
+    if (lsmTree.get(KeyValueWrapper(key, "")).isEmpty() || lsmTree.getNumSSTsInLevel(1) != static_cast<size_t>(numSSTs)) {
+        std::cerr << "open benchmark: database opened incompletely" << std::endl;
+    }
+    return seconds;
+}
+
+int main() {
+    std::string outputDir = "./open_time";
+    std::string outputFilePath = outputDir + "/open_time.csv";
+    if (!fs::exists(outputDir)) {
+        fs::create_directories(outputDir);
+    }
+
+    std::ofstream csvFile(outputFilePath);
+    csvFile << "SSTs,SequentialOpen(ms),ManifestLog(ms)\n";
+
+    for (int numSSTs : {500, 2000, 5000}) {
+        std::vector<std::string> paths = createDatabase(numSSTs);
+        double sequentialSeconds = timeSequentialOpen(paths);
+        double logSeconds = timeOpen(numSSTs);
+
+        std::cout << numSSTs << " SSTs: sequential open " << sequentialSeconds * 1000 << " ms, manifest log "
+                  << logSeconds * 1000 << " ms" << std::endl;
+        csvFile << numSSTs << "," << sequentialSeconds * 1000 << "," << logSeconds * 1000 << "\n";
+    }
+    fs::remove_all(DB_NAME);
+    csvFile.close();
+
+    std::cout << "Benchmark completed. Results saved to " << outputFilePath << std::endl;
+    return 0;
+}
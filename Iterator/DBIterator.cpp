@@ -0,0 +1,145 @@
+//
+// DBIterator.cpp
+//
+
+#include "DBIterator.h"
+#include <algorithm>
+#include <stdexcept>
+
+DBIterator::DBIterator(std::vector<std::unique_ptr<Iterator>> children, RangeTombstoneList rangeTombstones,
+                       std::shared_ptr<const MergeOperator> mergeOperator)
+    : mergingIterator(std::move(children)), rangeTombstones(std::move(rangeTombstones)),
+      mergeOperator(std::move(mergeOperator)), nowMillis(KeyValueWrapper::currentTimeMillis()) {}
+
+bool DBIterator::Valid() const {
+    return valid;
+}
+
+void DBIterator::SeekToFirst() {
+    mergingIterator.SeekToFirst();
+    findNextVisible();
+}
+
+void DBIterator::SeekToLast() {
+    mergingIterator.SeekToLast();
+    findPrevVisible();
+}
+
+void DBIterator::Seek(const KeyValueWrapper& target) {
+    mergingIterator.Seek(target);
+    findNextVisible();
+}
+
+void DBIterator::SeekForPrev(const KeyValueWrapper& target) {
+    mergingIterator.SeekForPrev(target);
+    findPrevVisible();
+}
+
+void DBIterator::Next() {
+    if (!valid) {
+        throw std::logic_error("DBIterator::Next() called on an invalid iterator");
+    }
+    if (!forward) {
+        // Reposition after every version of the current key
+        mergingIterator.Seek(current);
+        while (mergingIterator.Valid() && mergingIterator.entry() == current) {
+            mergingIterator.Next();
+        }
+    }
+    findNextVisible();
+}
+
+void DBIterator::Prev() {
+    if (!valid) {
+        throw std::logic_error("DBIterator::Prev() called on an invalid iterator");
+    }
+    if (forward) {
+        // Reposition before every version of the current key
+        mergingIterator.SeekForPrev(current);
+        while (mergingIterator.Valid() && mergingIterator.entry() == current) {
+            mergingIterator.Prev();
+        }
+    }
+    findPrevVisible();
+}
+
+const KeyValueWrapper& DBIterator::entry() const {
+    if (!valid) {
+        throw std::logic_error("DBIterator::entry() called on an invalid iterator");
+    }
+    return current;
+}
+
+void DBIterator::resolveVersions() {
+    versions.clear();
+    versions.push_back(mergingIterator.entry());
+    while (true) {
+        if (forward) {
+            mergingIterator.Next();
+        } else {
+            mergingIterator.Prev();
+        }
+        if (!mergingIterator.Valid() || mergingIterator.entry() != versions.front()) {
+            break;
+        }
+        versions.push_back(mergingIterator.entry());
+    }
+
+    // Newest first. On equal sequence numbers the newer source wins: it comes first
+    // going forward and last going backward.
+    if (!forward) {
+        std::reverse(versions.begin(), versions.end());
+    }
+    std::stable_sort(versions.begin(), versions.end(), [](const KeyValueWrapper& a, const KeyValueWrapper& b) {
+        return a.sequenceNumber > b.sequenceNumber;
+    });
+
+    if (!versions.front().isMergeOperand() || isDeleted(versions.front())) {
+        current = versions.front();
+        return;
+    }
+
+    // Fold the operands down to the first value or deletion
+    size_t numOperands = 0;
+    while (numOperands < versions.size() && versions[numOperands].isMergeOperand() &&
+           !isDeleted(versions[numOperands])) {
+        ++numOperands;
+    }
+    KeyValueWrapper base;
+    if (numOperands < versions.size() && !isDeleted(versions[numOperands])) {
+        base = versions[numOperands];
+    }
+    if (!mergeOperator) {
+        throw std::runtime_error("DBIterator: merge operands need a merge operator, none is set");
+    }
+    versions.resize(numOperands);
+    current = mergeOperator->fold(base.isEmpty() ? nullptr : &base, versions);
+}
+
+bool DBIterator::isDeleted(const KeyValueWrapper& kv) const {
+    return kv.isTombstone() || rangeTombstones.covers(kv) || kv.isExpired(nowMillis);
+}
+
+void DBIterator::findNextVisible() {
+    forward = true;
+    while (mergingIterator.Valid()) {
+        resolveVersions();
+        if (!isDeleted(current)) {
+            valid = true;
+            return;
+        }
+    }
+    valid = false;
+}
+
+void DBIterator::findPrevVisible() {
+    forward = false;
+    while (mergingIterator.Valid()) {
+        resolveVersions();
+        if (!isDeleted(current)) {
+            valid = true;
+            return;
+        }
+    }
+    valid = false;
+}
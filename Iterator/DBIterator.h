@@ -0,0 +1,64 @@
+//
+// DBIterator.h
+//
+
+#ifndef DB_ITERATOR_H
+#define DB_ITERATOR_H
+
+#include "MergingIterator.h"
+#include "MergeOperator.h"
+#include "RangeTombstone.h"
+#include <memory>
+#include <vector>
+
+// User-facing iterator over the whole database. Resolves the versions of each key
+// coming out of the merging iterator to the one with the highest sequence number
+// and hides deleted keys, including those covered by a newer range tombstone or expired.
+// Merge operands are folded with the versions below them into a value.
+class DBIterator : public Iterator {
+public:
+    // children: memtable first, then SSTs from the newest level to the oldest;
+    // rangeTombstones: the range deletions of all of them; mergeOperator: needed only if
+    // the children hold merge operands
+    explicit DBIterator(std::vector<std::unique_ptr<Iterator>> children,
+                        RangeTombstoneList rangeTombstones = RangeTombstoneList(),
+                        std::shared_ptr<const MergeOperator> mergeOperator = nullptr);
+
+    bool Valid() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const KeyValueWrapper& target) override;
+    void SeekForPrev(const KeyValueWrapper& target) override;
+    void Next() override;
+    void Prev() override;
+    const KeyValueWrapper& entry() const override;
+
+private:
+    MergingIterator mergingIterator;
+    RangeTombstoneList rangeTombstones;
+    std::shared_ptr<const MergeOperator> mergeOperator;
+
+    // Entries expired at this time (when the iterator was created) are hidden
+    uint64_t nowMillis;
+
+    // Versions of the key being resolved, reused across keys
+    std::vector<KeyValueWrapper> versions;
+
+    // Newest version of the key the iterator is positioned at
+    KeyValueWrapper current;
+    bool valid = false;
+
+    // Direction of the last move; mergingIterator is past current in this direction
+    bool forward = true;
+
+    // Resolve the key under mergingIterator, skipping deleted keys
+    void findNextVisible();
+    void findPrevVisible();
+    bool isDeleted(const KeyValueWrapper& kv) const;
+
+    // Consume every version of the key under mergingIterator, setting current to the one
+    // with the highest sequence number, or to the fold of its merge operands
+    void resolveVersions();
+};
+
+#endif // DB_ITERATOR_H
@@ -0,0 +1,45 @@
+//
+// Iterator.h
+//
+
+#ifndef ITERATOR_H
+#define ITERATOR_H
+
+#include "KeyValue.h"
+
+// Bidirectional iterator over key-value pairs in key order.
+// Implementations read lazily, so iterating holds only the current position in memory.
+class Iterator {
+public:
+    virtual ~Iterator() = default;
+
+    // True while the iterator is positioned at an entry
+    virtual bool Valid() const = 0;
+
+    // Position at the first entry
+    virtual void SeekToFirst() = 0;
+
+    // Position at the last entry
+    virtual void SeekToLast() = 0;
+
+    // Position at the first entry with key >= target
+    virtual void Seek(const KeyValueWrapper& target) = 0;
+
+    // Position at the last entry with key <= target
+    virtual void SeekForPrev(const KeyValueWrapper& target) = 0;
+
+    // Move to the next entry; requires Valid()
+    virtual void Next() = 0;
+
+    // Move to the previous entry; requires Valid()
+    virtual void Prev() = 0;
+
+    // Current entry (key, value, sequence number and tombstone); requires Valid()
+    virtual const KeyValueWrapper& entry() const = 0;
+
+    // Key and value of the current entry, as the types they were written with; requires Valid()
+    KeyValueField key() const { return entry().getKey(); }
+    KeyValueField value() const { return entry().getValue(); }
+};
+
+#endif // ITERATOR_H
@@ -0,0 +1,69 @@
+//
+// LoserTree.cpp
+//
+
+#include "LoserTree.h"
+#include <utility>
+
+LoserTree::LoserTree(std::vector<Iterator*> inputs)
+    : inputs(std::move(inputs)), losers(this->inputs.size(), NONE) {}
+
+bool LoserTree::beats(size_t a, size_t b) const {
+    bool validA = inputs[a]->Valid();
+    bool validB = inputs[b]->Valid();
+    if (!validA || !validB) {
+        return validA;
+    }
+    const KeyValueWrapper& kvA = inputs[a]->entry();
+    const KeyValueWrapper& kvB = inputs[b]->entry();
+    if (forward) {
+        if (kvA < kvB) return true;
+        if (kvB < kvA) return false;
+        return a < b;
+    }
+    if (kvB < kvA) return true;
+    if (kvA < kvB) return false;
+    return a > b;
+}
+
+void LoserTree::build(bool direction) {
+    forward = direction;
+    const size_t k = inputs.size();
+    if (k == 0) {
+        winnerIndex = NONE;
+        return;
+    }
+
+    // Play the matches bottom-up; node p's children are 2p and 2p + 1
+    std::vector<size_t> winners(2 * k);
+    for (size_t i = 0; i < k; ++i) {
+        winners[k + i] = i;
+    }
+    for (size_t p = k - 1; p >= 1; --p) {
+        size_t a = winners[2 * p];
+        size_t b = winners[2 * p + 1];
+        if (beats(a, b)) {
+            winners[p] = a;
+            losers[p] = b;
+        } else {
+            winners[p] = b;
+            losers[p] = a;
+        }
+    }
+    size_t champion = k == 1 ? 0 : winners[1];
+    winnerIndex = inputs[champion]->Valid() ? champion : NONE;
+}
+
+void LoserTree::replay() {
+    if (winnerIndex == NONE) {
+        return;
+    }
+    const size_t k = inputs.size();
+    size_t current = winnerIndex;
+    for (size_t p = (k + winnerIndex) / 2; p >= 1; p /= 2) {
+        if (beats(losers[p], current)) {
+            std::swap(losers[p], current);
+        }
+    }
+    winnerIndex = inputs[current]->Valid() ? current : NONE;
+}
@@ -0,0 +1,54 @@
+//
+// LoserTree.h
+//
+
+#ifndef LOSER_TREE_H
+#define LOSER_TREE_H
+
+#include "Iterator.h"
+#include <vector>
+#include <cstddef>
+
+// Tournament (loser) tree over k iterator handles. Each internal node keeps the
+// loser of the match played there, so after the winner advances only the
+// log2(k) matches on its path to the root are replayed. Entries are compared in
+// place through the handles; nothing is copied.
+//
+// Order is (key, input index): ascending going forward, descending going backward.
+// Exhausted inputs lose every match.
+class LoserTree {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    explicit LoserTree(std::vector<Iterator*> inputs);
+
+    // Play all matches from the inputs' current positions
+    void build(bool forward = true);
+
+    // Index of the input holding the next entry, NONE if all inputs are exhausted
+    size_t winner() const { return winnerIndex; }
+    bool empty() const { return winnerIndex == NONE; }
+
+    // Entry of the winning input; requires !empty()
+    const KeyValueWrapper& top() const { return inputs[winnerIndex]->entry(); }
+
+    // Replay the winner's path after its input has been moved
+    void replay();
+
+    size_t size() const { return inputs.size(); }
+    Iterator* input(size_t i) const { return inputs[i]; }
+    bool isForward() const { return forward; }
+
+private:
+    std::vector<Iterator*> inputs;
+
+    // losers[p] for internal nodes p = 1..k-1; leaf of input i is node k + i
+    std::vector<size_t> losers;
+    size_t winnerIndex = NONE;
+    bool forward = true;
+
+    // True if input a wins against input b
+    bool beats(size_t a, size_t b) const;
+};
+
+#endif // LOSER_TREE_H
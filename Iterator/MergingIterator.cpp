@@ -0,0 +1,106 @@
+//
+// MergingIterator.cpp
+//
+
+#include "MergingIterator.h"
+#include <stdexcept>
+
+MergingIterator::MergingIterator(std::vector<std::unique_ptr<Iterator>> children)
+    : children(std::move(children)), tree(handles(this->children)) {}
+
+std::vector<Iterator*> MergingIterator::handles(const std::vector<std::unique_ptr<Iterator>>& children) {
+    std::vector<Iterator*> result;
+    result.reserve(children.size());
+    for (const auto& child : children) {
+        result.push_back(child.get());
+    }
+    return result;
+}
+
+bool MergingIterator::Valid() const {
+    return !tree.empty();
+}
+
+void MergingIterator::SeekToFirst() {
+    for (auto& child : children) {
+        child->SeekToFirst();
+    }
+    tree.build(true);
+}
+
+void MergingIterator::SeekToLast() {
+    for (auto& child : children) {
+        child->SeekToLast();
+    }
+    tree.build(false);
+}
+
+void MergingIterator::Seek(const KeyValueWrapper& target) {
+    for (auto& child : children) {
+        child->Seek(target);
+    }
+    tree.build(true);
+}
+
+void MergingIterator::SeekForPrev(const KeyValueWrapper& target) {
+    for (auto& child : children) {
+        child->SeekForPrev(target);
+    }
+    tree.build(false);
+}
+
+void MergingIterator::Next() {
+    if (tree.empty()) {
+        throw std::logic_error("MergingIterator::Next() called on an invalid iterator");
+    }
+    if (!tree.isForward()) {
+        switchDirection(true);
+    }
+    children[tree.winner()]->Next();
+    tree.replay();
+}
+
+void MergingIterator::Prev() {
+    if (tree.empty()) {
+        throw std::logic_error("MergingIterator::Prev() called on an invalid iterator");
+    }
+    if (tree.isForward()) {
+        switchDirection(false);
+    }
+    children[tree.winner()]->Prev();
+    tree.replay();
+}
+
+const KeyValueWrapper& MergingIterator::entry() const {
+    if (tree.empty()) {
+        throw std::logic_error("MergingIterator::entry() called on an invalid iterator");
+    }
+    return tree.top();
+}
+
+void MergingIterator::switchDirection(bool toForward) {
+    // The current entry stays current; every other child moves to its nearest
+    // entry on the new side of (key, current child) in (key, child index) order
+    size_t current = tree.winner();
+    KeyValueWrapper key = children[current]->entry();
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (i == current) {
+            continue;
+        }
+        Iterator& child = *children[i];
+        if (toForward) {
+            // Children before current only keep keys > key
+            child.Seek(key);
+            if (i < current && child.Valid() && child.entry() == key) {
+                child.Next();
+            }
+        } else {
+            // Children after current only keep keys < key
+            child.SeekForPrev(key);
+            if (i > current && child.Valid() && child.entry() == key) {
+                child.Prev();
+            }
+        }
+    }
+    tree.build(toForward);
+}
@@ -0,0 +1,42 @@
+//
+// MergingIterator.h
+//
+
+#ifndef MERGING_ITERATOR_H
+#define MERGING_ITERATOR_H
+
+#include "Iterator.h"
+#include "LoserTree.h"
+#include <memory>
+#include <vector>
+
+// Merges sorted child iterators into one sorted stream with a loser tree.
+// Every entry of every child is returned; entries with equal keys come out
+// in child order going forward (reverse child order going backward), so
+// children should be ordered newest first.
+class MergingIterator : public Iterator {
+public:
+    explicit MergingIterator(std::vector<std::unique_ptr<Iterator>> children);
+
+    bool Valid() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const KeyValueWrapper& target) override;
+    void SeekForPrev(const KeyValueWrapper& target) override;
+    void Next() override;
+    void Prev() override;
+    const KeyValueWrapper& entry() const override;
+
+private:
+    std::vector<std::unique_ptr<Iterator>> children;
+
+    // Tournament over the children; its winner is the current entry
+    LoserTree tree;
+
+    // Reposition every child next to the current entry for the new direction
+    void switchDirection(bool toForward);
+
+    static std::vector<Iterator*> handles(const std::vector<std::unique_ptr<Iterator>>& children);
+};
+
+#endif // MERGING_ITERATOR_H
@@ -2,13 +2,23 @@
 
 
 #include "LSMTree.h"
+#include "LoserTree.h"
+#include "SSTBuilder.h"
+#include "SSTPrefetchIterator.h"
+#include "MemtableIterator.h"
 #include <iostream>
+#include <map>
 #include <stdexcept>
-#include <queue>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <exception>
 
 // Constructor
-LSMTree::LSMTree(size_t memtableSize, const std::string& dbPath)
-    : dbPath(dbPath), lsmFilePath(dbPath + "/manifest.lsm") {
+LSMTree::LSMTree(size_t memtableSize, const std::string& dbPath, std::shared_ptr<const MergeOperator> mergeOperator)
+    : dbPath(dbPath), manifestLogPath(dbPath + "/manifest.log"), lsmFilePath(dbPath + "/manifest.lsm"),
+      mergeOperator(std::move(mergeOperator)) {
     // Create the database directory if it doesn't exist
     if (!fs::exists(this->dbPath)) {
         fs::create_directories(this->dbPath);
@@ -28,10 +38,26 @@ LSMTree::LSMTree(size_t memtableSize, const std::string& dbPath)
 
     // Initialize LSM tree
     initializeLSM();
+
+    // Recover unflushed writes
+    openWAL();
+}
+
+// Column family constructor; the database replays the shared WAL
+LSMTree::LSMTree(size_t memtableSize, const std::string& dbPath, const ColumnFamilyHandle& columnFamily,
+                 std::shared_ptr<ColumnFamilyShared> shared, std::shared_ptr<const MergeOperator> mergeOperator)
+    : dbPath(dbPath), manifestLogPath(dbPath + "/manifest.log"), lsmFilePath(dbPath + "/manifest.lsm"),
+      shared(std::move(shared)), columnFamily(columnFamily), sharesWAL(true), mergeOperator(std::move(mergeOperator)) {
+    if (!fs::exists(this->dbPath)) {
+        fs::create_directories(this->dbPath);
+    }
+    memtable = std::make_unique<Memtable>(static_cast<int>(memtableSize));
+    initializeLSM();
 }
 
 // Destructor
 LSMTree::~LSMTree() {
+    periodicCompaction.reset();
     // Save the state to the .lsm file upon destruction
     try {
         saveState();
@@ -42,7 +68,7 @@ LSMTree::~LSMTree() {
 
 // Initialize LSM tree by loading existing state or setting up a new one
 void LSMTree::initializeLSM() {
-    if (fs::exists(lsmFilePath)) {
+    if (hasManifest()) {
         // If manifest file exists, load the state
         loadState();
     } else {
@@ -51,109 +77,258 @@ void LSMTree::initializeLSM() {
     }
 }
 
-// Save the state of the LSM tree to a .lsm file
+// Record the current levels in the manifest log
 void LSMTree::saveState() {
-    // Output the manifest file path for debugging
-    std::cout << "manifest file path: " << lsmFilePath << std::endl;
-
-    // Ensure the manifest file exists; create it if it doesn't
-    if (!std::filesystem::exists(lsmFilePath)) {
-        std::ofstream newFile(lsmFilePath, std::ios::binary); // This creates the file
-        // if (!newFile) {
-        //     throw std::runtime_error("LSMTree::saveState() Failed to create manifest file");
-        // }
-        newFile.close();
-    }
-
-    // Open the manifest file for writing
-    std::ofstream ofs(lsmFilePath, std::ios::binary | std::ios::trunc);
-    // if (!ofs) {
-    //     throw std::runtime_error("LSMTree::saveState() Failed to open LSM tree file for writing");
-    // }
-
-    // Write the number of levels (excluding memtable)
-    size_t numLevels = levels.size();
-    ofs.write(reinterpret_cast<const char*>(&numLevels), sizeof(numLevels));
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    writeManifest();
+}
 
-    // Write the SSTable information for each level
-    for (size_t i = 0; i < numLevels; ++i) {
-        // Write the level number
-        int levelNumber = static_cast<int>(i + 1); // Levels start from 1
-        ofs.write(reinterpret_cast<const char*>(&levelNumber), sizeof(levelNumber));
-
-        // Write the SSTable file name (only the filename, not the full path)
-        if (levels[i]) {
-            // Extract only the filename from the full path
-            std::filesystem::path fullPath = levels[i]->getFileName();
-            std::string sstableFileName = fullPath.filename().string();
-            size_t fileNameLength = sstableFileName.size();
-
-            ofs.write(reinterpret_cast<const char*>(&fileNameLength), sizeof(fileNameLength));
-            ofs.write(sstableFileName.c_str(), fileNameLength);
-        } else {
-            // No SSTable at this level
-            size_t fileNameLength = 0;
-            ofs.write(reinterpret_cast<const char*>(&fileNameLength), sizeof(fileNameLength));
+void LSMTree::writeManifest() {
+    ManifestState current = currentManifestState();
+    if (!manifestLog || manifestLog->getNumEdits() >= ManifestLog::SNAPSHOT_INTERVAL) {
+        // Start a new log from a snapshot; it replaces the old log (and a legacy manifest)
+        manifestLog.reset();
+        manifestLog = std::make_unique<ManifestLog>(manifestLogPath.string(), ManifestState::diff(ManifestState(), current));
+        fs::remove(lsmFilePath);
+    } else {
+        VersionEdit edit = ManifestState::diff(manifestState, current);
+        bool unchanged = edit.levelCapacities.empty() && edit.removedFiles.empty() && edit.addedFiles.empty()
+                         && current.lastSequenceNumber == manifestState.lastSequenceNumber
+                         && current.flushedSequenceNumber == manifestState.flushedSequenceNumber;
+        if (!unchanged) {
+            manifestLog->append(edit);
         }
+    }
+    manifestState = std::move(current);
 
-        // Write the level capacity
-        size_t levelCapacity = levelMaxSizes[i];
-        ofs.write(reinterpret_cast<const char*>(&levelCapacity), sizeof(levelCapacity));
+    // No edit names the replaced SSTs any more
+    for (const auto& fileName : obsoleteFiles) {
+        fs::remove(fileName);
     }
+    obsoleteFiles.clear();
+}
 
-    ofs.close();
+ManifestState LSMTree::currentManifestState() const {
+    ManifestState state;
+    state.lastSequenceNumber = shared->lastSequenceNumber.load();
+    state.flushedSequenceNumber = flushedSequenceNumber;
+    state.nextFileNumber = nextFileNumber;
+    state.levelCapacities.assign(levelMaxSizes.begin(), levelMaxSizes.begin() + levels.size());
+    state.levelFiles.resize(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (!levels[i]) {
+            continue;
+        }
+        const auto& ssts = levels[i]->getSSTs();
+        for (size_t j = 0; j < ssts.size(); ++j) {
+            // Only the filename, not the full path
+            std::string sstableFileName = fs::path(ssts[j]->getFileName()).filename().string();
+            state.levelFiles[i][sstableFileName] = levels[i]->getSmallestKeys()[j];
+        }
+    }
+    return state;
 }
 
-// Load the state of the LSM tree from a .lsm file
+// Load the levels from the manifest log
 void LSMTree::loadState() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    loadManifest();
+}
+
+void LSMTree::loadManifest() {
+    // The first write after opening starts a new log from a snapshot
+    manifestLog.reset();
+    obsoleteFiles.clear();
+    nextFileNumber = 0;
+    if (!fs::exists(manifestLogPath)) {
+        loadLegacyManifest();
+        return;
+    }
+
+    ManifestState state;
+    ManifestLog::replay(manifestLogPath.string(), state);
+    shared->lastSequenceNumber = std::max(shared->lastSequenceNumber.load(), state.lastSequenceNumber);
+    flushedSequenceNumber = state.flushedSequenceNumber;
+    nextFileNumber = state.nextFileNumber;
+
+    // Open the SSTs of all levels together; the manifest has their smallest keys, so
+    // building the runs reads no leaf
+    std::vector<std::vector<std::string>> levelFileNames(state.levelCapacities.size());
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < levelFileNames.size(); ++i) {
+        levelFileNames[i] = state.sortedFiles(i);
+        for (const auto& sstableFileName : levelFileNames[i]) {
+            fs::path sstablePath = dbPath / sstableFileName;
+            if (!fs::exists(sstablePath)) {
+                throw std::runtime_error("LSMTree::loadState() SSTable file does not exist: " + sstablePath.string());
+            }
+            paths.push_back(sstablePath.string());
+        }
+    }
+    std::vector<std::shared_ptr<DiskBTree>> opened = openSSTs(paths);
+
+    levels.assign(levelFileNames.size(), nullptr);
+    levelMaxSizes = state.levelCapacities;
+    size_t next = 0;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        std::vector<std::shared_ptr<DiskBTree>> ssts;
+        std::vector<KeyValueWrapper> smallestKeys;
+        for (const auto& sstableFileName : levelFileNames[i]) {
+            ssts.push_back(opened[next++]);
+            smallestKeys.push_back(state.levelFiles[i].at(sstableFileName));
+        }
+        // No SSTable at this level if the list is empty
+        levels[i] = ssts.empty() ? nullptr : std::make_shared<SortedRun>(std::move(ssts), std::move(smallestKeys));
+    }
+    removeUnreferencedSSTs(state);
+    manifestState = std::move(state);
+}
+
+// Each open reads the SST's metadata page and filter region; with many SSTs these reads
+// dominate opening the database, so they are spread over up to MAX_OPEN_THREADS threads
+std::vector<std::shared_ptr<DiskBTree>> LSMTree::openSSTs(const std::vector<std::string>& paths) {
+    std::vector<std::shared_ptr<DiskBTree>> ssts(paths.size());
+    size_t numThreads = std::min<size_t>({MAX_OPEN_THREADS, std::max(1u, std::thread::hardware_concurrency()),
+                                          paths.size() / MIN_SSTS_PER_OPEN_THREAD});
+    std::atomic<size_t> nextIndex{0};
+    auto openNext = [&]() {
+        for (size_t i = nextIndex++; i < paths.size(); i = nextIndex++) {
+            ssts[i] = std::make_shared<DiskBTree>(paths[i]);
+        }
+    };
+
+    if (numThreads <= 1) {
+        openNext();
+    } else {
+        // This thread opens SSTs too; errors are rethrown once every thread is joined
+        std::vector<std::exception_ptr> errors(numThreads);
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < numThreads; ++t) {
+            workers.emplace_back([&, t]() {
+                try {
+                    openNext();
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+        try {
+            openNext();
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    for (const auto& sst : ssts) {
+        configureSST(sst);
+    }
+    return ssts;
+}
+
+// SSTs written by a flush or compaction that did not reach the manifest, and replaced SSTs
+// not deleted yet
+void LSMTree::removeUnreferencedSSTs(const ManifestState& state) {
+    std::vector<fs::path> unreferenced;
+    for (const auto& entry : fs::directory_iterator(dbPath)) {
+        std::string fileName = entry.path().filename().string();
+        if (!entry.is_regular_file() || entry.path().extension() != ".sst"
+            || fileName[0] != 'L' || fileName.find("_SSTable_") == std::string::npos) {
+            continue;
+        }
+        bool referenced = std::any_of(state.levelFiles.begin(), state.levelFiles.end(),
+                                      [&fileName](const auto& files) { return files.count(fileName) > 0; });
+        if (!referenced) {
+            unreferenced.push_back(entry.path());
+        }
+    }
+    for (const auto& path : unreferenced) {
+        fs::remove(path);
+    }
+}
+
+// manifest.lsm written by versions before the manifest log, rewritten in full on every
+// change and holding one SST per level:
+//
+//   size_t numLevels | per level: int level | size_t length | SST file name (0 = none)
+//                                | size_t capacity
+//
+// It has no version marker, so anything else (including the unreleased layouts with
+// several SSTs per level or sequence numbers) is rejected instead of being misread.
+void LSMTree::loadLegacyManifest() {
     std::ifstream ifs(lsmFilePath, std::ios::binary);
     if (!ifs) {
         throw std::runtime_error("LSMTree::loadState() Failed to open LSM tree file for reading");
     }
+    auto unknownFormat = [this]() {
+        return std::runtime_error("LSMTree::loadState() " + lsmFilePath.string()
+                                  + " is not in the manifest.lsm format of earlier versions; cannot open it");
+    };
+    auto read = [&ifs, &unknownFormat](void* bytes, size_t size) {
+        if (!ifs.read(static_cast<char*>(bytes), static_cast<std::streamsize>(size))) {
+            throw unknownFormat();
+        }
+    };
 
     // Read the number of levels (excluding memtable)
     size_t numLevels;
-    ifs.read(reinterpret_cast<char*>(&numLevels), sizeof(numLevels));
-
-    levels.resize(numLevels);
-    levelMaxSizes.resize(numLevels);
+    read(&numLevels, sizeof(numLevels));
+    if (numLevels > MAX_LEGACY_LEVELS) {
+        throw unknownFormat();
+    }
 
-    // Read the SSTable information for each level
+    std::vector<std::string> fileNames(numLevels);
+    std::vector<size_t> capacities(numLevels);
     for (size_t i = 0; i < numLevels; ++i) {
         // Read the level number
         int levelNumber;
-        ifs.read(reinterpret_cast<char*>(&levelNumber), sizeof(levelNumber));
-
-        // Read the SSTable file name
+        read(&levelNumber, sizeof(levelNumber));
         size_t fileNameLength;
-        ifs.read(reinterpret_cast<char*>(&fileNameLength), sizeof(fileNameLength));
-
+        read(&fileNameLength, sizeof(fileNameLength));
+        if (levelNumber != static_cast<int>(i + 1) || fileNameLength > MAX_LEGACY_FILE_NAME_LENGTH) {
+            throw unknownFormat();
+        }
+        fileNames[i].resize(fileNameLength);
         if (fileNameLength > 0) {
-            std::string sstableFileName(fileNameLength, '\0');
-            ifs.read(&sstableFileName[0], fileNameLength);
-
-            // Construct full path to the SSTable file
-            fs::path sstablePath = dbPath / sstableFileName;
-
-            // Verify that the SSTable file exists
-            if (!fs::exists(sstablePath)) {
-                throw std::runtime_error("LSMTree::loadState() SSTable file does not exist: " + sstablePath.string());
+            read(&fileNames[i][0], fileNameLength);
+            if (fs::path(fileNames[i]).extension() != ".sst" || fs::path(fileNames[i]).has_parent_path()) {
+                throw unknownFormat();
             }
+        }
+        read(&capacities[i], sizeof(capacities[i]));
+    }
+    if (ifs.peek() != std::ifstream::traits_type::eof()) {
+        throw unknownFormat();
+    }
+    ifs.close();
 
-            // Create a new DiskBTree instance with the SSTable file
-            levels[i] = std::make_shared<DiskBTree>(sstablePath.string());
-        } else {
+    levels.assign(numLevels, nullptr);
+    levelMaxSizes = capacities;
+    for (size_t i = 0; i < numLevels; ++i) {
+        if (fileNames[i].empty()) {
             // No SSTable at this level
-            levels[i] = nullptr;
+            continue;
         }
+        // Construct full path to the SSTable file
+        fs::path sstablePath = dbPath / fileNames[i];
 
-        // Read the level capacity
-        size_t levelCapacity;
-        ifs.read(reinterpret_cast<char*>(&levelCapacity), sizeof(levelCapacity));
-        levelMaxSizes[i] = levelCapacity;
+        // Verify that the SSTable file exists
+        if (!fs::exists(sstablePath)) {
+            throw std::runtime_error("LSMTree::loadState() SSTable file does not exist: " + sstablePath.string());
+        }
+        auto sst = std::make_shared<DiskBTree>(sstablePath.string());
+        configureSST(sst);
+        levels[i] = std::make_shared<SortedRun>(std::vector<std::shared_ptr<DiskBTree>>{sst});
     }
-
-    ifs.close();
+    // Those versions had no WAL and no sequence numbers
+    flushedSequenceNumber = 0;
 }
 
 
@@ -165,8 +340,95 @@ size_t LSMTree::getNumLevels() const {
 
 // Set the database path
 void LSMTree::setDBPath(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
     dbPath = path;
+    manifestLogPath = dbPath / "manifest.log";
     lsmFilePath = dbPath / "manifest.lsm";
+    if (!fs::exists(dbPath)) {
+        fs::create_directories(dbPath);
+    }
+
+    // The levels come from this database's manifest, the memtable from its WAL
+    levels.clear();
+    levelMaxSizes.clear();
+    flushedSequenceNumber = 0;
+    manifestLog.reset();
+    manifestState = ManifestState();
+    nextFileNumber = 0;
+    obsoleteFiles.clear();
+    if (hasManifest()) {
+        loadManifest();
+    }
+    memtable = std::make_unique<Memtable>(memtable->getThreshold());
+    openWAL();
+}
+
+// Replay the WAL into the memtable, then keep it open for new writes
+void LSMTree::openWAL() {
+    shared->wal.reset();
+    fs::path walPath = dbPath / "wal.log";
+    WAL::replay(walPath.string(), [this](const WriteBatch& batch) { replayBatch(batch); });
+    shared->wal = std::make_shared<WAL>(walPath.string());
+
+    if (memtable->getCurrentSize() > 0 && memtable->getCurrentSize() >= memtable->getThreshold()) {
+        flushMemtableToLevel1();
+    }
+}
+
+void LSMTree::replayBatch(const WriteBatch& batch) {
+    if (batch.Count() == 0) {
+        return;
+    }
+    uint64_t last = batch.getSequence() + batch.Count() - 1;
+    shared->lastSequenceNumber = std::max(shared->lastSequenceNumber.load(), last);
+    if (last <= flushedSequenceNumber) {
+        return;
+    }
+    // Operands the operator rejects (written before it was checked, or under another
+    // operator) are dropped, so that the database still opens
+    batch.forEach([this](KeyValueWrapper& kv) {
+                      try {
+                          applyToMemtable(kv);
+                      } catch (const std::invalid_argument& e) {
+                          std::cerr << "Dropping merge operand of sequence number " << kv.sequenceNumber
+                                    << " from the WAL: " << e.what() << std::endl;
+                      }
+                  },
+                  [this](RangeTombstone& tombstone) { memtable->addRangeTombstone(tombstone); },
+                  columnFamily.getId());
+}
+
+void LSMTree::recover(const WriteBatch& batch) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    replayBatch(batch);
+    if (memtable->getCurrentSize() > 0 && memtable->getCurrentSize() >= memtable->getThreshold()) {
+        flushMemtableToLevel1();
+    }
+}
+
+std::shared_ptr<ColumnFamilyShared> LSMTree::shareWithColumnFamilies(std::shared_ptr<BufferPool> blockCache) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    sharesWAL = true;
+    if (!shared->blockCache) {
+        shared->blockCache = std::move(blockCache);
+        for (const auto& sst : liveSSTs()) {
+            configureSST(sst);
+        }
+    }
+    return shared;
+}
+
+void LSMTree::flush() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (memtable->getCurrentSize() > 0 || !memtable->getRangeTombstones().empty()) {
+        flushMemtableToLevel1();
+    }
+}
+
+uint64_t LSMTree::allocateSequenceNumbers(size_t count) {
+    // A counter, not the clock: versions stay ordered when writes share a microsecond
+    // or the wall clock steps back
+    return shared->lastSequenceNumber.fetch_add(count) + 1;
 }
 
 // Get the database path
@@ -176,179 +438,433 @@ std::string LSMTree::getDBPath() const {
 
 // Insert a key-value pair into the LSM tree
 void LSMTree::put(const KeyValueWrapper& kv) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    KeyValueWrapper entry(kv);
+    entry.sequenceNumber = allocateSequenceNumbers(1);
+    if (!entry.isTombstone() && entry.expiresAt == 0) {
+        entry.expiresAt = defaultExpiryTime();
+    }
+
+    // Log before applying
+    WriteBatch record;
+    if (entry.isTombstone()) {
+        record.Delete(columnFamily, entry);
+    } else {
+        record.Put(columnFamily, entry);
+    }
+    record.setSequence(entry.sequenceNumber);
+    shared->wal->append(record);
+
     // Insert into the memtable
-    memtable->put(kv);
+    memtable->put(entry);
 
     // Check if the memtable needs to be flushed
-    if (memtable->getCurrentSize() == memtable->getThreshold()) {
+    if (memtable->getCurrentSize() >= memtable->getThreshold()) {
         // cout << "LSMTree::put() --> flush to L1" << endl;
         flushMemtableToLevel1();
     }
 }
 
+// Apply a batch atomically
+void LSMTree::write(WriteBatch& batch) {
+    if (batch.Count() == 0) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (uint32_t id : batch.ColumnFamilyIds()) {
+        if (id != columnFamily.getId()) {
+            throw std::invalid_argument("LSMTree::write() Batch holds records of column family "
+                                        + std::to_string(id) + ", not of this tree");
+        }
+    }
+    prepareWrite(batch);
+    batch.setSequence(allocateSequenceNumbers(batch.Count()));
+    shared->wal->append(batch);
+    applyWrite(batch);
+}
+
+void LSMTree::prepareWrite(WriteBatch& batch) const {
+    if (batch.HasMerge(columnFamily.getId())) {
+        checkMergeOperands(batch); // throws before anything is logged
+    }
+    if (defaultTTLSeconds > 0) {
+        batch.SetDefaultExpiry(defaultExpiryTime(), columnFamily.getId());
+    }
+}
+
+void LSMTree::applyWrite(const WriteBatch& batch) {
+    batch.forEach([this](KeyValueWrapper& kv) { applyToMemtable(kv); },
+                  [this](RangeTombstone& tombstone) { memtable->addRangeTombstone(tombstone); },
+                  columnFamily.getId());
+
+    // The whole batch stays in one memtable, so flush only after applying it
+    if (memtable->getCurrentSize() >= memtable->getThreshold()) {
+        flushMemtableToLevel1();
+    }
+}
+
+void LSMTree::deleteRange(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey) {
+    WriteBatch batch;
+    batch.DeleteRange(columnFamily, startKey, endKey);
+    write(batch);
+}
+
+void LSMTree::merge(const KeyValueWrapper& operand) {
+    WriteBatch batch;
+    batch.Merge(columnFamily, operand);
+    write(batch);
+}
+
+void LSMTree::setMergeOperator(std::shared_ptr<const MergeOperator> op) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    mergeOperator = std::move(op);
+}
+
+const MergeOperator& LSMTree::requireMergeOperator() const {
+    if (!mergeOperator) {
+        throw std::runtime_error("LSMTree: merge operands need a merge operator, none is set");
+    }
+    return *mergeOperator;
+}
+
+void LSMTree::checkMergeOperands(const WriteBatch& batch) const {
+    const MergeOperator& op = requireMergeOperator();
+    // Numbered after everything in the memtable, as the batch will be
+    WriteBatch trial(batch);
+    trial.setSequence(shared->lastSequenceNumber.load() + 1);
+    std::map<KeyValueWrapper, KeyValueWrapper> entries; // the batch's writes so far, by key
+    RangeTombstoneList batchRangeTombstones;
+    trial.forEach([&](KeyValueWrapper& kv) {
+                      if (kv.isMergeOperand()) {
+                          auto it = entries.find(kv);
+                          uint64_t rangeDeletedUpTo = std::max(memtable->getRangeTombstones().maxCoveringSequence(kv),
+                                                               batchRangeTombstones.maxCoveringSequence(kv));
+                          kv = Memtable::foldOperand(it != entries.end() ? it->second : memtable->get(kv), kv,
+                                                     rangeDeletedUpTo, op);
+                      }
+                      entries[kv] = kv;
+                  },
+                  [&](RangeTombstone& tombstone) { batchRangeTombstones.add(tombstone); },
+                  columnFamily.getId());
+}
+
+void LSMTree::applyToMemtable(const KeyValueWrapper& kv) {
+    if (kv.isMergeOperand()) {
+        memtable->merge(kv, requireMergeOperator());
+    } else {
+        memtable->put(kv);
+    }
+}
+
 // Search for a key-value pair in the LSM tree
 KeyValueWrapper LSMTree::get(const KeyValueWrapper& kv) {
-    // First, search in the memtable
-    KeyValueWrapper result = memtable->get(kv);
-    if (!result.isEmpty()) {
-        if (!result.isTombstone()) {
-            // Found and not deleted
-            return result;
-        } else {
-            // Key is deleted
-            return KeyValueWrapper(); // Return default (not found)
-        }
-    }
-    // std::cout << "LSMTree::get(), Not found in memtable, now try to find in disk" << std::endl;
-    // Not found in memtable, search in SSTables from Level 1 upwards
-    for (size_t levelIndex = 0; levelIndex < levels.size(); ++levelIndex) {
-        // std::cout << "LSMTree::get(), levelIndex = " << levelIndex << std::endl;
-        std::shared_ptr<DiskBTree> sst = levels[levelIndex];
-        if (sst != nullptr) {
-            KeyValueWrapper* kvPtr = sst->search(kv);
-            if (kvPtr && !kvPtr->isEmpty()) {
-                if (!kvPtr->isTombstone()) {
-                    // Found and not deleted
-                    return *kvPtr;
-                } else {
-                    // Key is deleted
-                    return KeyValueWrapper(); // Return default (not found)
-                }
-            }
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    // First the memtable, then SSTables from Level 1 upwards
+    return getFromLevels(kv, memtable->get(kv), memtable->getRangeTombstones(), levels);
+}
+
+KeyValueWrapper LSMTree::get(const KeyValueWrapper& kv, const Snapshot& snapshot) {
+    // No lock: the snapshot's memtable is copied before a write changes it, and flushes and
+    // compactions never modify an SST once written (moving a run between levels opens new
+    // handles), so the SSTs the snapshot holds stay readable
+    return getFromLevels(kv, snapshot.memtable->getValue(kv), snapshot.memtableRangeTombstones, snapshot.levels);
+}
+
+KeyValueWrapper LSMTree::getFromLevels(const KeyValueWrapper& kv, const KeyValueWrapper& memtableEntry,
+                                       const RangeTombstoneList& memtableRangeTombstones,
+                                       const std::vector<std::shared_ptr<SortedRun>>& levels) const {
+    uint64_t rangeDeletedUpTo = memtableRangeTombstones.maxCoveringSequence(kv);
+    const uint64_t now = KeyValueWrapper::currentTimeMillis();
+    std::vector<KeyValueWrapper> operands; // newest first
+    KeyValueWrapper base;
+
+    // True once found settles the key: it is a value, or deleted by a tombstone, a range
+    // tombstone or its expiry. A merge operand needs the versions below it.
+    auto settle = [&](const KeyValueWrapper* found) {
+        if (found == nullptr) {
+            // Everything in older sources is below the range tombstone
+            return rangeDeletedUpTo > 0;
+        }
+        if (found->isTombstone() || rangeDeletedUpTo > found->sequenceNumber || found->isExpired(now)) {
+            return true;
+        }
+        if (found->isMergeOperand()) {
+            operands.push_back(*found);
+            return false;
+        }
+        base = *found;
+        return true;
+    };
+
+    bool settled = settle(memtableEntry.isEmpty() ? nullptr : &memtableEntry);
+    for (size_t levelIndex = 0; levelIndex < levels.size() && !settled; ++levelIndex) {
+        std::shared_ptr<SortedRun> run = levels[levelIndex];
+        if (run != nullptr) {
+            rangeDeletedUpTo = std::max(rangeDeletedUpTo, run->getRangeTombstones().maxCoveringSequence(kv));
+            std::unique_ptr<KeyValueWrapper> kvPtr(run->search(kv));
+            settled = settle(kvPtr && !kvPtr->isEmpty() ? kvPtr.get() : nullptr);
         }
     }
 
-    // Not found in any level
-    return KeyValueWrapper(); // Return default (empty) KeyValueWrapper
+    if (operands.empty()) {
+        // The newest value, or empty if not found or deleted
+        return base;
+    }
+    return requireMergeOperator().fold(base.isEmpty() ? nullptr : &base, operands);
 }
 
-// In LSMTree.cpp
+std::shared_ptr<const Snapshot> LSMTree::getSnapshot() {
+    // Pinning marks the memtable, so writers must be excluded
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->memtable = memtable->pin();
+    snapshot->memtableRangeTombstones = memtable->getRangeTombstones();
+    snapshot->levels = levels;
+    return snapshot;
+}
 
-void LSMTree::scan(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey, std::vector<KeyValueWrapper>& result) {
-    // Temporary storage for results from each level
-    std::vector<std::vector<KeyValueWrapper>> levelResults;
+std::vector<KeyValueWrapper> LSMTree::multiGet(const std::vector<KeyValueWrapper>& keys) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<KeyValueWrapper> results(keys.size());
 
-    // Scan the memtable
-    std::vector<KeyValueWrapper> memtableResults;
-    std::set<KeyValueWrapper> memtableKeys;
-    memtable->scan(startKey, endKey, memtableKeys);
-    for (auto& kv : memtableKeys) {
-        memtableResults.push_back(kv);
+    // Sort the requested keys and group duplicates
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    std::vector<KeyValueWrapper> sortedKeys;
+    std::vector<std::vector<size_t>> requesters; // positions in keys asking for sortedKeys[j]
+    for (size_t i : order) {
+        if (sortedKeys.empty() || sortedKeys.back() != keys[i]) {
+            sortedKeys.push_back(keys[i]);
+            requesters.emplace_back();
+        }
+        requesters.back().push_back(i);
     }
-    levelResults.push_back(memtableResults);
 
-    // For each level from Level 1 upwards
-    for (size_t levelIndex = 0; levelIndex < levels.size(); ++levelIndex) {
-        std::shared_ptr<DiskBTree> sst = levels[levelIndex];
-        if (sst) {
-            std::vector<KeyValueWrapper> sstResults;
-            sst->scan(startKey, endKey, sstResults);
-            levelResults.push_back(sstResults);
+    // Keys still unresolved, as indices into sortedKeys (kept sorted). A key covered by a
+    // range tombstone is resolved by the source holding it: older sources cannot answer it.
+    std::vector<size_t> pending;
+    std::vector<size_t> needMerge; // operands found: folded by a full lookup at the end
+    const uint64_t now = KeyValueWrapper::currentTimeMillis();
+    auto resolve = [&](size_t j, const KeyValueWrapper& found, uint64_t rangeDeletedUpTo) {
+        if (rangeDeletedUpTo > found.sequenceNumber || found.isExpired(now)) {
+            return;
+        }
+        if (found.isMergeOperand()) {
+            needMerge.push_back(j);
+        } else if (!found.isTombstone()) {
+            for (size_t i : requesters[j]) {
+                results[i] = found;
+            }
+        }
+    };
+
+    // Memtable first
+    for (size_t j = 0; j < sortedKeys.size(); ++j) {
+        KeyValueWrapper found = memtable->get(sortedKeys[j]);
+        uint64_t rangeDeletedUpTo = memtable->getRangeTombstones().maxCoveringSequence(sortedKeys[j]);
+        if (!found.isEmpty()) {
+            resolve(j, found, rangeDeletedUpTo);
+        } else if (rangeDeletedUpTo == 0) {
+            pending.push_back(j);
         }
     }
 
-    // Initialize a min-heap to merge the sorted sequences
-    struct HeapNode {
-        KeyValueWrapper kv;
-        size_t levelIndex;
-        size_t vectorIndex;
+    // Then each level, newest first, with all keys not resolved by a newer level
+    for (size_t levelIndex = 0; levelIndex < levels.size() && !pending.empty(); ++levelIndex) {
+        std::shared_ptr<SortedRun> run = levels[levelIndex];
+        if (run == nullptr) {
+            continue;
+        }
+        std::vector<KeyValueWrapper> levelKeys;
+        levelKeys.reserve(pending.size());
+        for (size_t j : pending) {
+            levelKeys.push_back(sortedKeys[j]);
+        }
+        std::vector<KeyValueWrapper> found;
+        run->multiSearch(levelKeys, found);
+
+        std::vector<size_t> stillPending;
+        for (size_t p = 0; p < pending.size(); ++p) {
+            uint64_t rangeDeletedUpTo = run->getRangeTombstones().maxCoveringSequence(levelKeys[p]);
+            if (!found[p].isEmpty()) {
+                resolve(pending[p], found[p], rangeDeletedUpTo);
+            } else if (rangeDeletedUpTo == 0) {
+                stillPending.push_back(pending[p]);
+            }
+        }
+        pending.swap(stillPending);
+    }
 
-        // Define comparison operator for min-heap
-        bool operator>(const HeapNode& other) const {
-            return kv > other.kv;
+    for (size_t j : needMerge) {
+        KeyValueWrapper found = getFromLevels(sortedKeys[j], memtable->get(sortedKeys[j]),
+                                              memtable->getRangeTombstones(), levels);
+        for (size_t i : requesters[j]) {
+            results[i] = found;
         }
-    };
+    }
+    return results;
+}
 
-    std::priority_queue<HeapNode, std::vector<HeapNode>, std::greater<HeapNode>> minHeap;
+// In LSMTree.cpp
 
-    // Initialize indices for each level
-    std::vector<size_t> indices(levelResults.size(), 0);
+void LSMTree::scan(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey, std::vector<KeyValueWrapper>& result,
+                   const ScanOptions& options) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    scanSSTs(startKey, endKey, readSSTs(options.snapshot), result, options);
+}
 
-    // Push the first element from each level into the heap
-    for (size_t i = 0; i < levelResults.size(); ++i) {
-        if (!levelResults[i].empty()) {
-            HeapNode node{levelResults[i][0], i, 0};
-            minHeap.push(node);
+void LSMTree::scanPrefix(const std::string& prefix, std::vector<KeyValueWrapper>& result,
+                         const ScanOptions& options) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    // Skip SSTs whose prefix filter rules the prefix out
+    std::vector<std::shared_ptr<DiskBTree>> candidates;
+    for (const auto& sst : readSSTs(options.snapshot)) {
+        if (sst->mayContainPrefix(prefix)) {
+            candidates.push_back(sst);
+        } else {
+            prefixFilterSkips++;
         }
     }
 
-    KeyValueWrapper currentKey;
-    KeyValueWrapper currentKV;
-    bool hasCurrentKV = false;
+    // Keys starting with prefix are exactly [prefix, prefix + 0xff...] since no key exceeds a page
+    KeyValueWrapper startKey(prefix, "");
+    KeyValueWrapper endKey(prefix + std::string(4096, '\xff'), "");
+    scanSSTs(startKey, endKey, candidates, result, options);
+}
 
-    while (!minHeap.empty()) {
-        HeapNode node = minHeap.top();
-        minHeap.pop();
+void LSMTree::scanSSTs(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey,
+                       const std::vector<std::shared_ptr<DiskBTree>>& ssts, std::vector<KeyValueWrapper>& result,
+                       const ScanOptions& options) {
+    // Stream the merged levels; only the current entry of each level is held in memory,
+    // and reading stops once the limit is reached
+    std::unique_ptr<DBIterator> it = newIterator(ssts, options.snapshot);
+    auto belowLimit = [&]() { return options.limit == 0 || result.size() < options.limit; };
+    if (options.reverse) {
+        for (it->SeekForPrev(endKey); it->Valid() && it->entry() >= startKey && belowLimit(); it->Prev()) {
+            result.push_back(it->entry());
+        }
+    } else {
+        for (it->Seek(startKey); it->Valid() && it->entry() <= endKey && belowLimit(); it->Next()) {
+            result.push_back(it->entry());
+        }
+    }
+}
 
-        KeyValueWrapper key = node.kv;
+std::unique_ptr<DBIterator> LSMTree::newIterator(const std::shared_ptr<const Snapshot>& snapshot) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return newIterator(readSSTs(snapshot), snapshot);
+}
 
-        if (!hasCurrentKV || key != currentKey) {
-            // New key encountered
-            if (hasCurrentKV && !currentKV.isTombstone()) {
-                // Add the previous key-value to the result
-                result.push_back(currentKV);
-            }
-            currentKey = key;
-            currentKV = node.kv;
-            hasCurrentKV = true;
-        } else {
-            // Same key, keep the one with the highest sequence number
-            if (node.kv.sequenceNumber > currentKV.sequenceNumber) {
-                currentKV = node.kv;
-            }
+std::unique_ptr<DBIterator> LSMTree::newIterator(const std::vector<std::shared_ptr<DiskBTree>>& ssts,
+                                                 const std::shared_ptr<const Snapshot>& snapshot) {
+    // Newest source first: the memtable, then SSTs from Level 1 upwards
+    std::vector<std::unique_ptr<Iterator>> children;
+    if (snapshot) {
+        children.push_back(std::make_unique<MemtableIterator>(snapshot->memtable));
+    } else {
+        children.push_back(memtable->newIterator());
+    }
+    for (const auto& sst : ssts) {
+        if (sst) {
+            children.push_back(std::make_unique<DiskBTreeIterator>(sst));
         }
+    }
+    return std::make_unique<DBIterator>(std::move(children), collectRangeTombstones(snapshot), mergeOperator);
+}
 
-        // Move to the next element in the same level
-        indices[node.levelIndex]++;
-        if (indices[node.levelIndex] < levelResults[node.levelIndex].size()) {
-            HeapNode nextNode{
-                levelResults[node.levelIndex][indices[node.levelIndex]],
-                node.levelIndex,
-                indices[node.levelIndex]
-            };
-            minHeap.push(nextNode);
+RangeTombstoneList LSMTree::collectRangeTombstones(const std::shared_ptr<const Snapshot>& snapshot) const {
+    RangeTombstoneList rangeTombstones = snapshot ? snapshot->memtableRangeTombstones : memtable->getRangeTombstones();
+    for (const auto& run : snapshot ? snapshot->levels : levels) {
+        if (run) {
+            rangeTombstones.add(run->getRangeTombstones());
         }
     }
+    return rangeTombstones;
+}
 
-    // After processing all nodes, check if there's a remaining key
-    if (hasCurrentKV && !currentKV.isTombstone()) {
-        result.push_back(currentKV);
+// SSTs of one level never share a key, so their order within the level does not matter
+std::vector<std::shared_ptr<DiskBTree>> LSMTree::liveSSTs() const {
+    return flattenLevels(levels);
+}
+
+std::vector<std::shared_ptr<DiskBTree>> LSMTree::readSSTs(const std::shared_ptr<const Snapshot>& snapshot) const {
+    return snapshot ? flattenLevels(snapshot->levels) : flattenLevels(levels);
+}
+
+std::vector<std::shared_ptr<DiskBTree>> LSMTree::flattenLevels(const std::vector<std::shared_ptr<SortedRun>>& levels) {
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+    for (const auto& run : levels) {
+        if (run) {
+            ssts.insert(ssts.end(), run->getSSTs().begin(), run->getSSTs().end());
+        }
     }
+    return ssts;
 }
 
 
 
 // Handle flushing memtable to Level 1
 void LSMTree::flushMemtableToLevel1() {
-    // Get all key-value pairs from the memtable
-    std::vector<KeyValueWrapper> kvPairs = memtable->flush();
-
-    // Create a new SSTable (DiskBTree) from the kvPairs
     // Generate a unique SSTable file name
     std::string sstableFileName = generateSSTableFileName(1); // Level 1
     fs::path sstablePath = dbPath / sstableFileName;
 
-    // Create a new DiskBTree with the kvPairs
-    // cout << "LSMTree::flushMemtableToLevel1() -- Create a new DiskBTree with the kvPairs" << endl;
-    std::shared_ptr<DiskBTree> newSSTable = std::make_shared<DiskBTree>(sstablePath.string(), kvPairs);
+    // Stream the memtable in key order into the new SSTable; only the pages being
+    // filled are held in memory
+    SSTBuilder builder(sstablePath.string(), getBuildOptionsForLevel(1));
+    const RangeTombstoneList& rangeTombstones = memtable->getRangeTombstones();
+    const uint64_t now = KeyValueWrapper::currentTimeMillis();
+    std::unique_ptr<Iterator> it = memtable->newIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        // Entries deleted by a later DeleteRange are not written at all; expired ones
+        // become tombstones, older versions may lie below
+        if (rangeTombstones.covers(it->entry())) {
+            continue;
+        }
+        if (it->entry().isExpired(now)) {
+            builder.add(expiredToTombstone(it->entry()));
+        } else {
+            builder.add(it->entry());
+        }
+    }
+    builder.addRangeTombstones(rangeTombstones);
+    builder.finish();
+    memtable->clear();
+
+    std::shared_ptr<DiskBTree> newSSTable = std::make_shared<DiskBTree>(sstablePath.string());
+    configureSST(newSSTable);
+    auto newRun = std::make_shared<SortedRun>(std::vector<std::shared_ptr<DiskBTree>>{newSSTable});
     // cout << "finished creating new sst file" << endl;
 
     // Initialize Level 1 capacity if not already done
     if (levelMaxSizes.empty()) {
         // Level 1 capacity is the memtable threshold (e.g., 1000 pairs)
         levelMaxSizes.push_back(memtable->getThreshold());
-        levels.push_back(newSSTable);
-        return;
+        levels.push_back(newRun);
+    } else {
+        // Merge the new SSTable into Level 1
+        // cout << "LSMTree::flushMemtableToLevel1() -- Merge check" << endl;
+        mergeLevels(1, newRun);
+    }
+    compactExpiredSSTs();
+    compactTombstoneDenseLevels();
+
+    // The flushed writes are now reachable from the manifest; drop them from the WAL
+    // unless other column families still need it (the database rolls it instead)
+    flushedSequenceNumber = shared->lastSequenceNumber.load();
+    writeManifest();
+    if (shared->wal && !sharesWAL) {
+        shared->wal->reset();
     }
-
-    // Merge the new SSTable into Level 1
-    // cout << "LSMTree::flushMemtableToLevel1() -- Merge check" << endl;
-    mergeLevels(1, newSSTable);
 }
 
 
 // Merge SSTables when a level exceeds its capacity
-void LSMTree::mergeLevels(int levelIndex, const std::shared_ptr<DiskBTree>& sstToMerge) {
+void LSMTree::mergeLevels(int levelIndex, const std::shared_ptr<SortedRun>& runToMerge) {
     // cout << "LSMTree::mergeLevels(): Currently merge level " << levelIndex << endl;
     int index = levelIndex - 1; // Adjust for 0-based indexing
 
@@ -361,278 +877,474 @@ void LSMTree::mergeLevels(int levelIndex, const std::shared_ptr<DiskBTree>& sstT
     // Ensure levels vector is large enough
     if (levels.size() <= static_cast<size_t>(index)) {
         levels.resize(index + 1, nullptr);
-        // update file info
-        std::string newLevelSstName = generateSSTableFileName(levelIndex);
-        fs::path oldSstPath = sstToMerge->getFileName();
-        fs::path newSstPath = dbPath / newLevelSstName;
-        // update actual file location
-        fs::rename(oldSstPath, newSstPath);
-        // update the logical file name
-        sstToMerge->updateSstFileName(newSstPath.string());
-
-        // cout << "LSMTree::mergeLevels():  Branch-1 new sst file:  " << sstToMerge->getSstFilename() << endl;
-        levels[index] = sstToMerge;
+        moveRunToLevel(levelIndex, runToMerge);
         return;
     }
 
-    // If the current level is empty, place the new SSTable here
-    if (levels[index] == nullptr || levels[index]->getNumberOfKeyValues() == 0) {
-        // update file info
-        std::string newLevelSstName = generateSSTableFileName(levelIndex);
-        fs::path oldSstPath = sstToMerge->getFileName();
-        fs::path newSstPath = dbPath / newLevelSstName;
-        // update actual file location
-        fs::rename(oldSstPath, newSstPath);
-        // update the logical file name
-        sstToMerge->updateSstFileName(newSstPath.string());
-
-        // cout << "LSMTree::mergeLevels(): Branch-2 new sst file:  " << sstToMerge->getSstFilename() << endl;
-        levels[index] = sstToMerge;
+    // If the current level is empty, place the new run here
+    if (levels[index] == nullptr || levels[index]->isEmpty()) {
+        moveRunToLevel(levelIndex, runToMerge);
         return;
     }
 
-    // There is an existing SSTable at this level; merge is needed
-    std::shared_ptr<DiskBTree> existingSSTable = levels[index];
-
-    // Generate a new SSTable file name for the merged SSTable
-    std::string newSSTableFileName = generateSSTableFileName(levelIndex);
-    fs::path newSSTablePath = dbPath / newSSTableFileName;
-
-    // Name for the merged leaf pages file
-    std::string mergedLeafsFileName = "merge_" + newSSTableFileName + ".leafs";
-    fs::path mergedLeafsPath = dbPath / mergedLeafsFileName;
+    // There is an existing run at this level; merge is needed
+    std::shared_ptr<SortedRun> existingRun = levels[index];
 
-    // Vector to hold the smallest keys of each leaf page
-    std::vector<KeyValueWrapper> leafPageSmallestKeys;
-    int numOfPages = 0;
-    int totalKvs = 0;
-    // Merge existing SSTable and new SSTable into mergedLeafsFileName
-    mergeSSTables(existingSSTable, sstToMerge, mergedLeafsPath.string(), leafPageSmallestKeys, numOfPages, totalKvs);
+    // Merge existing run and new run into new SSTables
+    std::shared_ptr<SortedRun> mergedRun = compactRuns({runToMerge, existingRun}, levelIndex);
 
-    // Create a new DiskBTree instance for the merged SSTable using the provided constructor
-    // cout << "LSMTree::mergeLevels() newSSTablePath.string() is " << newSSTablePath.string() << endl;
-    std::shared_ptr<DiskBTree> mergedSSTable = std::make_shared<DiskBTree>(
-        newSSTablePath.string(), mergedLeafsPath.string(), leafPageSmallestKeys, numOfPages, totalKvs);
-
-
-    // cout << "=========================" << endl;
-    // mergedSSTable->printKVs();
-
-    // Delete old SSTable files and merged leaf pages file
-    fs::remove(existingSSTable->getFileName());
-    fs::remove(sstToMerge->getFileName());
-    fs::remove(mergedLeafsPath);
-
-    // Check if the merged SSTable exceeds the level capacity
-    // cout << "LSMTree::mergeLevels(): mergedSSTable->getNumberOfKeyValues() ==  " << mergedSSTable->getNumberOfKeyValues() << endl;
-    // cout << "LSMTree::mergeLevels(): levelMaxSizes of Level " << levelIndex << " == " << levelMaxSizes[index] << endl;
-    // cout << "=========================" << endl;
+    // Delete old SSTable files once the manifest no longer names them
+    for (const auto& run : {existingRun, runToMerge}) {
+        for (const auto& sst : run->getSSTs()) {
+            obsoleteFiles.push_back(sst->getFileName());
+        }
+    }
 
-    if (mergedSSTable->getNumberOfKeyValues() > levelMaxSizes[index]) {
+    // Check if the merged run exceeds the level capacity
+    if (mergedRun->getNumberOfKeyValues() > levelMaxSizes[index]) {
         // cout << "LSMTree::mergeLevels(): ready to merge to next Level" << endl;
         // Clear current level
         levels[index] = nullptr;
         // Merge up to the next level recursively
-        mergeLevels(levelIndex + 1, mergedSSTable);
+        mergeLevels(levelIndex + 1, mergedRun);
     } else {
         // Update levels
-        levels[index] = mergedSSTable;
+        levels[index] = mergedRun;
     }
-
-
-
-
 }
 
+// Snapshots and iterators may hold the run's SSTs and read them without the lock, so they
+// are left untouched: the level gets new handles on the new names, and the old handles
+// keep reading the old names until their last reference is dropped
+void LSMTree::moveRunToLevel(int levelIndex, const std::shared_ptr<SortedRun>& run) {
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+    for (const auto& sst : run->getSSTs()) {
+        // update file info
+        std::string newLevelSstName = generateSSTableFileName(levelIndex);
+        fs::path oldSstPath = sst->getFileName();
+        fs::path newSstPath = dbPath / newLevelSstName;
+        // update actual file location; the old name stays until the manifest drops it
+        fs::create_hard_link(oldSstPath, newSstPath);
+        obsoleteFiles.push_back(oldSstPath.string());
+        ssts.push_back(std::make_shared<DiskBTree>(newSstPath.string()));
+        configureSST(ssts.back());
+    }
+    levels[levelIndex - 1] = std::make_shared<SortedRun>(std::move(ssts), run->getSmallestKeys());
+}
 
-// Merge two SSTables into a new SSTable
-void LSMTree::mergeSSTables(const std::shared_ptr<DiskBTree>& sst1,
-                            const std::shared_ptr<DiskBTree>& sst2,
-                            const std::string& mergedLeafsFileName,
-                            std::vector<KeyValueWrapper>& leafPageSmallestKeys,
-                            int& numberOfPages,
-                            int& totalKvs) {
-    // Open the output file for writing leaf pages
-    PageManager outputLeafPageManager(mergedLeafsFileName);
-
-    Page metadataPage(Page::PageType::SST_METADATA);
-    outputLeafPageManager.writePage(0, metadataPage); // Reserve offset 0
-    // Initialize input PageManagers for sst1 and sst2
-    PageManager& pm1 = *(sst1->pageManager);
-    PageManager& pm2 = *(sst2->pageManager);
-
-    cout << "num of kv in sst1: " << sst1->getNumberOfKeyValues() << endl;
-    cout << "num of kv in sst2: " << sst2->getNumberOfKeyValues() << endl;
-
-
-    // Get leaf page offsets
-    uint64_t sst1LeafBegin = sst1->getLeafBeginOffset();
-    uint64_t sst1LeafEnd = sst1->getLeafEndOffset();
-    uint64_t sst2LeafBegin = sst2->getLeafBeginOffset();
-    uint64_t sst2LeafEnd = sst2->getLeafEndOffset();
 
-    // Initialize iterators over leaf pages
-    uint64_t sst1CurrentOffset = sst1LeafBegin;
-    uint64_t sst2CurrentOffset = sst2LeafBegin;
+// Merge every SST into the bottommost level in one k-way pass
+void LSMTree::compactAll() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::shared_ptr<SortedRun>> inputs;
+    for (const auto& run : levels) {
+        if (run) {
+            inputs.push_back(run); // Level 1 first, i.e. newest first
+        }
+    }
+    if (inputs.size() < 2) {
+        return;
+    }
 
-    // Buffers to hold entries from each SSTable
-    std::vector<KeyValueWrapper> buffer1;
-    std::vector<KeyValueWrapper> buffer2;
+    int levelIndex = static_cast<int>(levels.size());
+    int index = levelIndex - 1;
 
-    // Initialize output page as a pointer
-    Page* outputPage = new Page(Page::PageType::LEAF_NODE);
+    std::shared_ptr<SortedRun> mergedRun = compactRuns(inputs, levelIndex);
 
-    // Build a bloom filter for the leaf page
-    size_t m = 1024; // Number of bits in bloom filter, can be adjusted
-    size_t n = 100;  // Expected number of elements, can be adjusted
-    outputPage->buildLeafBloomFilter(m, n);
+    for (const auto& run : inputs) {
+        for (const auto& sst : run->getSSTs()) {
+            obsoleteFiles.push_back(sst->getFileName());
+        }
+    }
+    std::fill(levels.begin(), levels.end(), nullptr);
 
-    size_t estimatedPageSize = outputPage->getBaseSize(); // Base size of the page
+    if (mergedRun->getNumberOfKeyValues() > levelMaxSizes[index]) {
+        // Too large for the bottommost level, start a new one
+        mergeLevels(levelIndex + 1, mergedRun);
+    } else {
+        levels[index] = mergedRun;
+    }
+    writeManifest();
+}
 
-    size_t pageSize = outputLeafPageManager.getPageSize(); // Assuming same page size
+// Merge runs into one, on up to maxSubcompactions threads. Every subcompaction merges all
+// inputs over its own key range into its own SST; the ranges are split at fence keys of the
+// largest input, so they hold similar amounts of data, and the outputs are disjoint and
+// ordered like the ranges.
+std::shared_ptr<SortedRun> LSMTree::compactRuns(const std::vector<std::shared_ptr<SortedRun>>& inputs,
+                                                int levelIndex) {
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+    size_t totalKeys = 0;
+    const SortedRun* largest = inputs.front().get();
+    for (const auto& run : inputs) {
+        ssts.insert(ssts.end(), run->getSSTs().begin(), run->getSSTs().end());
+        totalKeys += run->getNumberOfKeyValues();
+        if (run->getNumberOfKeyValues() > largest->getNumberOfKeyValues()) {
+            largest = run.get();
+        }
+    }
 
-    // Flags to indicate if there are more pages to read
-    bool sst1HasMore = true;
-    bool sst2HasMore = true;
+    size_t numRanges = std::min(maxSubcompactions, totalKeys / MIN_SUBCOMPACTION_KEYS);
+    std::vector<KeyValueWrapper> boundaries;
+    if (numRanges > 1) {
+        boundaries = pickSubcompactionBoundaries(*largest, numRanges);
+    }
 
-    // Read the first page from sst1 if available
-    if (sst1CurrentOffset <= sst1LeafEnd) {
-        Page page1 = pm1.readPage(sst1CurrentOffset);
-        buffer1 = page1.getLeafEntries();
-        sst1CurrentOffset += pageSize; // Increment to point to the next page
-    } else {
-        sst1HasMore = false;
+    // Range i is [boundaries[i - 1], boundaries[i]), open at both ends of the key space
+    size_t numSubcompactions = boundaries.size() + 1;
+    std::vector<std::string> outputPaths;
+    for (size_t i = 0; i < numSubcompactions; ++i) {
+        outputPaths.push_back((dbPath / generateSSTableFileName(levelIndex)).string());
     }
+    SSTBuildOptions options = getBuildOptionsForLevel(levelIndex);
+    // Deletes only need to be kept while older versions may lie below
+    const bool dropTombstones = isBottommostLevel(levelIndex);
+    std::vector<std::shared_ptr<DiskBTree>> outputs(numSubcompactions);
+    std::vector<CompactionStats> subcompactionStats(numSubcompactions);
+
+    auto runSubcompaction = [&](size_t i) {
+        const KeyValueWrapper* lower = i > 0 ? &boundaries[i - 1] : nullptr;
+        const KeyValueWrapper* upper = i < boundaries.size() ? &boundaries[i] : nullptr;
+        outputs[i] = mergeSSTables(ssts, outputPaths[i], options, lower, upper, &subcompactionStats[i],
+                                   dropTombstones);
+    };
 
-    // Read the first page from sst2 if available
-    if (sst2CurrentOffset <= sst2LeafEnd) {
-        Page page2 = pm2.readPage(sst2CurrentOffset);
-        buffer2 = page2.getLeafEntries();
-        sst2CurrentOffset += pageSize; // Increment to point to the next page
+    if (numSubcompactions == 1) {
+        runSubcompaction(0);
     } else {
-        sst2HasMore = false;
+        // Range 0 runs on this thread; errors are rethrown once every thread is joined
+        std::vector<std::exception_ptr> errors(numSubcompactions);
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < numSubcompactions; ++i) {
+            workers.emplace_back([&, i]() {
+                try {
+                    runSubcompaction(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        try {
+            runSubcompaction(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                for (const auto& path : outputPaths) {
+                    fs::remove(path);
+                }
+                std::rethrow_exception(error);
+            }
+        }
     }
 
-    // Iterators over buffer1 and buffer2
-    auto it1 = buffer1.begin();
-    auto it2 = buffer2.begin();
+    for (const auto& subStats : subcompactionStats) {
+        compactionStats.numCompactions += subStats.numCompactions;
+        compactionStats.wallSeconds += subStats.wallSeconds;
+        compactionStats.readBusySeconds += subStats.readBusySeconds;
+        compactionStats.mergeBusySeconds += subStats.mergeBusySeconds;
+        compactionStats.writeBusySeconds += subStats.writeBusySeconds;
+        compactionStats.numTombstonesDropped += subStats.numTombstonesDropped;
+        compactionStats.numExpiredEntries += subStats.numExpiredEntries;
+        compactionStats.numMergeOperandsRejected += subStats.numMergeOperandsRejected;
+    }
 
-    uint64_t currentOffset = pageSize;
+    // Stitch the outputs into one run, dropping ranges left empty
+    std::vector<std::shared_ptr<DiskBTree>> runSSTs;
+    for (auto& output : outputs) {
+        if (output->getNumberOfKeyValues() == 0 && output->getRangeTombstones().empty() && numSubcompactions > 1) {
+            output->pageManager->close();
+            fs::remove(output->getFileName());
+            continue;
+        }
+        configureSST(output);
+        runSSTs.push_back(output);
+    }
+    if (runSSTs.empty()) {
+        // Every range was empty; keep one empty SST so the level stays well-formed
+        outputs.front() = std::make_shared<DiskBTree>(outputPaths.front(), std::vector<KeyValueWrapper>{}, 4096, options);
+        configureSST(outputs.front());
+        runSSTs.push_back(outputs.front());
+    }
+    return std::make_shared<SortedRun>(std::move(runSSTs));
+}
 
-    while ((it1 != buffer1.end() || sst1HasMore) || (it2 != buffer2.end() || sst2HasMore)) {
-        // Refill buffer1 if exhausted and more pages are available
-        if (it1 == buffer1.end() && sst1HasMore) {
-            if (sst1CurrentOffset <= sst1LeafEnd) {
-                Page page1 = pm1.readPage(sst1CurrentOffset);
-                buffer1 = page1.getLeafEntries();
-                it1 = buffer1.begin();
-                sst1CurrentOffset += pageSize; // Move to the next page
-            } else {
-                sst1HasMore = false;
-            }
+bool LSMTree::isBottommostLevel(int levelIndex) const {
+    for (size_t index = static_cast<size_t>(levelIndex); index < levels.size(); ++index) {
+        if (levels[index] && levels[index]->getNumberOfKeyValues() > 0) {
+            return false;
         }
+    }
+    return true;
+}
 
-        // Refill buffer2 if exhausted and more pages are available
-        if (it2 == buffer2.end() && sst2HasMore) {
-            if (sst2CurrentOffset <= sst2LeafEnd) {
-                Page page2 = pm2.readPage(sst2CurrentOffset);
-                buffer2 = page2.getLeafEntries();
-                it2 = buffer2.begin();
-                sst2CurrentOffset += pageSize; // Move to the next page
-            } else {
-                sst2HasMore = false;
-            }
+bool LSMTree::isTombstoneDense(const DiskBTree& sst) const {
+    return tombstoneCompactionRatio > 0 && sst.getNumTombstones() > 0
+           && sst.getNumTombstones() >= tombstoneCompactionRatio * sst.getNumberOfKeyValues();
+}
+
+void LSMTree::compactTombstoneDenseLevels() {
+    for (size_t index = 0; index < levels.size(); ++index) {
+        std::shared_ptr<SortedRun> run = levels[index];
+        if (!run || std::none_of(run->getSSTs().begin(), run->getSSTs().end(),
+                                 [this](const auto& sst) { return isTombstoneDense(*sst); })) {
+            continue;
+        }
+        int levelIndex = static_cast<int>(index) + 1;
+        if (!isBottommostLevel(levelIndex)) {
+            // Push the level down; the tombstones keep moving until they reach the bottom
+            levels[index] = nullptr;
+            mergeLevels(levelIndex + 1, run);
+            continue;
         }
 
-        // Decide which kv to take next
-        KeyValueWrapper nextKV;
-        bool haveNextKV = false;
+        // Nothing below can be shadowed: rewrite the dense SSTs without their tombstones
+        rewriteSSTs(index, [this](const DiskBTree& sst) { return isTombstoneDense(sst); });
+    }
+}
 
-        if (it1 != buffer1.end() && it2 != buffer2.end()) {
-            if (*it1 < *it2) {
-                nextKV = *it1;
-                ++it1;
-                haveNextKV = true;
-            } else if (*it2 < *it1) {
-                nextKV = *it2;
-                ++it2;
-                haveNextKV = true;
+bool LSMTree::rewriteSSTs(size_t index, const std::function<bool(const DiskBTree&)>& rewrite) {
+    int levelIndex = static_cast<int>(index) + 1;
+    bool rewroteAny = false;
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+    for (const auto& sst : levels[index]->getSSTs()) {
+        if (!rewrite(*sst)) {
+            ssts.push_back(sst);
+            continue;
+        }
+        rewroteAny = true;
+        std::shared_ptr<SortedRun> rewritten =
+            compactRuns({std::make_shared<SortedRun>(std::vector<std::shared_ptr<DiskBTree>>{sst})}, levelIndex);
+        obsoleteFiles.push_back(sst->getFileName());
+        for (const auto& output : rewritten->getSSTs()) {
+            if (output->getNumberOfKeyValues() > 0 || !output->getRangeTombstones().empty()) {
+                ssts.push_back(output);
             } else {
-                // Keys are equal, resolve based on sequenceNumber and tombstone
-                if (it1->sequenceNumber >= it2->sequenceNumber) {
-                    nextKV = *it1;
-                } else {
-                    nextKV = *it2;
-                }
-                ++it1;
-                ++it2;
-                haveNextKV = true;
+                output->pageManager->close();
+                fs::remove(output->getFileName());
             }
-        } else if (it1 != buffer1.end()) {
-            nextKV = *it1;
-            ++it1;
-            haveNextKV = true;
-        } else if (it2 != buffer2.end()) {
-            nextKV = *it2;
-            ++it2;
-            haveNextKV = true;
-        }
-
-        if (haveNextKV) {
-            // Estimate the size of the kv pair
-            size_t kvSize = nextKV.getSerializedSize();
-
-            if (estimatedPageSize + kvSize > pageSize) {
-                // Page size limit reached, flush current page
-                numberOfPages++;
-                // Record the smallest key in this leaf page
-                if (!outputPage->getLeafEntries().empty()) {
-                    leafPageSmallestKeys.push_back(outputPage->getLeafEntries().front());
-                }
+        }
+    }
+    levels[index] = ssts.empty() ? nullptr : std::make_shared<SortedRun>(std::move(ssts));
+    return rewroteAny;
+}
 
-                // Write outputPage to 'merge.leafs'
-                outputLeafPageManager.writePage(currentOffset, *outputPage);
-                currentOffset += pageSize;
+bool LSMTree::compactExpiredSSTs() {
+    const uint64_t now = KeyValueWrapper::currentTimeMillis();
+    auto holdsExpired = [now](const DiskBTree& sst) {
+        return sst.getEarliestExpiry() != 0 && sst.getEarliestExpiry() <= now;
+    };
+    bool rewroteAny = false;
+    for (size_t index = 0; index < levels.size(); ++index) {
+        if (levels[index] && std::any_of(levels[index]->getSSTs().begin(), levels[index]->getSSTs().end(),
+                                         [&holdsExpired](const auto& sst) { return holdsExpired(*sst); })) {
+            rewroteAny |= rewriteSSTs(index, holdsExpired);
+        }
+    }
+    return rewroteAny;
+}
 
-                // Delete current outputPage and create a new one
-                delete outputPage;
-                outputPage = new Page(Page::PageType::LEAF_NODE);
-                outputPage->buildLeafBloomFilter(m, n); // Rebuild bloom filter for the new page
-                estimatedPageSize = outputPage->getBaseSize();
-            }
+void LSMTree::compactExpired() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (compactExpiredSSTs()) {
+        writeManifest();
+    }
+}
 
-            // Add kv to outputPage
-            outputPage->addLeafEntry(nextKV);
-            totalKvs++;
-            outputPage->addToLeafBloomFilter(nextKV);
-            estimatedPageSize += kvSize;
-        }
+void LSMTree::setPeriodicCompactionSeconds(uint64_t seconds) {
+    periodicCompaction.reset();
+    if (seconds > 0) {
+        periodicCompaction = std::make_unique<PeriodicTask>("LSMTree: periodic compaction",
+                                                            std::chrono::seconds(seconds),
+                                                            [this] { compactExpired(); });
     }
+}
 
-    // Write any remaining kvs in outputPage
-    if (!outputPage->getLeafEntries().empty()) {
-        numberOfPages++;
-        // Record the smallest key in this leaf page
-        leafPageSmallestKeys.push_back(outputPage->getLeafEntries().front());
+void LSMTree::setDefaultTTL(uint64_t ttlSeconds) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    defaultTTLSeconds = ttlSeconds;
+}
 
-        // Write outputPage to 'merge.leafs'
-        // cout << "LSMTree::mergeSSTables() write page offset: " << currentOffset << endl;
-        outputLeafPageManager.writePage(currentOffset, *outputPage);
+uint64_t LSMTree::defaultExpiryTime() const {
+    return defaultTTLSeconds > 0 ? KeyValueWrapper::currentTimeMillis() + defaultTTLSeconds * 1000 : 0;
+}
+
+KeyValueWrapper LSMTree::expiredToTombstone(const KeyValueWrapper& kv) {
+    KeyValueWrapper tombstone(kv);
+    tombstone.kv.set_string_value("");
+    tombstone.kv.set_value_type(KeyValue::STRING);
+    tombstone.setTombstone(true);
+    tombstone.setMergeOperand(false);
+    tombstone.expiresAt = 0;
+    return tombstone;
+}
+
+std::vector<KeyValueWrapper> LSMTree::pickSubcompactionBoundaries(const SortedRun& run, size_t numRanges) const {
+    // Candidate split points: where each SST after the first starts, and the separators of its root
+    std::vector<KeyValueWrapper> fences(run.getSmallestKeys().begin() + 1, run.getSmallestKeys().end());
+    for (const auto& sst : run.getSSTs()) {
+        std::vector<KeyValueWrapper> sstFences = sst->getFenceKeys();
+        fences.insert(fences.end(), sstFences.begin(), sstFences.end());
     }
+    std::sort(fences.begin(), fences.end());
+    fences.erase(std::unique(fences.begin(), fences.end()), fences.end());
 
-    // Clean up
-    delete outputPage;
+    // numRanges - 1 fences spread evenly over the candidates
+    std::vector<KeyValueWrapper> boundaries;
+    if (fences.empty()) {
+        return boundaries;
+    }
+    size_t numBoundaries = std::min(numRanges - 1, fences.size());
+    for (size_t i = 1; i <= numBoundaries; ++i) {
+        size_t pick = i * (fences.size() + 1) / (numBoundaries + 1) - 1;
+        if (boundaries.empty() || boundaries.back() < fences[pick]) {
+            boundaries.push_back(fences[pick]);
+        }
+    }
+    return boundaries;
+}
 
-    // Close the output PageManager
-    outputLeafPageManager.close();
+// Merge SSTables (newest first) into a new SSTable, streaming the merged entries into its builder
+std::shared_ptr<DiskBTree> LSMTree::mergeSSTables(const std::vector<std::shared_ptr<DiskBTree>>& inputs,
+                                                  const std::string& outputSSTableFileName,
+                                                  const SSTBuildOptions& options,
+                                                  const KeyValueWrapper* lowerBound,
+                                                  const KeyValueWrapper* upperBound,
+                                                  CompactionStats* stats,
+                                                  bool dropTombstones) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    // Three stages: one reader thread per input, the merge on this thread, and a writer
+    // thread serializing and writing the output pages
+    SSTBuildOptions pipelineOptions = options;
+    pipelineOptions.pipelinedWrites = true;
+    pipelineOptions.ioPriority = RateLimiter::Priority::LOW;
+    SSTBuilder builder(outputSSTableFileName, pipelineOptions);
+
+    // Entries covered by a newer range tombstone are dropped. The tombstones themselves
+    // move on to the output unless nothing lies below it; the first key range keeps them
+    // all, since a run answers range deletions from all of its SSTs.
+    RangeTombstoneList rangeTombstones;
+    for (const auto& input : inputs) {
+        rangeTombstones.add(input->getRangeTombstones());
+    }
+    if (!dropTombstones && lowerBound == nullptr) {
+        builder.addRangeTombstones(rangeTombstones);
+    }
 
-    // cout << "LSMTree::MergeSSTables(): Number of KVs after merge: " << totalKvs << endl;
+    // One prefetching iterator per input, merged by a loser tree
+    std::vector<std::unique_ptr<SSTPrefetchIterator>> inputIterators;
+    std::vector<Iterator*> handles;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        inputIterators.push_back(std::make_unique<SSTPrefetchIterator>(inputs[i], upperBound));
+        if (lowerBound) {
+            inputIterators.back()->Seek(*lowerBound);
+        } else {
+            inputIterators.back()->SeekToFirst();
+        }
+        handles.push_back(inputIterators.back().get());
+    }
+    LoserTree tree(handles);
+    tree.build();
+    size_t numTombstonesDropped = 0;
+    size_t numExpiredEntries = 0;
+    size_t numMergeOperandsRejected = 0;
+    const uint64_t now = KeyValueWrapper::currentTimeMillis();
+    std::vector<KeyValueWrapper> versions;
+
+    while (!tree.empty() && (!upperBound || tree.top() < *upperBound)) {
+        // Equal keys come out newest input first; sort them by sequence number, newest first
+        versions.clear();
+        versions.push_back(tree.top());
+        tree.input(tree.winner())->Next();
+        tree.replay();
+        while (!tree.empty() && tree.top() == versions.front()) {
+            versions.push_back(tree.top());
+            tree.input(tree.winner())->Next();
+            tree.replay();
+        }
+        std::stable_sort(versions.begin(), versions.end(), [](const KeyValueWrapper& a, const KeyValueWrapper& b) {
+            return a.sequenceNumber > b.sequenceNumber;
+        });
+        // Expired versions are deletions from here on
+        if (versions.front().isExpired(now)) {
+            numExpiredEntries++;
+        }
+        for (auto& version : versions) {
+            if (version.isExpired(now)) {
+                version = expiredToTombstone(version);
+            }
+        }
+        KeyValueWrapper nextKV = versions.front();
+        if (nextKV.isMergeOperand() && !rangeTombstones.covers(nextKV)) {
+            // Fold the operands into the value below them. Without one, the result stays
+            // an operand, unless nothing older can lie below this output.
+            size_t numOperands = 0;
+            while (numOperands < versions.size() && versions[numOperands].isMergeOperand() &&
+                   !rangeTombstones.covers(versions[numOperands])) {
+                ++numOperands;
+            }
+            const KeyValueWrapper* base = nullptr;
+            bool settled = dropTombstones;
+            if (numOperands < versions.size()) {
+                settled = true;
+                if (!versions[numOperands].isTombstone() && !rangeTombstones.covers(versions[numOperands])) {
+                    base = &versions[numOperands];
+                }
+            }
+            if (numOperands > 1 || settled) {
+                // Operands the operator rejects are dropped rather than failing the compaction
+                std::vector<KeyValueWrapper> operands(versions.begin(), versions.begin() + numOperands);
+                nextKV = requireMergeOperator().fold(base, operands, !settled, &numMergeOperandsRejected);
+            }
+            builder.add(nextKV);
+            continue;
+        }
+        if (dropTombstones && nextKV.isTombstone()) {
+            numTombstonesDropped++;
+            continue;
+        }
+        if (rangeTombstones.covers(nextKV)) {
+            continue;
+        }
+        builder.add(nextKV);
+    }
+    auto mergeEnd = Clock::now();
+    double readBusy = 0;
+    double readWait = 0;
+    for (auto& it : inputIterators) {
+        it->stop();
+        readBusy += it->getReadBusySeconds();
+        readWait += it->getConsumerWaitSeconds();
+    }
+    builder.finish();
+
+    if (stats) {
+        stats->numCompactions++;
+        stats->wallSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+        stats->readBusySeconds += readBusy;
+        stats->mergeBusySeconds += std::chrono::duration<double>(mergeEnd - start).count() - readWait
+                                   - builder.getWriteQueueWaitSeconds();
+        stats->writeBusySeconds += builder.getWriteBusySeconds();
+        stats->numTombstonesDropped += numTombstonesDropped;
+        stats->numExpiredEntries += numExpiredEntries;
+        stats->numMergeOperandsRejected += numMergeOperandsRejected;
+    }
+    return std::make_shared<DiskBTree>(outputSSTableFileName);
 }
 
 // Generate unique SSTable file names
 std::string LSMTree::generateSSTableFileName(int level) {
-    static int sstableCounter = 0;
-    return "L" + std::to_string(level) + "_SSTable_" + std::to_string(sstableCounter++) + ".sst";
+    std::string sstableFileName;
+    do {
+        sstableFileName = "L" + std::to_string(level) + "_SSTable_" + std::to_string(nextFileNumber++) + ".sst";
+    } while (fs::exists(dbPath / sstableFileName));
+    return sstableFileName;
 }
 
 // print LSM-Tree structure
@@ -655,22 +1367,251 @@ void LSMTree::printLevelSizes() const {
 
 
 void LSMTree::setBufferPoolParameters(size_t capacity, EvictionPolicy policy) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
     bufferPoolCapacity = capacity;
     bufferPoolPolicy = policy;
 
     // Update existing DiskBTrees
-    for (auto& sst : levels) {
-        if (sst == nullptr) continue;
-        sst->setBufferPoolParameters(capacity, policy);
+    for (auto& run : levels) {
+        if (run == nullptr) continue;
+        run->setBufferPoolParameters(capacity, policy);
+    }
+}
+
+void LSMTree::setIOQueueDepth(size_t depth) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    ioQueueDepth = depth == 0 ? 1 : depth;
+    for (auto& run : levels) {
+        if (run == nullptr) continue;
+        run->setIOQueueDepth(ioQueueDepth);
+    }
+}
+
+void LSMTree::setSSTReadMode(SSTReadMode mode) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    sstReadMode = mode;
+    for (auto& run : levels) {
+        if (run == nullptr) continue;
+        run->setReadMode(sstReadMode);
+    }
+}
+
+void LSMTree::setSSTBytesPerSync(size_t bytesPerSync) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    sstBytesPerSync = bytesPerSync;
+}
+
+void LSMTree::setFlushRateLimit(uint64_t bytesPerSecond) {
+    shared->rateLimiter->setBytesPerSecond(RateLimiter::Priority::HIGH, bytesPerSecond);
+}
+
+void LSMTree::setCompactionRateLimit(uint64_t bytesPerSecond) {
+    shared->rateLimiter->setBytesPerSecond(RateLimiter::Priority::LOW, bytesPerSecond);
+}
+
+void LSMTree::setMaxSubcompactions(size_t n) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    maxSubcompactions = n == 0 ? 1 : n;
+}
+
+size_t LSMTree::getNumSSTsInLevel(int level) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (level < 1 || static_cast<size_t>(level) > levels.size() || levels[level - 1] == nullptr) {
+        return 0;
+    }
+    return levels[level - 1]->getSSTs().size();
+}
+
+void LSMTree::setTombstoneCompactionRatio(double ratio) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    tombstoneCompactionRatio = ratio;
+}
+
+size_t LSMTree::getNumTombstonesInLevel(int level) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (level < 1 || static_cast<size_t>(level) > levels.size() || levels[level - 1] == nullptr) {
+        return 0;
+    }
+    return levels[level - 1]->getNumTombstones();
+}
+
+// Apply the per-SST read settings to a newly opened or written SST
+void LSMTree::configureSST(const std::shared_ptr<DiskBTree>& sst) const {
+    sst->setIOQueueDepth(ioQueueDepth);
+    sst->setReadMode(sstReadMode);
+    if (shared->blockCache) {
+        sst->setBufferPool(shared->blockCache);
     }
 }
 
 long long LSMTree::getTotalCacheHits() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (shared->blockCache) {
+        return shared->blockCache->getCacheHit();
+    }
     long long totalCacheHit = 0;
-    for(auto sst : levels) {
-        if (sst == nullptr) continue;
-        totalCacheHit+=sst->getCacheHit();
+    for(auto run : levels) {
+        if (run == nullptr) continue;
+        totalCacheHit+=run->getCacheHit();
     }
 
     return totalCacheHit;
-}
\ No newline at end of file
+}
+void LSMTree::setBloomFilterBitsPerKey(double bitsPerKey) {
+    if (bitsPerKey <= 0) {
+        throw std::invalid_argument("LSMTree::setBloomFilterBitsPerKey() bits per key must be greater than 0");
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    bloomBitsPerKey = bitsPerKey;
+}
+
+void LSMTree::setMonkeyFilterAllocation(bool enabled) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    monkeyFilterAllocation = enabled;
+}
+
+void LSMTree::setFilterType(SSTFilterType type) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    filterType = type;
+}
+
+void LSMTree::setPrefixExtractor(size_t prefixLength) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    prefixExtractor = PrefixExtractor(prefixLength);
+}
+
+// Capacities of levels 1..numLevels, extending the configured ones by the size ratio
+std::vector<size_t> LSMTree::projectedLevelSizes(size_t numLevels) const {
+    std::vector<size_t> sizes(levelMaxSizes.begin(), levelMaxSizes.end());
+    if (sizes.empty()) {
+        sizes.push_back(static_cast<size_t>(memtable->getThreshold()));
+    }
+    while (sizes.size() < numLevels) {
+        sizes.push_back(sizes.back() * fixedSizeRatio);
+    }
+    sizes.resize(numLevels);
+    return sizes;
+}
+
+// Monkey allocation: for a fixed total budget, the sum of per-level false positive rates
+// (i.e. expected wasted I/O per lookup) is minimized when each level's FPR is proportional
+// to its size. Smaller levels therefore get more bits per key than the last level.
+std::vector<double> LSMTree::computeMonkeyBitsPerKey(const std::vector<size_t>& levelSizes, double avgBitsPerKey) {
+    const double ln2Squared = std::log(2.0) * std::log(2.0);
+    std::vector<double> bits(levelSizes.size(), avgBitsPerKey);
+    if (levelSizes.size() < 2) {
+        return bits;
+    }
+
+    double totalKeys = 0;
+    for (size_t n : levelSizes) {
+        totalKeys += static_cast<double>(n);
+    }
+    const double budget = avgBitsPerKey * totalKeys;
+
+    // Bits used when FPR_i = min(1, lambda * N_i)
+    auto allocate = [&](double logLambda, std::vector<double>& out) {
+        double used = 0;
+        for (size_t i = 0; i < levelSizes.size(); ++i) {
+            double logFpr = std::min(0.0, logLambda + std::log(static_cast<double>(std::max<size_t>(levelSizes[i], 1))));
+            out[i] = -logFpr / ln2Squared;
+            used += out[i] * static_cast<double>(levelSizes[i]);
+        }
+        return used;
+    };
+
+    // Bisection on log(lambda): more lambda -> higher FPRs -> fewer bits
+    double lo = -200.0, hi = 0.0;
+    std::vector<double> candidate(levelSizes.size());
+    for (int iter = 0; iter < 100; ++iter) {
+        double mid = (lo + hi) / 2;
+        if (allocate(mid, candidate) > budget) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    allocate(hi, bits);
+    return bits;
+}
+
+double LSMTree::getBloomBitsPerKeyForLevel(int level) const {
+    if (!monkeyFilterAllocation || level < 1) {
+        return bloomBitsPerKey;
+    }
+    size_t numLevels = std::max(levelMaxSizes.size(), static_cast<size_t>(level));
+    std::vector<double> bits = computeMonkeyBitsPerKey(projectedLevelSizes(numLevels), bloomBitsPerKey);
+    // Keep at least one bit per key so the largest level still filters something
+    return std::max(bits[level - 1], 1.0);
+}
+
+SSTBuildOptions LSMTree::getBuildOptionsForLevel(int level) const {
+    SSTBuildOptions options;
+    options.filterType = filterType;
+    options.bloomBitsPerKey = getBloomBitsPerKeyForLevel(level);
+    options.prefixLength = prefixExtractor.getLength();
+    options.bytesPerSync = sstBytesPerSync;
+    options.rateLimiter = shared->rateLimiter;
+    options.ioPriority = RateLimiter::Priority::HIGH;
+    return options;
+}
+
+std::vector<LSMTree::LevelFilterStats> LSMTree::getFilterStats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<LevelFilterStats> stats;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        LevelFilterStats levelStats{static_cast<int>(i + 1), filterType, 0, 0, 0, 1.0};
+        if (levels[i] != nullptr) {
+            levelStats.filterType = levels[i]->getFilterType();
+            levelStats.numKeys = levels[i]->getNumberOfKeyValues();
+            levelStats.filterBytes = levels[i]->getFilterBytes();
+            levelStats.bitsPerKey = levels[i]->getFilterBitsPerKey();
+            levelStats.expectedFPR = levelStats.filterType == SSTFilterType::XOR
+                                         ? XorFilter::FALSE_POSITIVE_RATE
+                                         : BloomFilter::estimateFalsePositiveRate(levelStats.bitsPerKey);
+        }
+        stats.push_back(levelStats);
+    }
+    return stats;
+}
+
+LSMTree::CompactionStats LSMTree::getCompactionStats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return compactionStats;
+}
+
+void LSMTree::printCompactionStats() const {
+    CompactionStats stats = getCompactionStats();
+    auto utilization = [&stats](double busySeconds) {
+        return stats.wallSeconds > 0 ? 100.0 * busySeconds / stats.wallSeconds : 0.0;
+    };
+    cout << "Compactions = " << stats.numCompactions << ", wall time = " << stats.wallSeconds << " s" << endl;
+    cout << "    read stage:  busy " << stats.readBusySeconds << " s (" << utilization(stats.readBusySeconds)
+         << "%, summed over input readers)" << endl;
+    cout << "    merge stage: busy " << stats.mergeBusySeconds << " s (" << utilization(stats.mergeBusySeconds)
+         << "%)" << endl;
+    cout << "    write stage: busy " << stats.writeBusySeconds << " s (" << utilization(stats.writeBusySeconds)
+         << "%)" << endl;
+    cout << "    tombstones dropped: " << stats.numTombstonesDropped << endl;
+    cout << "    expired entries: " << stats.numExpiredEntries << endl;
+    cout << "    merge operands rejected: " << stats.numMergeOperandsRejected << endl;
+}
+
+void LSMTree::printFilterStats() const {
+    size_t totalBytes = 0;
+    double sumFPR = 0;
+    for (const auto& levelStats : getFilterStats()) {
+        cout << "Level " << levelStats.level
+             << ": filter = " << (levelStats.filterType == SSTFilterType::XOR ? "xor" : "bloom")
+             << ", keys = " << levelStats.numKeys
+             << ", bits/key = " << levelStats.bitsPerKey
+             << ", filter bytes = " << levelStats.filterBytes
+             << ", expected FPR = " << levelStats.expectedFPR << endl;
+        totalBytes += levelStats.filterBytes;
+        if (levelStats.numKeys > 0) {
+            sumFPR += levelStats.expectedFPR;
+        }
+    }
+    cout << "Total filter bytes = " << totalBytes
+         << ", expected false positive I/Os per missing-key lookup = " << sumFPR << endl;
+}
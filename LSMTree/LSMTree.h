@@ -4,32 +4,92 @@
 
 #include "Memtable.h"
 #include "DiskBTree.h"
+#include "DiskBTreeIterator.h"
+#include "SortedRun.h"
+#include "DBIterator.h"
+#include "WriteBatch.h"
+#include "MergeOperator.h"
+#include "ColumnFamily.h"
+#include "BufferPool.h"
+#include "PeriodicTask.h"
+#include "Manifest.h"
+#include "WAL.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <filesystem>
 #include <fstream>
+#include <shared_mutex>
+#include <atomic>
+#include <mutex>
+#include <functional>
 
 namespace fs = std::filesystem;
 
+// Point-in-time view of the database for reads. It holds the memtable and the SSTs as
+// they were when it was taken: later writes copy the memtable instead of changing it, and
+// SSTs replaced by compaction stay readable (their files are already unlinked but remain
+// open) until the last snapshot holding them is released. Visibility comes only from
+// this pinning; the view is not filtered by sequence number.
+class Snapshot {
+private:
+    friend class LSMTree;
+    std::shared_ptr<RedBlackTree> memtable;
+    RangeTombstoneList memtableRangeTombstones;
+    std::vector<std::shared_ptr<SortedRun>> levels;
+};
+
+// Options for range scans
+struct ScanOptions {
+    size_t limit = 0;     // maximum number of rows to return (0 = no limit)
+    bool reverse = false; // return rows in descending key order
+    std::shared_ptr<const Snapshot> snapshot; // read as of this snapshot (nullptr = latest)
+};
+
+// State shared by the column families of one database: the WAL all their writes go
+// to, the counter ordering them, the block cache of their SSTs and the budget their
+// flushes and compactions write under. A tree that is not a column family has one of
+// its own.
+struct ColumnFamilyShared {
+    std::shared_ptr<WAL> wal;
+    std::atomic<uint64_t> lastSequenceNumber{0};
+    std::shared_ptr<BufferPool> blockCache; // nullptr = a buffer pool per SST
+    // Shared by all SST writes; flushes are HIGH priority, compactions LOW
+    const std::shared_ptr<RateLimiter> rateLimiter = std::make_shared<RateLimiter>();
+};
+
+// Reads (get, multiGet, scans, creating iterators) may run concurrently from many
+// threads; writes, flushes and compactions take the tree exclusively. An iterator
+// reads the memtable without the lock, so it must not outlive concurrent writes.
+// Reads through a snapshot (including its iterators) take no lock and may run alongside
+// writes, flushes and compactions. The SST tuning setters (setSSTReadMode,
+// setIOQueueDepth, setBufferPoolParameters) reconfigure SSTs in place, so call them
+// before taking snapshots.
 class LSMTree {
 public:
-    // Constructor with optional memtable size (default to 1000)
-    LSMTree(size_t memtableSize = 1000, const std::string& dbPath = "defaultDB");
+    // Constructor with optional memtable size (default to 1000). The merge operator is
+    // needed here if the WAL being replayed holds merge operands.
+    LSMTree(size_t memtableSize = 1000, const std::string& dbPath = "defaultDB",
+            std::shared_ptr<const MergeOperator> mergeOperator = nullptr);
+
+    // Column family of a database, stored in dbPath and sharing the other families' WAL,
+    // sequence numbers and block cache. Its writes in the WAL are replayed with recover().
+    LSMTree(size_t memtableSize, const std::string& dbPath, const ColumnFamilyHandle& columnFamily,
+            std::shared_ptr<ColumnFamilyShared> shared, std::shared_ptr<const MergeOperator> mergeOperator = nullptr);
 
     // Destructor
     ~LSMTree();
 
-    // Save the state of the LSM tree to a .lsm file
+    // Record the current levels in the manifest log
     void saveState();
 
-    // Load the state of the LSM tree from a .lsm file
+    // Load the levels from the manifest log (or a manifest.lsm written by older versions)
     void loadState();
 
     // Get the number of levels in the LSM tree
     size_t getNumLevels() const;
 
-    // Set the database path
+    // Set the database path, loading its manifest and replaying its WAL
     void setDBPath(const std::string& path);
 
     // Get the database path
@@ -38,11 +98,77 @@ public:
     // Insert a key-value pair into the LSM tree
     void put(const KeyValueWrapper& kv);
 
+    // Apply all records of a batch atomically: one sequence range, one WAL append.
+    // Assigns the batch's first sequence number.
+    void write(WriteBatch& batch);
+
+    // Delete every key in [startKey, endKey) with a single range tombstone
+    void deleteRange(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey);
+
+    // Write an operand for the merge operator without reading the key; it is folded into
+    // the key's value by reads and compactions
+    void merge(const KeyValueWrapper& operand);
+
+    // Operator combining merge operands. Without one, writing or reading operands throws.
+    void setMergeOperator(std::shared_ptr<const MergeOperator> mergeOperator);
+    std::shared_ptr<const MergeOperator> getMergeOperator() const { return mergeOperator; }
+
     // Search for a key-value pair in the LSM tree
     KeyValueWrapper get(const KeyValueWrapper& kv);
+    // Search as of a snapshot
+    KeyValueWrapper get(const KeyValueWrapper& kv, const Snapshot& snapshot);
+
+    // Pin the current state for reads; release it by dropping the pointer. The first write
+    // after each snapshot copies the whole memtable (O(memtable entries), under the write
+    // lock), so taking snapshots between most writes slows writing down.
+    std::shared_ptr<const Snapshot> getSnapshot();
+
+    // Largest sequence number handed out so far
+    uint64_t getLastSequenceNumber() const { return shared->lastSequenceNumber.load(); }
+
+    // Make this tree the default column family of a database: the state it shares with the
+    // other families is returned, its flushes stop resetting the WAL, and its SSTs move to
+    // blockCache. Call before setDBPath when reopening a database with column families.
+    std::shared_ptr<ColumnFamilyShared> shareWithColumnFamilies(std::shared_ptr<BufferPool> blockCache);
+    const ColumnFamilyHandle& getColumnFamily() const { return columnFamily; }
+
+    // Apply this family's records of a batch read back from the shared WAL, unless they
+    // were flushed already
+    void recover(const WriteBatch& batch);
+
+    // Write the memtable to Level 1 if it holds anything
+    void flush();
+
+    // Writes spanning column families (VeloxDB::Write): with the trees locked in id order,
+    // prepare each for the batch, assign its sequence numbers, log it once and apply it
+    // to each. prepareWrite and applyWrite only touch this family's records.
+    std::unique_lock<std::shared_mutex> lockForWrite() { return std::unique_lock<std::shared_mutex>(mutex); }
+    void prepareWrite(WriteBatch& batch) const;
+    void applyWrite(const WriteBatch& batch);
+
+    // Look up many keys at once; results[i] answers keys[i] (empty if not found or deleted).
+    // Keys are sorted and deduplicated, and each level is searched for all unresolved keys together.
+    std::vector<KeyValueWrapper> multiGet(const std::vector<KeyValueWrapper>& keys);
 
     // Scan method
-    void scan(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey, std::vector<KeyValueWrapper>& result);
+    void scan(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey, std::vector<KeyValueWrapper>& result,
+              const ScanOptions& options = ScanOptions());
+
+    // Streaming iterator over the memtable and all levels (as of snapshot if given)
+    std::unique_ptr<DBIterator> newIterator(const std::shared_ptr<const Snapshot>& snapshot = nullptr);
+
+    // Scan all string keys starting with prefix, skipping SSTs whose prefix filter rejects it
+    void scanPrefix(const std::string& prefix, std::vector<KeyValueWrapper>& result,
+                    const ScanOptions& options = ScanOptions());
+
+    // Capped prefix length for prefix Bloom filters of new SSTs (0 disables them)
+    void setPrefixExtractor(size_t prefixLength);
+    size_t getPrefixLength() const { return prefixExtractor.getLength(); }
+    // Number of SSTs skipped by prefix filters so far
+    size_t getPrefixFilterSkips() const { return prefixFilterSkips.load(); }
+
+    // Merge all SSTs into the bottommost level in a single pass
+    void compactAll();
 
     // print LSM-Tree structure
     void printTree() const;
@@ -50,43 +176,266 @@ public:
 
     // set Buffer Pool Parameter
     void setBufferPoolParameters(size_t capacity, EvictionPolicy policy);
+    // Hits of the shared block cache if there is one (all families), else of the SSTs' buffer pools
     long long getTotalCacheHits() const;
 
+    // Page reads kept in flight by MultiGet and scan readahead, for every SST (1 = one at a time)
+    void setIOQueueDepth(size_t depth);
+    size_t getIOQueueDepth() const { return ioQueueDepth; }
+
+    // Read SSTs with pread (default) or through memory mappings; MMAP suits
+    // datasets that fit in RAM
+    void setSSTReadMode(SSTReadMode mode);
+    SSTReadMode getSSTReadMode() const { return sstReadMode; }
+
+    // Start writeback every bytesPerSync bytes while writing an SST (0 = only the final fsync)
+    void setSSTBytesPerSync(size_t bytesPerSync);
+    size_t getSSTBytesPerSync() const { return sstBytesPerSync; }
+
+    // Limit the bytes per second flushes and compactions write (0 = unlimited), together with
+    // the other column families of the database. Does not wait for the tree lock, so a
+    // running compaction slows down or speeds up right away.
+    void setFlushRateLimit(uint64_t bytesPerSecond);
+    void setCompactionRateLimit(uint64_t bytesPerSecond);
+    const RateLimiter& getRateLimiter() const { return *shared->rateLimiter; }
+
+    // Split merges of at least 2 * MIN_SUBCOMPACTION_KEYS entries into up to n key ranges
+    // merged on their own threads; the level then holds one SST per range (1 = no split)
+    static constexpr size_t MIN_SUBCOMPACTION_KEYS = 4096;
+    void setMaxSubcompactions(size_t n);
+    size_t getMaxSubcompactions() const { return maxSubcompactions; }
+
+    // Number of SSTs in the given level (1-based), 0 if it is empty
+    size_t getNumSSTsInLevel(int level) const;
+
+    // After a flush, push an SST whose share of tombstones reaches ratio towards the
+    // bottommost level, where the tombstones are dropped (0 = never)
+    static constexpr double DEFAULT_TOMBSTONE_COMPACTION_RATIO = 0.5;
+    void setTombstoneCompactionRatio(double ratio);
+    double getTombstoneCompactionRatio() const { return tombstoneCompactionRatio; }
+
+    // Number of tombstones stored in the given level (1-based)
+    size_t getNumTombstonesInLevel(int level) const;
+
+    // Time to live given to puts and merges written without an expiry time (0 = none).
+    // Expired entries are hidden from reads; compactions drop their values, and the
+    // bottommost level drops them altogether.
+    void setDefaultTTL(uint64_t ttlSeconds);
+    uint64_t getDefaultTTL() const { return defaultTTLSeconds; }
+
+    // Rewrite the SSTs holding expired entries. Runs after every flush, and every
+    // `seconds` on a background thread once set, so cold SSTs are reclaimed too (0 = stop).
+    void compactExpired();
+    void setPeriodicCompactionSeconds(uint64_t seconds);
+
+    // Bloom filter budget; with Monkey allocation the average over all levels stays at bitsPerKey
+    void setBloomFilterBitsPerKey(double bitsPerKey);
+    double getBloomFilterBitsPerKey() const { return bloomBitsPerKey; }
+    void setMonkeyFilterAllocation(bool enabled);
+    bool isMonkeyFilterAllocation() const { return monkeyFilterAllocation; }
+
+    // Filter written with new SSTs: per-leaf Bloom filters or one xor filter per SST
+    void setFilterType(SSTFilterType type);
+    SSTFilterType getFilterType() const { return filterType; }
+
+    // Bits per key used for leaf filters of SSTs written into the given level (1-based)
+    double getBloomBitsPerKeyForLevel(int level) const;
+
+    // Build options for SSTs written into the given level (1-based)
+    SSTBuildOptions getBuildOptionsForLevel(int level) const;
+
+    // Per-level filter memory and expected false positive rate
+    struct LevelFilterStats {
+        int level;
+        SSTFilterType filterType;
+        size_t numKeys;
+        double bitsPerKey;
+        size_t filterBytes;
+        double expectedFPR;
+    };
+    std::vector<LevelFilterStats> getFilterStats() const;
+    void printFilterStats() const;
+
+    // Time spent in the stages of the compaction pipeline, summed over all merges so far.
+    // A stage's utilization is its busy time over the wall time; the read stage sums the
+    // reader threads of all inputs, so it can exceed the wall time.
+    struct CompactionStats {
+        size_t numCompactions = 0;     // merges, counting each subcompaction
+        double wallSeconds = 0;
+        double readBusySeconds = 0;    // reading and decoding input leaves
+        double mergeBusySeconds = 0;   // merging and building pages, excluding waits for the other stages
+        double writeBusySeconds = 0;   // serializing, writing and syncing output pages
+        size_t numTombstonesDropped = 0; // tombstones merged into the bottommost level
+        size_t numExpiredEntries = 0;    // expired entries dropped, or reduced to tombstones above the bottom
+        size_t numMergeOperandsRejected = 0; // operands the merge operator could not apply, dropped
+    };
+    CompactionStats getCompactionStats() const;
+    void printCompactionStats() const;
+
+    // Per-level bits per key minimizing the sum of FPRs for an average budget of avgBitsPerKey
+    static std::vector<double> computeMonkeyBitsPerKey(const std::vector<size_t>& levelSizes, double avgBitsPerKey);
+
 private:
     // Level 0 is always the in-memory memtable
     std::unique_ptr<Memtable> memtable; // Level 0
 
     // Levels 1 and above consist of DiskBTrees (SSTables)
-    // Each level holds at most one SSTable
-    std::vector<std::shared_ptr<DiskBTree>> levels; // Levels 1+
+    // Each level holds at most one sorted run of SSTables with disjoint key ranges
+    std::vector<std::shared_ptr<SortedRun>> levels; // Levels 1+
 
     size_t fixedSizeRatio = 2;
 
     // Level capacities (maximum number of key-value pairs per level)
     std::vector<size_t> levelMaxSizes;
 
-    // Path to the .lsm file and database directory
+    // Database directory, its manifest log and the single-file manifest older versions
+    // rewrote on every change (read once, then replaced by the log)
     fs::path dbPath;
+    fs::path manifestLogPath;
     fs::path lsmFilePath;
 
+    // Open manifest log (nullptr until the first write after opening, which starts a new
+    // log from a snapshot) and the level layout it describes
+    std::unique_ptr<ManifestLog> manifestLog;
+    ManifestState manifestState;
+    // Number of the next SST file name; persisted in the manifest so names are not reused
+    uint64_t nextFileNumber = 0;
+    // SSTs replaced since the last manifest write; deleted once an edit drops them, so a
+    // crash before then still finds every file the manifest names
+    std::vector<std::string> obsoleteFiles;
+
+    // WAL, sequence counter and block cache; the last sequence number is persisted in
+    // the manifest and recovered from it and the WAL
+    std::shared_ptr<ColumnFamilyShared> shared = std::make_shared<ColumnFamilyShared>();
+    ColumnFamilyHandle columnFamily;
+    // Whether other column families write to the WAL, so a flush may not reset it
+    bool sharesWAL = false;
+    // Every write of this tree up to here is in its SSTs; the WAL is replayed from the next one
+    uint64_t flushedSequenceNumber = 0;
+
+    // Shared by readers, exclusive for writers
+    mutable std::shared_mutex mutex;
+
     // Helper methods
     void initializeLSM();
 
+    // Log the changes to the levels since the last write as a version edit, or a snapshot
+    // every ManifestLog::SNAPSHOT_INTERVAL edits, then delete the obsolete SSTs (caller
+    // holds the lock exclusively)
+    void writeManifest();
+    // Read the levels from the manifest log, or the legacy manifest (caller holds the lock
+    // exclusively)
+    void loadManifest();
+    // Bounds a legacy manifest must stay within, to tell it apart from other layouts
+    static constexpr size_t MAX_LEGACY_LEVELS = 64;
+    static constexpr size_t MAX_LEGACY_FILE_NAME_LENGTH = 255;
+    void loadLegacyManifest();
+    bool hasManifest() const { return fs::exists(manifestLogPath) || fs::exists(lsmFilePath); }
+    // Level layout of the in-memory levels, in manifest form
+    ManifestState currentManifestState() const;
+    // Delete SSTs in dbPath the manifest does not name, left behind by a crash
+    void removeUnreferencedSSTs(const ManifestState& state);
+    // Open and configure the SSTs at paths, in parallel when there are many
+    static constexpr size_t MAX_OPEN_THREADS = 8;
+    static constexpr size_t MIN_SSTS_PER_OPEN_THREAD = 16;
+    std::vector<std::shared_ptr<DiskBTree>> openSSTs(const std::vector<std::string>& paths);
+
+    // Replay dbPath's WAL into the memtable and open it for appending
+    void openWAL();
+    // Apply this family's records newer than flushedSequenceNumber
+    void replayBatch(const WriteBatch& batch);
+
+    // Reserve count consecutive sequence numbers; returns the first
+    uint64_t allocateSequenceNumbers(size_t count);
+
+    // Resolve kv from the memtable's entry and range tombstones, then the given levels,
+    // newest first. A range tombstone hides older versions of the key, and everything
+    // in the levels below the source holding it. Merge operands are collected until a
+    // value or deletion below them, then folded.
+    KeyValueWrapper getFromLevels(const KeyValueWrapper& kv, const KeyValueWrapper& memtableEntry,
+                                  const RangeTombstoneList& memtableRangeTombstones,
+                                  const std::vector<std::shared_ptr<SortedRun>>& levels) const;
+
+    // Apply a write (put, delete or merge operand) to the memtable
+    void applyToMemtable(const KeyValueWrapper& kv);
+    const MergeOperator& requireMergeOperator() const;
+
+    // Fold the batch's merge operands as applyWrite would, onto the memtable and the batch's
+    // earlier records, so an operand the operator rejects throws before the batch is logged
+    void checkMergeOperands(const WriteBatch& batch) const;
+
     // Handle flushing memtable to Level 1
     void flushMemtableToLevel1();
 
     // Merge SSTables when a level exceeds its capacity
-    void mergeLevels(int level, const std::shared_ptr<DiskBTree>& sstToMerge);
+    void mergeLevels(int level, const std::shared_ptr<SortedRun>& runToMerge);
 
-    // Merge two SSTables into a new SSTable
-    void mergeSSTables(const std::shared_ptr<DiskBTree>& sst1,
-                       const std::shared_ptr<DiskBTree>& sst2,
-                       const std::string& outputSSTableFileName,
-                       std::vector<KeyValueWrapper>& leafPageSmallestKeys,
-                       int& numberOfPages,
-                       int& totalKvs);
+    // Link the run's SSTs under names of the given level and place new handles on them there
+    void moveRunToLevel(int level, const std::shared_ptr<SortedRun>& run);
 
-    // Generate unique SSTable file names
+    // Merge runs (newest first) into a new run for the given level, split into key-range
+    // subcompactions at fence keys of the largest input. Tombstones are dropped when no
+    // deeper level holds data they could shadow.
+    std::shared_ptr<SortedRun> compactRuns(const std::vector<std::shared_ptr<SortedRun>>& inputs, int level);
+
+    // True if no level below the given one (1-based) holds data
+    bool isBottommostLevel(int level) const;
+
+    // Compact the levels holding an SST with at least tombstoneCompactionRatio tombstones:
+    // other levels are merged into the next one, the bottommost rewrites those SSTs
+    void compactTombstoneDenseLevels();
+    bool isTombstoneDense(const DiskBTree& sst) const;
+
+    // Rewrite the SSTs of the level at index picked by rewrite in place; each output covers
+    // the range of the SST it replaces, so the run stays ordered. Returns whether any was.
+    bool rewriteSSTs(size_t index, const std::function<bool(const DiskBTree&)>& rewrite);
+
+    // Rewrite the SSTs holding an entry expired by now, returning whether any was
+    bool compactExpiredSSTs();
+
+    // Puts and merges get this expiry time unless they carry one (0 = no default TTL)
+    uint64_t defaultExpiryTime() const;
+
+    // Tombstone replacing an expired entry; its value is dropped
+    static KeyValueWrapper expiredToTombstone(const KeyValueWrapper& kv);
+
+    // Up to numRanges - 1 split keys taken evenly from the root separators of the run's SSTs
+    std::vector<KeyValueWrapper> pickSubcompactionBoundaries(const SortedRun& run, size_t numRanges) const;
+
+    // Merge SSTables (newest first) into a new SSTable with a k-way loser tree, writing each page once.
+    // Inputs are read ahead and output pages written on their own threads (stage times go to stats).
+    // With bounds, only keys in [*lowerBound, *upperBound) are merged; with dropTombstones,
+    // keys whose newest version is a tombstone are left out.
+    std::shared_ptr<DiskBTree> mergeSSTables(const std::vector<std::shared_ptr<DiskBTree>>& inputs,
+                                             const std::string& outputSSTableFileName,
+                                             const SSTBuildOptions& options,
+                                             const KeyValueWrapper* lowerBound = nullptr,
+                                             const KeyValueWrapper* upperBound = nullptr,
+                                             CompactionStats* stats = nullptr,
+                                             bool dropTombstones = false);
+
+    // SSTs of all levels, Level 1 first (i.e. newest first)
+    std::vector<std::shared_ptr<DiskBTree>> liveSSTs() const;
+    // Same for the levels a snapshot holds (the live ones without a snapshot)
+    std::vector<std::shared_ptr<DiskBTree>> readSSTs(const std::shared_ptr<const Snapshot>& snapshot) const;
+    static std::vector<std::shared_ptr<DiskBTree>> flattenLevels(const std::vector<std::shared_ptr<SortedRun>>& levels);
+
+    // Range tombstones of the memtable and all levels (the snapshot's if given)
+    RangeTombstoneList collectRangeTombstones(const std::shared_ptr<const Snapshot>& snapshot) const;
+
+    // Iterator over the memtable (the snapshot's if given) and the given SSTs
+    std::unique_ptr<DBIterator> newIterator(const std::vector<std::shared_ptr<DiskBTree>>& ssts,
+                                            const std::shared_ptr<const Snapshot>& snapshot);
+
+    // Merge the memtable with the given SSTs over [startKey, endKey]
+    void scanSSTs(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey,
+                  const std::vector<std::shared_ptr<DiskBTree>>& ssts, std::vector<KeyValueWrapper>& result,
+                  const ScanOptions& options);
+
+    // Level capacities used for filter allocation, projected to numLevels levels
+    std::vector<size_t> projectedLevelSizes(size_t numLevels) const;
+
+    // Generate unique SSTable file names, skipping names already taken in dbPath
     std::string generateSSTableFileName(int level);
 
     // Disable copy and assignment
@@ -95,6 +444,26 @@ private:
 
     size_t bufferPoolCapacity;
     EvictionPolicy bufferPoolPolicy;
+    size_t ioQueueDepth = 1;
+    SSTReadMode sstReadMode = SSTReadMode::PREAD;
+    size_t sstBytesPerSync = 0;
+    size_t maxSubcompactions = 1;
+    std::shared_ptr<const MergeOperator> mergeOperator;
+    double tombstoneCompactionRatio = DEFAULT_TOMBSTONE_COMPACTION_RATIO;
+    uint64_t defaultTTLSeconds = 0;
+    // Runs compactExpired() every periodic compaction interval
+    std::unique_ptr<PeriodicTask> periodicCompaction;
+    CompactionStats compactionStats;
+    void configureSST(const std::shared_ptr<DiskBTree>& sst) const;
+
+    // Filter configuration
+    double bloomBitsPerKey = DiskBTree::DEFAULT_BLOOM_BITS_PER_KEY;
+    bool monkeyFilterAllocation = false;
+    SSTFilterType filterType = SSTFilterType::LEAF_BLOOM;
+
+    // Prefix filter configuration
+    PrefixExtractor prefixExtractor;
+    std::atomic<size_t> prefixFilterSkips{0};
 };
 
 #endif // LSMTREE_H
@@ -0,0 +1,300 @@
+// Manifest.cpp
+
+#include "Manifest.h"
+#include "WAL.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+std::string VersionEdit::encode() const {
+    std::string data;
+    auto append = [&data](const void* bytes, size_t size) {
+        data.append(static_cast<const char*>(bytes), size);
+    };
+    auto appendString = [&append](const std::string& value) {
+        uint32_t length = static_cast<uint32_t>(value.size());
+        append(&length, sizeof(length));
+        append(value.data(), value.size());
+    };
+    auto appendCount = [&append](size_t count) {
+        uint32_t value = static_cast<uint32_t>(count);
+        append(&value, sizeof(value));
+    };
+
+    append(&lastSequenceNumber, sizeof(lastSequenceNumber));
+    append(&flushedSequenceNumber, sizeof(flushedSequenceNumber));
+    append(&nextFileNumber, sizeof(nextFileNumber));
+
+    appendCount(levelCapacities.size());
+    for (const auto& [level, capacity] : levelCapacities) {
+        int32_t levelNumber = level;
+        uint64_t value = capacity;
+        append(&levelNumber, sizeof(levelNumber));
+        append(&value, sizeof(value));
+    }
+    appendCount(removedFiles.size());
+    for (const auto& file : removedFiles) {
+        int32_t levelNumber = file.level;
+        append(&levelNumber, sizeof(levelNumber));
+        appendString(file.fileName);
+    }
+    appendCount(addedFiles.size());
+    for (const auto& file : addedFiles) {
+        int32_t levelNumber = file.level;
+        append(&levelNumber, sizeof(levelNumber));
+        appendString(file.fileName);
+        std::string smallestKey;
+        if (!file.smallestKey.kv.SerializeToString(&smallestKey)) {
+            throw std::runtime_error("VersionEdit::encode() Failed to serialize smallest key");
+        }
+        appendString(smallestKey);
+    }
+    return data;
+}
+
+VersionEdit VersionEdit::decode(const std::string& data) {
+    size_t offset = 0;
+    auto read = [&data, &offset](void* bytes, size_t size) {
+        if (offset + size > data.size()) {
+            throw std::runtime_error("VersionEdit::decode() Truncated version edit");
+        }
+        std::memcpy(bytes, data.data() + offset, size);
+        offset += size;
+    };
+    auto readString = [&read, &data, &offset]() {
+        uint32_t length;
+        read(&length, sizeof(length));
+        if (offset + length > data.size()) {
+            throw std::runtime_error("VersionEdit::decode() Truncated version edit");
+        }
+        std::string value = data.substr(offset, length);
+        offset += length;
+        return value;
+    };
+
+    VersionEdit edit;
+    read(&edit.lastSequenceNumber, sizeof(edit.lastSequenceNumber));
+    read(&edit.flushedSequenceNumber, sizeof(edit.flushedSequenceNumber));
+    read(&edit.nextFileNumber, sizeof(edit.nextFileNumber));
+
+    uint32_t count;
+    read(&count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t level;
+        uint64_t capacity;
+        read(&level, sizeof(level));
+        read(&capacity, sizeof(capacity));
+        edit.levelCapacities.emplace_back(level, static_cast<size_t>(capacity));
+    }
+    read(&count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t level;
+        read(&level, sizeof(level));
+        edit.removedFiles.push_back({level, readString()});
+    }
+    read(&count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+        int32_t level;
+        read(&level, sizeof(level));
+        std::string fileName = readString();
+        KeyValue smallestKey;
+        std::string payload = readString();
+        if (!smallestKey.ParseFromString(payload)) {
+            throw std::runtime_error("VersionEdit::decode() Failed to parse smallest key");
+        }
+        edit.addedFiles.push_back({level, std::move(fileName), KeyValueWrapper(smallestKey)});
+    }
+    return edit;
+}
+
+void ManifestState::apply(const VersionEdit& edit) {
+    lastSequenceNumber = std::max(lastSequenceNumber, edit.lastSequenceNumber);
+    flushedSequenceNumber = std::max(flushedSequenceNumber, edit.flushedSequenceNumber);
+    nextFileNumber = std::max(nextFileNumber, edit.nextFileNumber);
+
+    auto ensureLevel = [this](int level) {
+        if (level < 1) {
+            throw std::runtime_error("ManifestState::apply() Invalid level " + std::to_string(level));
+        }
+        if (levelCapacities.size() < static_cast<size_t>(level)) {
+            levelCapacities.resize(level, 0);
+            levelFiles.resize(level);
+        }
+    };
+    for (const auto& [level, capacity] : edit.levelCapacities) {
+        ensureLevel(level);
+        levelCapacities[level - 1] = capacity;
+    }
+    for (const auto& file : edit.removedFiles) {
+        ensureLevel(file.level);
+        levelFiles[file.level - 1].erase(file.fileName);
+    }
+    for (const auto& file : edit.addedFiles) {
+        ensureLevel(file.level);
+        levelFiles[file.level - 1][file.fileName] = file.smallestKey;
+    }
+}
+
+std::vector<std::string> ManifestState::sortedFiles(size_t index) const {
+    std::vector<std::pair<KeyValueWrapper, std::string>> files;
+    for (const auto& [fileName, smallestKey] : levelFiles[index]) {
+        files.emplace_back(smallestKey, fileName);
+    }
+    std::stable_sort(files.begin(), files.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<std::string> fileNames;
+    for (auto& file : files) {
+        fileNames.push_back(std::move(file.second));
+    }
+    return fileNames;
+}
+
+VersionEdit ManifestState::diff(const ManifestState& from, const ManifestState& to) {
+    VersionEdit edit;
+    edit.lastSequenceNumber = to.lastSequenceNumber;
+    edit.flushedSequenceNumber = to.flushedSequenceNumber;
+    edit.nextFileNumber = to.nextFileNumber;
+    for (size_t i = 0; i < to.levelCapacities.size(); ++i) {
+        int level = static_cast<int>(i + 1);
+        if (i >= from.levelCapacities.size() || from.levelCapacities[i] != to.levelCapacities[i]) {
+            edit.levelCapacities.emplace_back(level, to.levelCapacities[i]);
+        }
+        for (const auto& [fileName, smallestKey] : to.levelFiles[i]) {
+            if (i >= from.levelFiles.size() || from.levelFiles[i].count(fileName) == 0) {
+                edit.addedFiles.push_back({level, fileName, smallestKey});
+            }
+        }
+    }
+    for (size_t i = 0; i < from.levelFiles.size(); ++i) {
+        for (const auto& [fileName, smallestKey] : from.levelFiles[i]) {
+            if (i >= to.levelFiles.size() || to.levelFiles[i].count(fileName) == 0) {
+                edit.removedFiles.push_back({static_cast<int>(i + 1), fileName});
+            }
+        }
+    }
+    return edit;
+}
+
+ManifestLog::ManifestLog(const std::string& filePath, const VersionEdit& snapshot) : filePath(filePath) {
+    std::string tempPath = filePath + ".tmp";
+    int tempFd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (tempFd < 0) {
+        throw std::runtime_error("ManifestLog: Failed to create " + tempPath);
+    }
+    try {
+        uint32_t header[2] = {MAGIC, FORMAT_VERSION};
+        if (::write(tempFd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+            throw std::runtime_error("ManifestLog: Failed to write " + tempPath);
+        }
+        writeRecord(tempFd, snapshot, tempPath);
+    } catch (...) {
+        ::close(tempFd);
+        throw;
+    }
+    ::close(tempFd);
+    fs::rename(tempPath, filePath);
+    syncDirectory(filePath);
+
+    fd = ::open(filePath.c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0) {
+        throw std::runtime_error("ManifestLog: Failed to open " + filePath);
+    }
+}
+
+ManifestLog::~ManifestLog() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void ManifestLog::append(const VersionEdit& edit) {
+    writeRecord(fd, edit, filePath);
+    syncDirectory(filePath);
+    numEdits++;
+}
+
+void ManifestLog::writeRecord(int fd, const VersionEdit& edit, const std::string& filePath) {
+    std::string payload = edit.encode();
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    uint32_t sum = WAL::checksum(payload.data(), payload.size());
+    std::string record(reinterpret_cast<const char*>(&size), sizeof(size));
+    record.append(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    record.append(payload);
+
+    size_t written = 0;
+    while (written < record.size()) {
+        ssize_t n = ::write(fd, record.data() + written, record.size() - written);
+        if (n < 0) {
+            throw std::runtime_error("ManifestLog: Failed to write " + filePath);
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (::fsync(fd) != 0) {
+        throw std::runtime_error("ManifestLog: Failed to sync " + filePath);
+    }
+}
+
+// New and renamed files (the log, the SSTs an edit adds) only survive a crash once
+// their directory entries are synced
+void ManifestLog::syncDirectory(const std::string& filePath) {
+    fs::path directory = fs::path(filePath).parent_path();
+    int dirFd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (dirFd < 0) {
+        throw std::runtime_error("ManifestLog: Failed to open directory of " + filePath);
+    }
+    int result = ::fsync(dirFd);
+    ::close(dirFd);
+    if (result != 0) {
+        throw std::runtime_error("ManifestLog: Failed to sync directory of " + filePath);
+    }
+}
+
+size_t ManifestLog::replay(const std::string& filePath, ManifestState& state) {
+    std::ifstream ifs(filePath, std::ios::binary);
+    if (!ifs) {
+        return 0;
+    }
+    std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+
+    // The header is written before the log is renamed into place, so it is always whole
+    uint32_t header[2] = {0, 0};
+    if (data.size() >= sizeof(header)) {
+        std::memcpy(header, data.data(), sizeof(header));
+    }
+    if (header[0] != MAGIC) {
+        throw std::runtime_error("ManifestLog: " + filePath + " is not a manifest log of a known format");
+    }
+    if (header[1] != FORMAT_VERSION) {
+        throw std::runtime_error("ManifestLog: " + filePath + " has format version " + std::to_string(header[1])
+                                 + ", this version reads " + std::to_string(FORMAT_VERSION));
+    }
+
+    size_t offset = sizeof(header);
+    size_t numRecords = 0;
+    const size_t recordHeaderSize = 2 * sizeof(uint32_t);
+    while (offset + recordHeaderSize <= data.size()) {
+        uint32_t size, sum;
+        std::memcpy(&size, data.data() + offset, sizeof(size));
+        std::memcpy(&sum, data.data() + offset + sizeof(size), sizeof(sum));
+        const char* payload = data.data() + offset + recordHeaderSize;
+        if (offset + recordHeaderSize + size > data.size() || WAL::checksum(payload, size) != sum) {
+            break;
+        }
+        state.apply(VersionEdit::decode(std::string(payload, size)));
+        offset += recordHeaderSize + size;
+        numRecords++;
+    }
+
+    if (offset < data.size()) {
+        fs::resize_file(filePath, offset);
+    }
+    return numRecords;
+}
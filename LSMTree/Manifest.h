@@ -0,0 +1,102 @@
+// Manifest.h
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include "KeyValue.h"
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// One change to the level layout of an LSM tree, as logged in its manifest. Levels are
+// 1-based; an added SST carries its smallest key so a level can be put back in key order
+// without opening its files.
+struct VersionEdit {
+    struct AddedFile {
+        int level;
+        std::string fileName;
+        KeyValueWrapper smallestKey;
+    };
+    struct RemovedFile {
+        int level;
+        std::string fileName;
+    };
+
+    uint64_t lastSequenceNumber = 0;
+    uint64_t flushedSequenceNumber = 0;
+    uint64_t nextFileNumber = 0;
+    std::vector<std::pair<int, size_t>> levelCapacities; // levels whose capacity is (re)set
+    std::vector<RemovedFile> removedFiles;
+    std::vector<AddedFile> addedFiles;
+
+    //   uint64 last sequence number | uint64 flushed sequence number | uint64 next file number
+    //   | uint32 count x (int32 level | uint64 capacity)
+    //   | uint32 count x (int32 level | uint32 length | file name)
+    //   | uint32 count x (int32 level | uint32 length | file name | uint32 length | smallest KeyValue)
+    std::string encode() const;
+    static VersionEdit decode(const std::string& data);
+};
+
+// Level layout described by a manifest: the result of applying its edits in order
+struct ManifestState {
+    uint64_t lastSequenceNumber = 0;
+    uint64_t flushedSequenceNumber = 0;
+    uint64_t nextFileNumber = 0;
+    std::vector<size_t> levelCapacities;                            // index = level - 1
+    std::vector<std::map<std::string, KeyValueWrapper>> levelFiles; // file name -> smallest key
+
+    void apply(const VersionEdit& edit);
+
+    // File names of the level at index in key order
+    std::vector<std::string> sortedFiles(size_t index) const;
+
+    // Edit turning from into to; from an empty state it is a snapshot of to
+    static VersionEdit diff(const ManifestState& from, const ManifestState& to);
+};
+
+// Append-only manifest of version edits:
+//
+//   header : uint32 MAGIC | uint32 FORMAT_VERSION
+//   record : uint32 payload size | uint32 checksum | encoded VersionEdit
+//
+// A change to the layout of the records or of VersionEdit needs a new FORMAT_VERSION; a log
+// of another version or without the header is refused instead of being misread.
+//
+// The first record is a snapshot (the edit building the whole layout from nothing). Every
+// append is fsynced, together with the directory, so the SSTs an edit names are durable
+// once it returns. After SNAPSHOT_INTERVAL edits the owner starts a new log from a
+// snapshot; it is written next to the old one and renamed over it.
+class ManifestLog {
+public:
+    static constexpr size_t SNAPSHOT_INTERVAL = 64;
+    static constexpr uint32_t MAGIC = 0x4D584C56; // "VLXM"
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    // Replace the log at filePath by one holding only snapshot
+    ManifestLog(const std::string& filePath, const VersionEdit& snapshot);
+    ~ManifestLog();
+
+    void append(const VersionEdit& edit);
+
+    // Edits appended after the snapshot
+    size_t getNumEdits() const { return numEdits; }
+
+    // Apply every complete record of the log at filePath to state and return the number of
+    // records. A torn or corrupt record ends the log and is cut off. Throws for a log of
+    // another format version.
+    static size_t replay(const std::string& filePath, ManifestState& state);
+
+    ManifestLog(const ManifestLog&) = delete;
+    ManifestLog& operator=(const ManifestLog&) = delete;
+
+private:
+    std::string filePath;
+    int fd = -1;
+    size_t numEdits = 0;
+
+    static void writeRecord(int fd, const VersionEdit& edit, const std::string& filePath);
+    static void syncDirectory(const std::string& filePath);
+};
+
+#endif // MANIFEST_H
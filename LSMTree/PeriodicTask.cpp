@@ -0,0 +1,32 @@
+// PeriodicTask.cpp
+
+#include "PeriodicTask.h"
+#include <exception>
+#include <iostream>
+
+PeriodicTask::PeriodicTask(std::string name, std::chrono::seconds interval, std::function<void()> task)
+    : name(std::move(name)), interval(interval), task(std::move(task)) {
+    thread = std::thread(&PeriodicTask::loop, this);
+}
+
+PeriodicTask::~PeriodicTask() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    thread.join();
+}
+
+void PeriodicTask::loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wakeup.wait_for(lock, interval, [this] { return stopping; })) {
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << name << " failed: " << e.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
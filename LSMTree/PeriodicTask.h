@@ -0,0 +1,36 @@
+// PeriodicTask.h
+#ifndef PERIODIC_TASK_H
+#define PERIODIC_TASK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs a function every interval on a background thread until it is destroyed.
+// Errors thrown by the function are logged and the next run goes ahead.
+class PeriodicTask {
+public:
+    PeriodicTask(std::string name, std::chrono::seconds interval, std::function<void()> task);
+    // Waits for a run in progress to finish
+    ~PeriodicTask();
+
+    PeriodicTask(const PeriodicTask&) = delete;
+    PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+private:
+    std::string name;
+    std::chrono::seconds interval;
+    std::function<void()> task;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    std::thread thread;
+
+    void loop();
+};
+
+#endif // PERIODIC_TASK_H
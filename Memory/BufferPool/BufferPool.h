@@ -13,6 +13,7 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <random>
 #include "Page.h"
 
@@ -58,13 +59,13 @@ public:
     void setEvictionPolicy(EvictionPolicy policy);
 
     // cache hit
-    void Hit() {++cacheHit;};
-    long long getCacheHit() const {return cacheHit;};
+    void Hit() {cacheHit.fetch_add(1, std::memory_order_relaxed);};
+    long long getCacheHit() const {return cacheHit.load(std::memory_order_relaxed);};
 
 private:
     size_t capacity;
     EvictionPolicy policy;
-    long long cacheHit = 0;
+    std::atomic<long long> cacheHit{0};
 
     // Underlying container for the buffer pool
     std::unordered_map<PageId, std::shared_ptr<Page>> pageTable;
@@ -4,33 +4,61 @@
 
 // Memtable.cpp
 #include "Memtable.h"
+#include "MemtableIterator.h"
 
 // Default Constructor
 Memtable::Memtable()
     : memtableSize(1000), // Default threshold
       currentSize(0),
-      tree(new RedBlackTree()) {
+      tree(std::make_shared<RedBlackTree>()) {
 }
 
 // Constructor with threshold
 Memtable::Memtable(int threshold)
     : memtableSize(threshold),
       currentSize(0),
-      tree(new RedBlackTree()) {
+      tree(std::make_shared<RedBlackTree>()) {
 }
 
 // Destructor
-Memtable::~Memtable() {
-    delete tree;
-}
+Memtable::~Memtable() = default;
 
 // Insert a key-value pair into the memtable
 void Memtable::put(const KeyValueWrapper& kv) {
+    if (pinned) {
+        // Copy on write, the snapshot keeps the old tree
+        auto copy = std::make_shared<RedBlackTree>();
+        tree->inOrderTraversal([&copy](KeyValueWrapper& entry) { copy->insert(entry); });
+        tree = copy;
+        pinned = false;
+    }
     // Insert into the in-memory RedBlackTree
     tree->insert(kv);
     currentSize++;
 }
 
+void Memtable::merge(const KeyValueWrapper& operand, const MergeOperator& mergeOperator) {
+    put(foldOperand(tree->getValue(operand), operand, rangeTombstones.maxCoveringSequence(operand), mergeOperator));
+}
+
+KeyValueWrapper Memtable::foldOperand(const KeyValueWrapper& existing, const KeyValueWrapper& operand,
+                                      uint64_t rangeDeletedUpTo, const MergeOperator& mergeOperator) {
+    if (existing.isEmpty()) {
+        // Under a range tombstone no older version counts, so the operand is the whole value
+        return rangeDeletedUpTo > 0 ? mergeOperator.fold(nullptr, {operand}) : operand;
+    }
+    if (existing.isTombstone() || rangeDeletedUpTo > existing.sequenceNumber
+        || existing.isExpired(KeyValueWrapper::currentTimeMillis())) {
+        return mergeOperator.fold(nullptr, {operand});
+    }
+    return mergeOperator.fold(&existing, {operand}, existing.isMergeOperand());
+}
+
+void Memtable::addRangeTombstone(const RangeTombstone& tombstone) {
+    rangeTombstones.add(tombstone);
+    currentSize++;
+}
+
 // Get a key-value pair from the memtable
 KeyValueWrapper Memtable::get(const KeyValueWrapper& kv) {
     // Search only in the in-memory RedBlackTree
@@ -53,12 +81,26 @@ std::vector<KeyValueWrapper> Memtable::flush() {
         kvPairs.push_back(kv);
     });
 
-    // Clear the tree and reset current size
-    delete tree;
-    tree = new RedBlackTree();
+    clear();
+    return kvPairs;
+}
+
+void Memtable::clear() {
+    // Start a new tree and reset current size; open iterators keep the old one
+    tree = std::make_shared<RedBlackTree>();
+    rangeTombstones = RangeTombstoneList();
     currentSize = 0;
+    pinned = false;
+}
 
-    return kvPairs;
+std::shared_ptr<RedBlackTree> Memtable::pin() {
+    pinned = true;
+    return tree;
+}
+
+// Iterator over the current entries in key order
+std::unique_ptr<Iterator> Memtable::newIterator() const {
+    return std::make_unique<MemtableIterator>(tree);
 }
 
 
@@ -7,7 +7,11 @@
 #define MEMTABLE_H
 
 #include "RedBlackTree.h"
+#include "Iterator.h"
+#include "RangeTombstone.h"
+#include "MergeOperator.h"
 #include <filesystem>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -23,6 +27,19 @@ public:
     // Insert a key-value pair into the memtable
     void put(const KeyValueWrapper& kv);
 
+    // Fold a merge operand into the key's entry: onto its value, its deletion or an
+    // older operand (the entry then stays an operand)
+    void merge(const KeyValueWrapper& operand, const MergeOperator& mergeOperator);
+
+    // Entry merge() leaves for the key when it holds existing (empty = no entry) and range
+    // tombstones delete its versions up to rangeDeletedUpTo. Throws what the operator throws.
+    static KeyValueWrapper foldOperand(const KeyValueWrapper& existing, const KeyValueWrapper& operand,
+                                       uint64_t rangeDeletedUpTo, const MergeOperator& mergeOperator);
+
+    // Record a range deletion; it counts as one entry towards the threshold
+    void addRangeTombstone(const RangeTombstone& tombstone);
+    const RangeTombstoneList& getRangeTombstones() const { return rangeTombstones; }
+
     // Get a key-value pair from the memtable
     KeyValueWrapper get(const KeyValueWrapper& kv);
 
@@ -39,15 +56,31 @@ public:
     // Flush the memtable and return key-value pairs
     std::vector<KeyValueWrapper> flush();
 
+    // Drop every entry, e.g. after streaming them to an SST through newIterator()
+    void clear();
+
+    // Iterator over the current entries in key order
+    std::unique_ptr<Iterator> newIterator() const;
+
+    // Share the current entries with a snapshot: they stay unchanged for it, as the
+    // next put copies them into a new tree first
+    std::shared_ptr<RedBlackTree> pin();
+
 private:
-    // In-memory Red-Black Tree
-    RedBlackTree* tree;
+    // In-memory Red-Black Tree (shared with open iterators)
+    std::shared_ptr<RedBlackTree> tree;
+
+    // Range deletions written since the last flush
+    RangeTombstoneList rangeTombstones;
 
     // Threshold for flushing memtable
     int memtableSize;
 
     // Current number of entries in the memtable
     int currentSize;
+
+    // The tree is shared with a snapshot and must not be modified
+    bool pinned = false;
 };
 
 #endif // MEMTABLE_H
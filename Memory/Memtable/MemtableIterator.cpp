@@ -0,0 +1,106 @@
+//
+// MemtableIterator.cpp
+//
+
+#include "MemtableIterator.h"
+#include <stdexcept>
+
+MemtableIterator::MemtableIterator(std::shared_ptr<RedBlackTree> tree)
+    : tree(std::move(tree)) {}
+
+bool MemtableIterator::Valid() const {
+    return node != nullptr;
+}
+
+void MemtableIterator::SeekToFirst() {
+    node = tree->getRoot();
+    while (node != nullptr && node->left != nullptr) {
+        node = node->left;
+    }
+}
+
+void MemtableIterator::SeekToLast() {
+    node = tree->getRoot();
+    while (node != nullptr && node->right != nullptr) {
+        node = node->right;
+    }
+}
+
+void MemtableIterator::Seek(const KeyValueWrapper& target) {
+    // Smallest node with key >= target
+    TreeNode* candidate = nullptr;
+    TreeNode* current = tree->getRoot();
+    while (current != nullptr) {
+        if (current->keyValue < target) {
+            current = current->right;
+        } else {
+            candidate = current;
+            current = current->left;
+        }
+    }
+    node = candidate;
+}
+
+void MemtableIterator::SeekForPrev(const KeyValueWrapper& target) {
+    // Largest node with key <= target
+    TreeNode* candidate = nullptr;
+    TreeNode* current = tree->getRoot();
+    while (current != nullptr) {
+        if (target < current->keyValue) {
+            current = current->left;
+        } else {
+            candidate = current;
+            current = current->right;
+        }
+    }
+    node = candidate;
+}
+
+void MemtableIterator::Next() {
+    if (node == nullptr) {
+        throw std::logic_error("MemtableIterator::Next() called on an invalid iterator");
+    }
+    // In-order successor: leftmost node of the right subtree, or the first
+    // ancestor reached from a left child
+    if (node->right != nullptr) {
+        node = node->right;
+        while (node->left != nullptr) {
+            node = node->left;
+        }
+        return;
+    }
+    TreeNode* parent = node->parent;
+    while (parent != nullptr && node == parent->right) {
+        node = parent;
+        parent = parent->parent;
+    }
+    node = parent;
+}
+
+void MemtableIterator::Prev() {
+    if (node == nullptr) {
+        throw std::logic_error("MemtableIterator::Prev() called on an invalid iterator");
+    }
+    // In-order predecessor: rightmost node of the left subtree, or the first
+    // ancestor reached from a right child
+    if (node->left != nullptr) {
+        node = node->left;
+        while (node->right != nullptr) {
+            node = node->right;
+        }
+        return;
+    }
+    TreeNode* parent = node->parent;
+    while (parent != nullptr && node == parent->left) {
+        node = parent;
+        parent = parent->parent;
+    }
+    node = parent;
+}
+
+const KeyValueWrapper& MemtableIterator::entry() const {
+    if (node == nullptr) {
+        throw std::logic_error("MemtableIterator::entry() called on an invalid iterator");
+    }
+    return node->keyValue;
+}
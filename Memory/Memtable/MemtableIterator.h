@@ -0,0 +1,32 @@
+//
+// MemtableIterator.h
+//
+
+#ifndef MEMTABLE_ITERATOR_H
+#define MEMTABLE_ITERATOR_H
+
+#include "Iterator.h"
+#include "RedBlackTree.h"
+#include <memory>
+
+// In-order iterator over the memtable's red-black tree, walking parent pointers.
+// Holds the tree, so a memtable flush does not invalidate it.
+class MemtableIterator : public Iterator {
+public:
+    explicit MemtableIterator(std::shared_ptr<RedBlackTree> tree);
+
+    bool Valid() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const KeyValueWrapper& target) override;
+    void SeekForPrev(const KeyValueWrapper& target) override;
+    void Next() override;
+    void Prev() override;
+    const KeyValueWrapper& entry() const override;
+
+private:
+    std::shared_ptr<RedBlackTree> tree;
+    TreeNode* node = nullptr;
+};
+
+#endif // MEMTABLE_ITERATOR_H
@@ -0,0 +1,191 @@
+//
+// AsyncPageReader.cpp
+//
+
+#include "AsyncPageReader.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+AsyncPageReader::AsyncPageReader(const std::string& fileName, size_t pageSize, size_t queueDepth)
+    : fileName(fileName), pageSize(pageSize), queueDepth(queueDepth == 0 ? 1 : queueDepth) {
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("AsyncPageReader: Failed to open file " + fileName + ": " + std::strerror(errno));
+    }
+    if (this->queueDepth == 1) {
+        return;
+    }
+
+#ifdef VELOXDB_HAVE_LIBURING
+    if (io_uring_queue_init(static_cast<unsigned>(this->queueDepth), &ring, 0) == 0) {
+        backend = Backend::IO_URING;
+        return;
+    }
+    // io_uring unavailable (old kernel or disabled); fall back to threads
+#endif
+    backend = Backend::THREAD_POOL;
+    startWorkers();
+}
+
+AsyncPageReader::~AsyncPageReader() {
+    if (backend == Backend::THREAD_POOL) {
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            stopping = true;
+        }
+        taskAvailable.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+#ifdef VELOXDB_HAVE_LIBURING
+    if (backend == Backend::IO_URING) {
+        io_uring_queue_exit(&ring);
+    }
+#endif
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+std::vector<std::vector<char>> AsyncPageReader::readPages(const std::vector<uint64_t>& offsets) {
+    std::vector<std::vector<char>> buffers(offsets.size(), std::vector<char>(pageSize));
+
+    switch (backend) {
+        case Backend::SYNC:
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                readPage(offsets[i], buffers[i]);
+            }
+            break;
+
+        case Backend::THREAD_POOL: {
+            std::vector<std::future<void>> pending;
+            pending.reserve(offsets.size());
+            {
+                std::lock_guard<std::mutex> lock(taskMutex);
+                for (size_t i = 0; i < offsets.size(); ++i) {
+                    std::packaged_task<void()> task([this, offset = offsets[i], &buffer = buffers[i]] {
+                        readPage(offset, buffer);
+                    });
+                    pending.push_back(task.get_future());
+                    tasks.push_back(std::move(task));
+                }
+            }
+            taskAvailable.notify_all();
+            // Wait for every read before rethrowing, since the tasks write into buffers
+            for (auto& future : pending) {
+                future.wait();
+            }
+            for (auto& future : pending) {
+                future.get();
+            }
+            break;
+        }
+
+        case Backend::IO_URING:
+#ifdef VELOXDB_HAVE_LIBURING
+            readPagesIoUring(offsets, buffers);
+#endif
+            break;
+    }
+    return buffers;
+}
+
+void AsyncPageReader::readPage(uint64_t offset, std::vector<char>& buffer) const {
+    size_t done = 0;
+    while (done < pageSize) {
+        ssize_t n = ::pread(fd, buffer.data() + done, pageSize - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("AsyncPageReader: Failed to read page at offset " + std::to_string(offset)
+                                     + " in file " + fileName);
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+void AsyncPageReader::startWorkers() {
+    for (size_t i = 0; i < queueDepth; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+void AsyncPageReader::workerLoop() {
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(taskMutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+#ifdef VELOXDB_HAVE_LIBURING
+void AsyncPageReader::readPagesIoUring(const std::vector<uint64_t>& offsets,
+                                       std::vector<std::vector<char>>& buffers) {
+    std::lock_guard<std::mutex> lock(ringMutex);
+
+    size_t submitted = 0;
+    size_t completed = 0;
+    size_t inFlight = 0;
+    std::string error;
+    while (completed < offsets.size()) {
+        // Keep the ring full
+        while (submitted < offsets.size() && inFlight < queueDepth) {
+            struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+            if (sqe == nullptr) {
+                break;
+            }
+            io_uring_prep_read(sqe, fd, buffers[submitted].data(), static_cast<unsigned>(pageSize),
+                               offsets[submitted]);
+            io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(submitted)));
+            submitted++;
+            inFlight++;
+        }
+
+        int ret = io_uring_submit_and_wait(&ring, 1);
+        if (ret < 0 && ret != -EINTR) {
+            // Nothing more can complete; the submitted reads were not accepted
+            throw std::runtime_error("AsyncPageReader: io_uring submit failed: " + std::string(std::strerror(-ret)));
+        }
+
+        struct io_uring_cqe* cqe;
+        unsigned head;
+        unsigned seen = 0;
+        io_uring_for_each_cqe(&ring, head, cqe) {
+            size_t i = static_cast<size_t>(reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe)));
+            if (cqe->res < 0) {
+                error = std::strerror(-cqe->res);
+            } else if (static_cast<size_t>(cqe->res) < pageSize) {
+                // Short read: finish the page synchronously
+                try {
+                    std::vector<char> rest(pageSize);
+                    readPage(offsets[i], rest);
+                    buffers[i].swap(rest);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+            }
+            seen++;
+        }
+        io_uring_cq_advance(&ring, seen);
+        completed += seen;
+        inFlight -= seen;
+    }
+
+    if (!error.empty()) {
+        throw std::runtime_error("AsyncPageReader: Failed to read page in file " + fileName + ": " + error);
+    }
+}
+#endif
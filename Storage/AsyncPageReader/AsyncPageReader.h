@@ -0,0 +1,70 @@
+//
+// AsyncPageReader.h
+//
+
+#ifndef ASYNC_PAGE_READER_H
+#define ASYNC_PAGE_READER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef VELOXDB_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+// Reads many pages of one file with up to queueDepth reads in flight.
+//
+// Uses io_uring when VeloxDB is built with liburing and the kernel allows it;
+// otherwise a pool of queueDepth threads issues positional reads (pread).
+// With a queue depth of 1 the pages are read one after another by the caller.
+class AsyncPageReader {
+public:
+    enum class Backend { SYNC, THREAD_POOL, IO_URING };
+
+    AsyncPageReader(const std::string& fileName, size_t pageSize, size_t queueDepth);
+    ~AsyncPageReader();
+
+    // Read pageSize bytes at every offset; the i-th buffer holds offsets[i]'s page
+    std::vector<std::vector<char>> readPages(const std::vector<uint64_t>& offsets);
+
+    size_t getQueueDepth() const { return queueDepth; }
+    Backend getBackend() const { return backend; }
+
+    AsyncPageReader(const AsyncPageReader&) = delete;
+    AsyncPageReader& operator=(const AsyncPageReader&) = delete;
+
+private:
+    std::string fileName;
+    size_t pageSize;
+    size_t queueDepth;
+    Backend backend = Backend::SYNC;
+    int fd = -1;
+
+    // Thread pool backend
+    std::vector<std::thread> workers;
+    std::deque<std::packaged_task<void()>> tasks;
+    std::mutex taskMutex;
+    std::condition_variable taskAvailable;
+    bool stopping = false;
+
+    void startWorkers();
+    void workerLoop();
+    void readPage(uint64_t offset, std::vector<char>& buffer) const;
+
+#ifdef VELOXDB_HAVE_LIBURING
+    // io_uring backend; the ring is used by one batch at a time
+    struct io_uring ring;
+    std::mutex ringMutex;
+
+    void readPagesIoUring(const std::vector<uint64_t>& offsets, std::vector<std::vector<char>>& buffers);
+#endif
+};
+
+#endif // ASYNC_PAGE_READER_H
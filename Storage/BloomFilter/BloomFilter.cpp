@@ -6,6 +6,7 @@
 #include <functional>
 #include <cstring>
 #include <stdexcept>
+#include <algorithm>
 
 BloomFilter::BloomFilter(size_t m, size_t n)
     : numBits(m), expectedElements(n) {
@@ -94,30 +95,7 @@ std::vector<size_t> BloomFilter::hash(const KeyValueWrapper& kv) const {
     std::vector<size_t> hashValues(numHashFuncs);
 
     // Serialize the key to a string (only the key, not the value)
-    std::string keyString;
-
-    // Extract the key based on its type using key_case()
-    switch (kv.kv.key_case()) {
-        case KeyValue::kIntKey:
-            keyString = std::to_string(kv.kv.int_key());
-        break;
-        case KeyValue::kLongKey:
-            keyString = std::to_string(kv.kv.long_key());
-        break;
-        case KeyValue::kDoubleKey:
-            keyString = std::to_string(kv.kv.double_key());
-        break;
-        case KeyValue::kStringKey:
-            keyString = kv.kv.string_key();
-        break;
-        case KeyValue::kCharKey:
-            keyString = kv.kv.char_key();
-        break;
-        default:
-            // Handle error or empty key
-                keyString = "";
-        break;
-    }
+    std::string keyString = kv.getKeyString();
 
     // Seed for hash functions
     std::hash<std::string> hasher;
@@ -149,3 +127,27 @@ size_t BloomFilter::getSerializedSize() const {
     return size;
 }
 
+
+size_t BloomFilter::bitsForKeys(size_t numKeys, double bitsPerKey) {
+    if (bitsPerKey <= 0) {
+        throw std::invalid_argument("Bits per key must be greater than 0");
+    }
+    size_t m = static_cast<size_t>(std::ceil(static_cast<double>(numKeys) * bitsPerKey));
+    // Keep at least one byte so tiny pages still get a usable filter
+    return std::max<size_t>(m, 8);
+}
+
+size_t BloomFilter::serializedSizeForBits(size_t m) {
+    // numBits + numHashFuncs + expectedElements + bitArray
+    return sizeof(size_t) * 3 + (m + 7) / 8;
+}
+
+double BloomFilter::estimateFalsePositiveRate(double bitsPerKey) {
+    if (bitsPerKey <= 0) {
+        return 1.0;
+    }
+    // Same k as the constructor: k = round((m / n) * ln 2)
+    double k = std::max(1.0, std::round(bitsPerKey * std::log(2.0)));
+    // p = (1 - e^(-k / bitsPerKey))^k
+    return std::pow(1.0 - std::exp(-k / bitsPerKey), k);
+}
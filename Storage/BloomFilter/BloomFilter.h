@@ -41,6 +41,15 @@ public:
     // Get the estimated size of the serialized Bloom filter
     size_t getSerializedSize() const;
 
+    // Number of bits needed to hold numKeys keys at bitsPerKey (at least one byte)
+    static size_t bitsForKeys(size_t numKeys, double bitsPerKey);
+
+    // Serialized size of a filter with m bits, without building it
+    static size_t serializedSizeForBits(size_t m);
+
+    // Expected false positive rate at bitsPerKey with the optimal number of hash functions
+    static double estimateFalsePositiveRate(double bitsPerKey);
+
 private:
     size_t numBits;       // m - number of bits in the filter
     size_t numHashFuncs;  // k - number of hash functions
@@ -9,40 +9,91 @@
 #include <cmath>
 #include "KeyValue.h"
 #include "PageManager.h"
+#include "SstWriter.h"
 #include "BloomFilter.h"
+#include "XorFilter.h"
+#include "PrefixExtractor.h"
+#include "RangeTombstone.h"
+
+// Filter stored with an SST
+enum class SSTFilterType : uint8_t {
+    LEAF_BLOOM = 0, // Bloom filter inside every leaf page
+    XOR = 1         // One xor filter for the whole SST, stored after the tree
+};
+
+// Options used when writing a new SST
+struct SSTBuildOptions {
+    double bloomBitsPerKey = 10.0;
+    SSTFilterType filterType = SSTFilterType::LEAF_BLOOM;
+
+    // Capped prefix length for the prefix Bloom filter (0 = no prefix filter)
+    size_t prefixLength = 0;
+    double prefixBloomBitsPerKey = 10.0;
+
+    // Writes are buffered writeBufferSize bytes at a time; with bytesPerSync > 0
+    // writeback starts every bytesPerSync bytes instead of all at the final fsync
+    size_t writeBufferSize = SstWriter::DEFAULT_BUFFER_SIZE;
+    size_t bytesPerSync = 0;
+
+    // Serialize and write pages on a background thread while the next ones are built
+    bool pipelinedWrites = false;
+
+    // Budget the writes are charged to (none = unlimited)
+    std::shared_ptr<RateLimiter> rateLimiter;
+    RateLimiter::Priority ioPriority = RateLimiter::Priority::HIGH;
+};
 
 class DiskBTree {
 public:
-    // Constructor for building a new B+ tree from memtable data
-    DiskBTree(const std::string& sstFileName, const std::vector<KeyValueWrapper>& keyValues, size_t pageSize = 4096);
+    // Default leaf Bloom filter budget (bits per key)
+    static constexpr double DEFAULT_BLOOM_BITS_PER_KEY = 10.0;
+
+    // Constructor for building a new B+ tree from sorted, distinct entries (streamed through SSTBuilder)
+    DiskBTree(const std::string& sstFileName, const std::vector<KeyValueWrapper>& keyValues, size_t pageSize = 4096,
+              const SSTBuildOptions& options = SSTBuildOptions());
 
     // Constructor for opening an existing SST file
     DiskBTree(const std::string& sstFileName);
 
-    // New constructor for building a B+ tree from existing leaf pages
-    DiskBTree(const std::string& sstFileName, const std::string& leafsFileName, const std::vector<KeyValueWrapper>& leafPageSmallestKeys, int numOfPages, int totalKvs);
-
-    // Destructor
-    ~DiskBTree();
-
     // Get the SST file name
     std::string getFileName() const;
 
     // Set buffer pool parameters
     void setBufferPoolParameters(size_t capacity, EvictionPolicy policy);
+    // Cache pages in a buffer pool shared with other SSTs
+    void setBufferPool(std::shared_ptr<BufferPool> pool) { pageManager->setBufferPool(std::move(pool)); }
 
     // Get cache hit count
     long long getCacheHit() const;
 
+    // Number of pages read from this SST
+    long long getPageReads() const { return pageManager->getPageReads(); }
+
     // Search for a key in the B+ tree
     KeyValueWrapper* search(const KeyValueWrapper& kv);
 
+    // Look up sorted, distinct keys together; results[i] is keys[i]'s entry or an empty
+    // KeyValueWrapper. Keys are probed against the xor filter first, then the tree is
+    // descended once, reading each internal and leaf page on the keys' paths once.
+    void multiSearch(const std::vector<KeyValueWrapper>& keys, std::vector<KeyValueWrapper>& results);
+
     // Scan keys within a range
     void scan(const KeyValueWrapper& startKey, const KeyValueWrapper& endKey, std::vector<KeyValueWrapper>& result);
 
+    // Offset of the leaf page where kv would be (0 if the tree has no leaf);
+    // keys >= kv may start on the following leaf
+    uint64_t findLeafOffset(const KeyValueWrapper& kv) const;
+
+    // Separator keys of the root node, in order (empty if the root is a leaf); they split
+    // the SST into key ranges of similar size
+    std::vector<KeyValueWrapper> getFenceKeys() const;
+
     // PageManager for disk I/O
     std::shared_ptr<PageManager> pageManager;
 
+    // Page size of the SST file
+    size_t getPageSize() const { return pageSize; }
+
     // Leaf node begin and end offsets
     uint64_t getLeafBeginOffset() const { return leafBeginOffset; };
     uint64_t getLeafEndOffset() const { return leafEndOffset; };
@@ -50,11 +101,43 @@ public:
     // Method to get the number of key-value pairs
     size_t getNumberOfKeyValues() const { return totalKeyValueCount; }
 
+    // Number of tombstones among the key-value pairs
+    size_t getNumTombstones() const { return numTombstones; }
+
+    // Earliest expiry time among the key-value pairs (0 = none expires)
+    uint64_t getEarliestExpiry() const { return earliestExpiry; }
+
+    // Range deletions stored with this SST (kept in memory)
+    const RangeTombstoneList& getRangeTombstones() const { return rangeTombstones; }
+
+    // Filter footprint of this SST
+    SSTFilterType getFilterType() const { return filterType; }
+    size_t getFilterBytes() const { return filterBytes; }
+    double getFilterBitsPerKey() const { return filterBitsPerKey; }
+
+    // False only if no key of the SST starts with prefix
+    bool mayContainPrefix(const std::string& prefix) const;
+    size_t getPrefixLength() const { return prefixExtractor.getLength(); }
+
+    // Page reads kept in flight by batched lookups and iterator readahead
+    void setIOQueueDepth(size_t depth) { pageManager->setIOQueueDepth(depth); }
+    size_t getIOQueueDepth() const { return pageManager->getIOQueueDepth(); }
+
+    // Read pages with pread or from a memory mapping of the SST
+    void setReadMode(SSTReadMode mode) { pageManager->setReadMode(mode); }
+    SSTReadMode getReadMode() const { return pageManager->getReadMode(); }
+
     // update file name when merge to a new level
     void updateSstFileName(const std::string &newLevelFilename) {
+        size_t ioQueueDepth = pageManager->getIOQueueDepth();
+        SSTReadMode readMode = pageManager->getReadMode();
+        std::shared_ptr<BufferPool> bufferPool = pageManager->getBufferPool();
         sstFileName = newLevelFilename;
         pageManager->close();
         pageManager = std::make_shared<PageManager>(sstFileName);
+        pageManager->setIOQueueDepth(ioQueueDepth);
+        pageManager->setReadMode(readMode);
+        pageManager->setBufferPool(std::move(bufferPool));
     };
 
     std::string getSstFilename() const { return sstFileName; };
@@ -70,65 +153,41 @@ private:
     uint64_t leafBeginOffset;
     uint64_t leafEndOffset;
 
-    size_t totalKeyValueCount;
-    // File name of the SST file
-    std::string sstFileName;
-
-    // Page size
-    size_t pageSize = 4096;
-
-    // Degree and height of the B+ tree
-    size_t degree;
-    size_t height;
+    size_t totalKeyValueCount = 0;
+    size_t numTombstones = 0;
+    uint64_t earliestExpiry = 0;
 
-    // Fields used during SST building
-    // BTreeNode struct representing different types of nodes
-    struct BTreeNode {
-        bool isLeaf;
-        std::vector<KeyValueWrapper> keys;
-        std::vector<BTreeNode*> children;        // For internal nodes
-        std::vector<size_t> leafPageIndices;     // For nodes pointing to leaf pages
+    // Filter type, bits per key and total serialized filter bytes
+    SSTFilterType filterType = SSTFilterType::LEAF_BLOOM;
+    double filterBitsPerKey = DEFAULT_BLOOM_BITS_PER_KEY;
+    size_t filterBytes = 0;
 
-        uint64_t offset; // Offset of the node in the SST file
-
-        BTreeNode(bool leaf) : isLeaf(leaf), offset(0) {}
-    };
+    // SST-wide xor filter (loaded in memory when filterType is XOR)
+    std::unique_ptr<XorFilter> xorFilter;
 
-    // Vector of leaf pages (used in the original constructor)
-    std::vector<Page> leafPages;
+    // Prefix Bloom filter over the distinct key prefixes of the SST
+    PrefixExtractor prefixExtractor;
+    std::unique_ptr<BloomFilter> prefixFilter;
 
-    // Vector of smallest keys from each leaf page
-    std::vector<KeyValueWrapper> leafPageSmallestKeys;
+    RangeTombstoneList rangeTombstones;
 
-    // Root node of the tree
-    BTreeNode* root;
-
-    // For memory management
-    std::vector<BTreeNode*> allNodes; // To keep track of all nodes for deletion
-
-    // Levels of the tree, from leaf level upwards
-    std::vector<std::vector<BTreeNode*>> levels;
-
-    // Method to split input keyValues into leaf pages
-    void splitInputPairs(const std::vector<KeyValueWrapper>& keyValues);
-
-    // Method to compute degree and height
-    void computeDegreeAndHeight();
-
-    // New method to compute degree and height from leaf keys
-    void computeDegreeAndHeightFromLeafKeys(const std::vector<KeyValueWrapper>& leafPageSmallestKeys);
+    // File name of the SST file
+    std::string sstFileName;
 
-    // Method to build the tree
-    void buildTree();
+    // Page size
+    size_t pageSize = 4096;
 
-    // New method to build the tree from leaf page keys and offsets
-    void buildTreeFromLeafPageKeys(const std::vector<KeyValueWrapper>& leafPageSmallestKeys, const std::vector<uint64_t>& leafPageOffsets);
+    // Stream keyValues into a new SST file; returns its name
+    static const std::string& writeSST(const std::string& sstFileName, const std::vector<KeyValueWrapper>& keyValues,
+                                       size_t pageSize, const SSTBuildOptions& options);
 
-    // Method to write the tree into the SST file
-    void writeTreeToSST();
+    // Load the SST-wide filters and range tombstones described by the metadata page
+    void readFilterRegion(const Page& metadataPage);
 
-    // New method to write the tree into the SST file using leaf page offsets
-    void writeTreeToSSTWithLeafOffsets(const std::vector<uint64_t>& leafPageOffsets);
+    // Resolve keys[pending] in the subtree rooted at page; returns the pending keys that
+    // continue on the next leaf (past the last entry of their leaf)
+    std::vector<size_t> multiSearchPage(const Page& currentPage, const std::vector<KeyValueWrapper>& keys,
+                                        const std::vector<size_t>& pending, std::vector<KeyValueWrapper>& results);
 
 
 };
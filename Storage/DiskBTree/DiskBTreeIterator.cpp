@@ -0,0 +1,164 @@
+//
+// DiskBTreeIterator.cpp
+//
+
+#include "DiskBTreeIterator.h"
+#include <algorithm>
+#include <stdexcept>
+
+DiskBTreeIterator::DiskBTreeIterator(std::shared_ptr<DiskBTree> sst)
+    : sst(std::move(sst)) {}
+
+DiskBTreeIterator::~DiskBTreeIterator() {
+    // Back to the point lookup hint
+    if (advisedSequential) {
+        sst->pageManager->adviseAccess(sst->getLeafBeginOffset(), leafRangeLength(), false);
+    }
+}
+
+bool DiskBTreeIterator::Valid() const {
+    return valid;
+}
+
+void DiskBTreeIterator::SeekToFirst() {
+    valid = sst->getLeafBeginOffset() != 0;
+    if (!valid) {
+        return;
+    }
+    readLeaf(sst->getLeafBeginOffset());
+    index = 0;
+    skipExhaustedLeaves();
+}
+
+void DiskBTreeIterator::SeekToLast() {
+    valid = sst->getLeafEndOffset() != 0;
+    if (!valid) {
+        return;
+    }
+    readLeaf(sst->getLeafEndOffset());
+    index = leafPage->getLeafEntries().size();
+    skipExhaustedLeavesBackward();
+}
+
+void DiskBTreeIterator::Seek(const KeyValueWrapper& target) {
+    uint64_t offset = sst->findLeafOffset(target);
+    valid = offset != 0;
+    if (!valid) {
+        return;
+    }
+    readLeaf(offset);
+    const std::vector<KeyValueWrapper>& entries = leafPage->getLeafEntries();
+    index = std::lower_bound(entries.begin(), entries.end(), target) - entries.begin();
+    skipExhaustedLeaves();
+}
+
+void DiskBTreeIterator::SeekForPrev(const KeyValueWrapper& target) {
+    Seek(target);
+    if (!valid) {
+        // Every key is smaller than target
+        SeekToLast();
+    } else if (target < entry()) {
+        Prev();
+    }
+}
+
+void DiskBTreeIterator::Next() {
+    if (!valid) {
+        throw std::logic_error("DiskBTreeIterator::Next() called on an invalid iterator");
+    }
+    index++;
+    skipExhaustedLeaves();
+}
+
+void DiskBTreeIterator::Prev() {
+    if (!valid) {
+        throw std::logic_error("DiskBTreeIterator::Prev() called on an invalid iterator");
+    }
+    // index is one past the entry to move to
+    skipExhaustedLeavesBackward();
+}
+
+const KeyValueWrapper& DiskBTreeIterator::entry() const {
+    if (!valid) {
+        throw std::logic_error("DiskBTreeIterator::entry() called on an invalid iterator");
+    }
+    return leafPage->getLeafEntries()[index];
+}
+
+void DiskBTreeIterator::readLeaf(uint64_t offset, int direction) {
+    leafOffset = offset;
+    auto cached = readahead.find(offset);
+    if (cached != readahead.end()) {
+        leafPage = std::move(cached->second);
+        readahead.erase(cached);
+        return;
+    }
+
+    if (direction != 0 && !advisedSequential && sst->getReadMode() == SSTReadMode::MMAP) {
+        sst->pageManager->adviseAccess(sst->getLeafBeginOffset(), leafRangeLength(), true);
+        advisedSequential = true;
+    }
+
+    size_t depth = sst->getIOQueueDepth();
+    if (direction == 0 || depth <= 1 || sst->getReadMode() == SSTReadMode::MMAP) {
+        leafPage = std::make_unique<Page>(sst->pageManager->readPage(offset));
+        return;
+    }
+
+    // Leaves are laid out mostly in order, so the next pages in the walking direction
+    // are likely the next leaves; pages that turn out not to be leaves are dropped
+    readahead.clear();
+    std::vector<uint64_t> offsets;
+    uint64_t pageSize = sst->getPageSize();
+    for (size_t i = 0; i < depth; ++i) {
+        uint64_t distance = i * pageSize;
+        if (direction > 0 && offset + distance > sst->getLeafEndOffset()) break;
+        if (direction < 0 && (offset < distance || offset - distance < sst->getLeafBeginOffset())) break;
+        offsets.push_back(direction > 0 ? offset + distance : offset - distance);
+    }
+    std::vector<Page> pages = sst->pageManager->readPages(offsets);
+    leafPage = std::make_unique<Page>(std::move(pages[0]));
+    for (size_t i = 1; i < pages.size(); ++i) {
+        if (pages[i].getPageType() == Page::PageType::LEAF_NODE) {
+            readahead[offsets[i]] = std::make_unique<Page>(std::move(pages[i]));
+        }
+    }
+}
+
+uint64_t DiskBTreeIterator::leafRangeLength() const {
+    return sst->getLeafEndOffset() + sst->getPageSize() - sst->getLeafBeginOffset();
+}
+
+uint64_t DiskBTreeIterator::prevLeafOffset() const {
+    if (leafOffset == sst->getLeafBeginOffset()) {
+        return 0;
+    }
+    uint64_t offset = leafPage->getPrevLeafOffset();
+    // SSTs written before leaves were linked backwards store their leaves contiguously
+    return offset != 0 ? offset : leafOffset - sst->getPageSize();
+}
+
+void DiskBTreeIterator::skipExhaustedLeaves() {
+    while (valid && index >= leafPage->getLeafEntries().size()) {
+        uint64_t nextLeafOffset = leafPage->getNextLeafOffset();
+        if (nextLeafOffset == 0) {
+            valid = false;
+            return;
+        }
+        readLeaf(nextLeafOffset, 1);
+        index = 0;
+    }
+}
+
+void DiskBTreeIterator::skipExhaustedLeavesBackward() {
+    while (index == 0) {
+        uint64_t offset = prevLeafOffset();
+        if (offset == 0) {
+            valid = false;
+            return;
+        }
+        readLeaf(offset, -1);
+        index = leafPage->getLeafEntries().size();
+    }
+    index--;
+}
@@ -0,0 +1,63 @@
+//
+// DiskBTreeIterator.h
+//
+
+#ifndef DISK_BTREE_ITERATOR_H
+#define DISK_BTREE_ITERATOR_H
+
+#include "Iterator.h"
+#include "DiskBTree.h"
+#include <memory>
+#include <unordered_map>
+
+// Iterator over one SST: descends the internal nodes once per seek, then walks
+// the leaf chain one page at a time in either direction. Holds the SST, so compaction does not
+// invalidate it.
+class DiskBTreeIterator : public Iterator {
+public:
+    explicit DiskBTreeIterator(std::shared_ptr<DiskBTree> sst);
+    ~DiskBTreeIterator() override;
+
+    bool Valid() const override;
+    void SeekToFirst() override;
+    void SeekToLast() override;
+    void Seek(const KeyValueWrapper& target) override;
+    void SeekForPrev(const KeyValueWrapper& target) override;
+    void Next() override;
+    void Prev() override;
+    const KeyValueWrapper& entry() const override;
+
+private:
+    std::shared_ptr<DiskBTree> sst;
+
+    // Current leaf page, its offset and position in it
+    std::unique_ptr<Page> leafPage;
+    uint64_t leafOffset = 0;
+    size_t index = 0;
+    bool valid = false;
+
+    // Pages read ahead of the walk, by offset
+    std::unordered_map<uint64_t, std::unique_ptr<Page>> readahead;
+
+    // Whether the leaves of a memory-mapped SST were advised sequential
+    bool advisedSequential = false;
+
+    // Read the leaf at offset into leafPage. When walking (direction +1 / -1) with an I/O
+    // queue depth above 1, the following pages in that direction are read along with it;
+    // a memory-mapped SST instead has its leaves advised sequential and the kernel reads ahead.
+    void readLeaf(uint64_t offset, int direction = 0);
+
+    // Bytes from the first leaf to the end of the last one
+    uint64_t leafRangeLength() const;
+
+    // Offset of the leaf before the current one (0 if it is the first)
+    uint64_t prevLeafOffset() const;
+
+    // Move to the following leaves while the position is past the end of the page
+    void skipExhaustedLeaves();
+
+    // Move to the preceding leaves while the page has no entry at or before the position
+    void skipExhaustedLeavesBackward();
+};
+
+#endif // DISK_BTREE_ITERATOR_H
@@ -0,0 +1,194 @@
+//
+// SSTBuilder.cpp
+//
+
+#include "SSTBuilder.h"
+#include <algorithm>
+
+SSTBuilder::SSTBuilder(const std::string& fileName, const SSTBuildOptions& options, size_t pageSize)
+    : fileName(fileName), options(options), prefixExtractor(options.prefixLength), pageSize(pageSize),
+      writer(fileName, pageSize, options.writeBufferSize, options.bytesPerSync, options.pipelinedWrites) {
+    writer.setRateLimiter(options.rateLimiter, options.ioPriority);
+    leafSize = leaf->getBaseSize();
+    // Reserve offset 0 for the metadata page
+    writer.appendPage(Page(Page::PageType::SST_METADATA));
+}
+
+void SSTBuilder::add(const KeyValueWrapper& kv) {
+    const bool leafBloom = options.filterType == SSTFilterType::LEAF_BLOOM;
+    size_t numKeysInPage = leaf->getLeafEntries().size();
+    size_t kvSize = kv.getSerializedSize();
+    // The Bloom filter is sized by the final key count, so reserve room for it up front
+    size_t filterSize = leafBloom ? Page::estimateLeafBloomFilterSize(numKeysInPage + 1, options.bloomBitsPerKey) : 0;
+    if (numKeysInPage > 0 && leafSize + kvSize + filterSize > pageSize) {
+        writeLeaf(&kv);
+    }
+
+    leaf->addLeafEntry(kv);
+    leafSize += kvSize;
+    numEntries++;
+    if (kv.isTombstone()) {
+        numTombstones++;
+    }
+    if (kv.expiresAt != 0 && (earliestExpiry == 0 || kv.expiresAt < earliestExpiry)) {
+        earliestExpiry = kv.expiresAt;
+    }
+
+    if (options.filterType == SSTFilterType::XOR) {
+        keyHashes.push_back(XorFilter::hashKey(kv));
+    }
+    // Keys are sorted, so equal prefixes are adjacent
+    if (prefixExtractor.inDomain(kv)) {
+        std::string prefix = prefixExtractor.transform(kv);
+        if (keyPrefixes.empty() || keyPrefixes.back() != prefix) {
+            keyPrefixes.push_back(std::move(prefix));
+        }
+    }
+}
+
+void SSTBuilder::writeLeaf(const KeyValueWrapper* nextKey) {
+    // An SST without entries still gets one (empty) leaf
+    KeyValueWrapper separator = leaf->getLeafEntries().empty() ? KeyValueWrapper()
+                                                              : separatorOf(leaf->getLeafEntries().front());
+    makeRoom(0, separator);
+    uint64_t offset = writer.getOffset();
+    addChild(0, separator, offset);
+
+    uint64_t nextLeafOffset = 0;
+    if (nextKey != nullptr) {
+        nextLeafOffset = offset + pageSize * (1 + countPagesBefore(separatorOf(*nextKey)));
+    }
+    leaf->setPrevLeafOffset(prevLeafOffset);
+    leaf->setNextLeafOffset(nextLeafOffset);
+    if (options.filterType == SSTFilterType::LEAF_BLOOM) {
+        leaf->buildLeafBloomFilterFromEntries(options.bloomBitsPerKey);
+        filterBytes += leaf->getLeafBloomFilterSize();
+    }
+    writer.appendPage(std::move(leaf));
+
+    if (leafBeginOffset == 0) {
+        leafBeginOffset = offset;
+    }
+    leafEndOffset = offset;
+    prevLeafOffset = offset;
+    leaf = std::make_unique<Page>(Page::PageType::LEAF_NODE);
+    leafSize = leaf->getBaseSize();
+}
+
+KeyValueWrapper SSTBuilder::separatorOf(const KeyValueWrapper& kv) {
+    KeyValueWrapper separator = kv;
+    separator.kv.clear_value();
+    return separator;
+}
+
+bool SSTBuilder::wouldOverflow(size_t level, const KeyValueWrapper& key) const {
+    const InternalLevel& node = levels[level];
+    // A key costs its size prefix and bytes, plus the child offset after it
+    return node.numChildren > 0
+           && node.size + sizeof(uint32_t) + key.kv.ByteSizeLong() + sizeof(uint64_t) > pageSize;
+}
+
+void SSTBuilder::addChild(size_t level, const KeyValueWrapper& key, uint64_t childOffset) {
+    if (level == levels.size()) {
+        levels.emplace_back();
+    }
+    InternalLevel& node = levels[level];
+    if (node.numChildren == 0) {
+        node.lowKey = key;
+        node.size = node.page->getBaseSize();
+    } else {
+        node.page->addKey(key);
+        node.size += sizeof(uint32_t) + key.kv.ByteSizeLong();
+    }
+    node.page->addChildOffset(childOffset);
+    node.size += sizeof(uint64_t);
+    node.numChildren++;
+}
+
+void SSTBuilder::makeRoom(size_t level, const KeyValueWrapper& key) {
+    if (level < levels.size() && wouldOverflow(level, key)) {
+        closeNode(level);
+    }
+}
+
+void SSTBuilder::closeNode(size_t level) {
+    KeyValueWrapper lowKey = levels[level].lowKey;
+    // The parent may have to be written first; it does not hold this node yet
+    makeRoom(level + 1, lowKey);
+    uint64_t offset = writer.appendPage(std::move(levels[level].page));
+
+    size_t numWritten = levels[level].numWritten + 1;
+    levels[level] = InternalLevel();
+    levels[level].numWritten = numWritten;
+    addChild(level + 1, lowKey, offset);
+}
+
+size_t SSTBuilder::countPagesBefore(const KeyValueWrapper& key) const {
+    size_t count = 0;
+    KeyValueWrapper pushed = key;
+    for (size_t level = 0; level < levels.size() && wouldOverflow(level, pushed); ++level) {
+        count++;
+        pushed = levels[level].lowKey;
+    }
+    return count;
+}
+
+void SSTBuilder::finish() {
+    if (!leaf->getLeafEntries().empty() || leafBeginOffset == 0) {
+        writeLeaf(nullptr);
+    }
+
+    // Close the levels bottom up; the root is the only node of the top level
+    uint64_t rootOffset = 0;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        if (level + 1 == levels.size() && levels[level].numWritten == 0) {
+            rootOffset = writer.appendPage(std::move(levels[level].page));
+            break;
+        }
+        closeNode(level);
+    }
+    levels.clear();
+
+    Page metadataPage(Page::PageType::SST_METADATA);
+    double bitsPerKey = options.bloomBitsPerKey;
+    writeFilterRegion(metadataPage, bitsPerKey);
+    if (!rangeTombstones.empty()) {
+        std::vector<char> block = rangeTombstones.serialize();
+        uint64_t regionOffset = writer.appendRegion(block.data(), block.size());
+        metadataPage.setSSTRangeTombstoneRegion(regionOffset, block.size());
+    }
+    metadataPage.setMetadata(rootOffset, leafBeginOffset, leafEndOffset, fileName);
+    metadataPage.setSSTFilterStats(numEntries, filterBytes, bitsPerKey);
+    metadataPage.setSSTNumTombstones(numTombstones);
+    metadataPage.setSSTEarliestExpiry(earliestExpiry);
+    writer.rewritePage(0, metadataPage);
+    writer.finish();
+}
+
+void SSTBuilder::writeFilterRegion(Page& metadataPage, double& bitsPerKey) {
+    if (options.filterType == SSTFilterType::XOR) {
+        // The SST is immutable, so the filter is built exactly once from all of its keys
+        XorFilter filter(std::move(keyHashes));
+        std::vector<char> filterData = filter.serialize();
+        uint64_t regionOffset = writer.appendRegion(filterData.data(), filterData.size());
+        metadataPage.setSSTFilterRegion(static_cast<uint8_t>(SSTFilterType::XOR), regionOffset, filterData.size());
+
+        filterBytes = filterData.size();
+        bitsPerKey = numEntries > 0 ? 8.0 * filterBytes / numEntries : 0;
+    }
+    keyHashes.clear();
+
+    if (options.prefixLength > 0) {
+        // One Bloom filter over the distinct prefixes of the SST
+        size_t numPrefixes = std::max<size_t>(keyPrefixes.size(), 1);
+        BloomFilter filter(BloomFilter::bitsForKeys(numPrefixes, options.prefixBloomBitsPerKey), numPrefixes);
+        for (const auto& prefix : keyPrefixes) {
+            filter.add(KeyValueWrapper(prefix, ""));
+        }
+        std::vector<char> filterData = filter.serialize();
+        uint64_t regionOffset = writer.appendRegion(filterData.data(), filterData.size());
+        metadataPage.setSSTPrefixFilterRegion(static_cast<uint32_t>(options.prefixLength), regionOffset,
+                                              filterData.size());
+    }
+    keyPrefixes.clear();
+}
@@ -0,0 +1,101 @@
+//
+// SSTBuilder.h
+//
+
+#ifndef SST_BUILDER_H
+#define SST_BUILDER_H
+
+#include "DiskBTree.h"
+#include "SstWriter.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+// Builds an SST in one pass from entries added in increasing key order.
+//
+// Every page is written once, front to back. A leaf is written as soon as it is
+// full; each internal level keeps only the node being filled, which is written
+// when the next child would not fit, so internal pages end up between the leaves.
+// The offset of the next leaf is still known when a leaf is written: it is right
+// after the internal pages the next leaf's separator key will push out, and that
+// count is fixed by the current nodes. The SST-wide filters and the metadata page
+// are written by finish(); open the result with DiskBTree(fileName).
+class SSTBuilder {
+public:
+    SSTBuilder(const std::string& fileName, const SSTBuildOptions& options = SSTBuildOptions(),
+               size_t pageSize = 4096);
+
+    // Append the next entry; keys must be strictly increasing
+    void add(const KeyValueWrapper& kv);
+
+    // Range tombstones stored in the SST's range tombstone block
+    void addRangeTombstones(const RangeTombstoneList& tombstones) { rangeTombstones.add(tombstones); }
+
+    // Write the last leaf, the open internal nodes, the filters, the range tombstones and
+    // the metadata page, then sync
+    void finish();
+
+    size_t getNumEntries() const { return numEntries; }
+    size_t getNumTombstones() const { return numTombstones; }
+    uint64_t getEarliestExpiry() const { return earliestExpiry; }
+
+    // Time of the background write stage with options.pipelinedWrites (see SstWriter)
+    double getWriteBusySeconds() const { return writer.getBusySeconds(); }
+    double getWriteQueueWaitSeconds() const { return writer.getQueueWaitSeconds(); }
+
+private:
+    // The node being filled on one internal level
+    struct InternalLevel {
+        std::unique_ptr<Page> page = std::make_unique<Page>(Page::PageType::INTERNAL_NODE);
+        KeyValueWrapper lowKey;     // smallest key below the node, its separator in the parent
+        size_t size = 0;            // serialized bytes
+        size_t numChildren = 0;
+        size_t numWritten = 0;      // nodes of this level already written
+    };
+
+    std::string fileName;
+    SSTBuildOptions options;
+    PrefixExtractor prefixExtractor;
+    size_t pageSize;
+    SstWriter writer;
+
+    // Leaf being filled
+    std::unique_ptr<Page> leaf = std::make_unique<Page>(Page::PageType::LEAF_NODE);
+    size_t leafSize;
+    uint64_t prevLeafOffset = 0;
+    uint64_t leafBeginOffset = 0;
+    uint64_t leafEndOffset = 0;
+
+    // Internal levels, lowest first
+    std::vector<InternalLevel> levels;
+
+    size_t numEntries = 0;
+    RangeTombstoneList rangeTombstones;
+    size_t numTombstones = 0;
+    uint64_t earliestExpiry = 0;
+    size_t filterBytes = 0;
+
+    // Collected for the SST-wide filters
+    std::vector<uint64_t> keyHashes;
+    std::vector<std::string> keyPrefixes;
+
+    // Write the current leaf; nextKey is the first key of the following leaf (nullptr if none)
+    void writeLeaf(const KeyValueWrapper* nextKey);
+
+    // Separator keys only need the key
+    static KeyValueWrapper separatorOf(const KeyValueWrapper& kv);
+
+    bool wouldOverflow(size_t level, const KeyValueWrapper& key) const;
+    void addChild(size_t level, const KeyValueWrapper& key, uint64_t childOffset);
+    // Write the node of a level if adding key to it would overflow the page
+    void makeRoom(size_t level, const KeyValueWrapper& key);
+    void closeNode(size_t level);
+    // Number of pages makeRoom(0, key) would write
+    size_t countPagesBefore(const KeyValueWrapper& key) const;
+
+    // Write the xor and prefix filters after the tree and record them in the metadata page
+    void writeFilterRegion(Page& metadataPage, double& bitsPerKey);
+};
+
+#endif // SST_BUILDER_H
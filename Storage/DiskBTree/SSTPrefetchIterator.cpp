@@ -0,0 +1,161 @@
+//
+// SSTPrefetchIterator.cpp
+//
+
+#include "SSTPrefetchIterator.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+SSTPrefetchIterator::SSTPrefetchIterator(std::shared_ptr<DiskBTree> sst, const KeyValueWrapper* upperBound)
+    : sst(std::move(sst)) {
+    if (upperBound) {
+        hasUpperBound = true;
+        this->upperBound = *upperBound;
+    }
+}
+
+SSTPrefetchIterator::~SSTPrefetchIterator() {
+    stop();
+}
+
+void SSTPrefetchIterator::SeekToFirst() {
+    start(sst->getLeafBeginOffset());
+}
+
+void SSTPrefetchIterator::Seek(const KeyValueWrapper& target) {
+    start(sst->findLeafOffset(target));
+    while (valid && entry() < target) {
+        Next();
+    }
+}
+
+void SSTPrefetchIterator::Next() {
+    if (!valid) {
+        throw std::logic_error("SSTPrefetchIterator::Next() called on an invalid iterator");
+    }
+    index++;
+    skipExhausted();
+}
+
+const KeyValueWrapper& SSTPrefetchIterator::entry() const {
+    if (!valid) {
+        throw std::logic_error("SSTPrefetchIterator::entry() called on an invalid iterator");
+    }
+    return window[pageIndex].getLeafEntries()[index];
+}
+
+void SSTPrefetchIterator::SeekToLast() {
+    throw std::logic_error("SSTPrefetchIterator only moves forward");
+}
+
+void SSTPrefetchIterator::SeekForPrev(const KeyValueWrapper&) {
+    throw std::logic_error("SSTPrefetchIterator only moves forward");
+}
+
+void SSTPrefetchIterator::Prev() {
+    throw std::logic_error("SSTPrefetchIterator only moves forward");
+}
+
+void SSTPrefetchIterator::start(uint64_t leafOffset) {
+    stop();
+    if (leafOffset == 0) {
+        return;
+    }
+    queue = std::make_unique<BoundedQueue<std::vector<Page>>>(2);
+    reader = std::thread(&SSTPrefetchIterator::readLeaves, this, leafOffset);
+    valid = true;
+    window.clear();
+    pageIndex = 0;
+    index = 0;
+    skipExhausted();
+}
+
+void SSTPrefetchIterator::stop() {
+    valid = false;
+    if (!queue) {
+        return;
+    }
+    queue->close();
+    reader.join();
+    consumerWaitSeconds += queue->getPopWaitSeconds();
+    queue.reset();
+    window.clear();
+}
+
+void SSTPrefetchIterator::readLeaves(uint64_t leafOffset) {
+    auto begin = std::chrono::steady_clock::now();
+    const uint64_t pageSize = sst->getPageSize();
+    const bool mapped = sst->getReadMode() == SSTReadMode::MMAP;
+    const uint64_t leafRangeLength = sst->getLeafEndOffset() + pageSize - sst->getLeafBeginOffset();
+    if (mapped) {
+        sst->pageManager->adviseAccess(sst->getLeafBeginOffset(), leafRangeLength, true);
+    }
+    try {
+        while (leafOffset != 0) {
+            // The leaves are in file order, mixed with internal pages
+            std::vector<uint64_t> offsets;
+            for (uint64_t offset = leafOffset; offsets.size() < WINDOW_PAGES && offset <= sst->getLeafEndOffset();
+                 offset += pageSize) {
+                offsets.push_back(offset);
+            }
+            std::vector<Page> pages = sst->pageManager->readPages(offsets);
+
+            // Follow the leaf chain through the window
+            std::vector<Page> leaves;
+            bool reachedBound = false;
+            for (size_t i = 0; i < pages.size() && leafOffset == offsets[i] && !reachedBound; ++i) {
+                if (pages[i].getPageType() != Page::PageType::LEAF_NODE) {
+                    continue;
+                }
+                const std::vector<KeyValueWrapper>& entries = pages[i].getLeafEntries();
+                reachedBound = hasUpperBound && !entries.empty() && !(entries.back() < upperBound);
+                leafOffset = reachedBound ? 0 : pages[i].getNextLeafOffset();
+                leaves.push_back(std::move(pages[i]));
+                // Skip the internal pages up to the next leaf
+                while (i + 1 < pages.size() && leafOffset > offsets[i + 1]) {
+                    ++i;
+                }
+            }
+            if (leaves.empty()) {
+                throw std::runtime_error("SSTPrefetchIterator: No leaf at offset " + std::to_string(leafOffset)
+                                         + " in " + sst->getFileName());
+            }
+            if (!queue->push(std::move(leaves))) {
+                break;
+            }
+        }
+    } catch (...) {
+        readerError = std::current_exception();
+    }
+    queue->close();
+    if (mapped) {
+        sst->pageManager->adviseAccess(sst->getLeafBeginOffset(), leafRangeLength, false);
+    }
+    readBusySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count()
+                       - queue->getPushWaitSeconds();
+}
+
+void SSTPrefetchIterator::skipExhausted() {
+    while (valid) {
+        if (pageIndex < window.size() && index < window[pageIndex].getLeafEntries().size()) {
+            return;
+        }
+        if (pageIndex + 1 < window.size()) {
+            pageIndex++;
+            index = 0;
+            continue;
+        }
+        if (!queue->pop(window)) {
+            stop();
+            if (readerError) {
+                std::exception_ptr error = readerError;
+                readerError = nullptr;
+                std::rethrow_exception(error);
+            }
+            return;
+        }
+        pageIndex = 0;
+        index = 0;
+    }
+}
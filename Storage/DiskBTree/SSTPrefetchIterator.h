@@ -0,0 +1,72 @@
+//
+// SSTPrefetchIterator.h
+//
+
+#ifndef SST_PREFETCH_ITERATOR_H
+#define SST_PREFETCH_ITERATOR_H
+
+#include "Iterator.h"
+#include "DiskBTree.h"
+#include "BoundedQueue.h"
+#include <memory>
+#include <thread>
+#include <exception>
+#include <vector>
+
+// Forward-only iterator over one SST for compaction. After a seek, a reader thread
+// walks the leaf chain ahead of the consumer: it reads a window of pages at a time
+// (one batched read with an I/O queue depth above 1), decodes the leaves in it and
+// queues them, so reading and decoding overlap the merge. The queue holds two windows.
+class SSTPrefetchIterator : public Iterator {
+public:
+    // Pages read per window
+    static constexpr size_t WINDOW_PAGES = 16;
+
+    // With upperBound, reading stops after the first leaf reaching *upperBound
+    explicit SSTPrefetchIterator(std::shared_ptr<DiskBTree> sst, const KeyValueWrapper* upperBound = nullptr);
+    ~SSTPrefetchIterator() override;
+
+    bool Valid() const override { return valid; }
+    void SeekToFirst() override;
+    void Seek(const KeyValueWrapper& target) override;
+    void Next() override;
+    const KeyValueWrapper& entry() const override;
+
+    // Not supported: compaction only merges forward
+    void SeekToLast() override;
+    void SeekForPrev(const KeyValueWrapper& target) override;
+    void Prev() override;
+
+    // Stop the reader thread; the iterator becomes invalid
+    void stop();
+
+    // Seconds the reader thread spent reading and decoding, and seconds the consumer
+    // waited for it (final once stop() returned)
+    double getReadBusySeconds() const { return readBusySeconds; }
+    double getConsumerWaitSeconds() const { return consumerWaitSeconds; }
+
+private:
+    std::shared_ptr<DiskBTree> sst;
+    bool hasUpperBound = false;
+    KeyValueWrapper upperBound;
+
+    std::unique_ptr<BoundedQueue<std::vector<Page>>> queue;
+    std::thread reader;
+    std::exception_ptr readerError;
+    double readBusySeconds = 0;
+    double consumerWaitSeconds = 0;
+
+    // Leaves of the current window and the position in them
+    std::vector<Page> window;
+    size_t pageIndex = 0;
+    size_t index = 0;
+    bool valid = false;
+
+    // Start the reader thread at a leaf and move to its first entry
+    void start(uint64_t leafOffset);
+    void readLeaves(uint64_t leafOffset);
+    // Move past exhausted leaves and windows
+    void skipExhausted();
+};
+
+#endif // SST_PREFETCH_ITERATOR_H
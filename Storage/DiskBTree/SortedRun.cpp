@@ -0,0 +1,135 @@
+//
+// SortedRun.cpp
+//
+
+#include "SortedRun.h"
+#include "Page.h"
+#include <algorithm>
+#include <stdexcept>
+
+SortedRun::SortedRun(std::vector<std::shared_ptr<DiskBTree>> sstList) : ssts(std::move(sstList)) {
+    if (ssts.empty()) {
+        throw std::invalid_argument("SortedRun: a run needs at least one SST");
+    }
+    for (const auto& sst : ssts) {
+        addStats(*sst);
+        KeyValueWrapper smallest;
+        if (sst->getLeafBeginOffset() != 0) {
+            Page firstLeaf = sst->pageManager->readPage(sst->getLeafBeginOffset());
+            if (!firstLeaf.getLeafEntries().empty()) {
+                smallest = firstLeaf.getLeafEntries().front();
+            }
+        }
+        smallestKeys.push_back(smallest);
+    }
+}
+
+SortedRun::SortedRun(std::vector<std::shared_ptr<DiskBTree>> sstList, std::vector<KeyValueWrapper> smallestKeyList)
+    : ssts(std::move(sstList)), smallestKeys(std::move(smallestKeyList)) {
+    if (ssts.empty()) {
+        throw std::invalid_argument("SortedRun: a run needs at least one SST");
+    }
+    if (smallestKeys.size() != ssts.size()) {
+        throw std::invalid_argument("SortedRun: one smallest key per SST expected");
+    }
+    for (const auto& sst : ssts) {
+        addStats(*sst);
+    }
+}
+
+void SortedRun::addStats(const DiskBTree& sst) {
+    numKeyValues += sst.getNumberOfKeyValues();
+    numTombstones += sst.getNumTombstones();
+    rangeTombstones.add(sst.getRangeTombstones());
+}
+
+size_t SortedRun::findSST(const KeyValueWrapper& kv) const {
+    // Last SST starting at or before kv
+    auto it = std::upper_bound(smallestKeys.begin() + 1, smallestKeys.end(), kv);
+    return static_cast<size_t>(it - smallestKeys.begin()) - 1;
+}
+
+KeyValueWrapper* SortedRun::search(const KeyValueWrapper& kv) {
+    return ssts[findSST(kv)]->search(kv);
+}
+
+void SortedRun::multiSearch(const std::vector<KeyValueWrapper>& keys, std::vector<KeyValueWrapper>& results) {
+    if (ssts.size() == 1) {
+        ssts.front()->multiSearch(keys, results);
+        return;
+    }
+    results.assign(keys.size(), KeyValueWrapper());
+    size_t begin = 0;
+    while (begin < keys.size()) {
+        // keys[begin, end) fall into the same SST
+        size_t sstIndex = findSST(keys[begin]);
+        size_t end = begin + 1;
+        if (sstIndex + 1 < ssts.size()) {
+            while (end < keys.size() && keys[end] < smallestKeys[sstIndex + 1]) {
+                ++end;
+            }
+        } else {
+            end = keys.size();
+        }
+        std::vector<KeyValueWrapper> sstKeys(keys.begin() + begin, keys.begin() + end);
+        std::vector<KeyValueWrapper> found;
+        ssts[sstIndex]->multiSearch(sstKeys, found);
+        std::move(found.begin(), found.end(), results.begin() + begin);
+        begin = end;
+    }
+}
+
+SSTFilterType SortedRun::getFilterType() const {
+    return ssts.front()->getFilterType();
+}
+
+size_t SortedRun::getFilterBytes() const {
+    size_t bytes = 0;
+    for (const auto& sst : ssts) {
+        bytes += sst->getFilterBytes();
+    }
+    return bytes;
+}
+
+double SortedRun::getFilterBitsPerKey() const {
+    if (numKeyValues == 0) {
+        return ssts.front()->getFilterBitsPerKey();
+    }
+    double bits = 0;
+    for (const auto& sst : ssts) {
+        bits += sst->getFilterBitsPerKey() * static_cast<double>(sst->getNumberOfKeyValues());
+    }
+    return bits / static_cast<double>(numKeyValues);
+}
+
+long long SortedRun::getCacheHit() const {
+    long long hits = 0;
+    for (const auto& sst : ssts) {
+        hits += sst->getCacheHit();
+    }
+    return hits;
+}
+
+void SortedRun::setBufferPoolParameters(size_t capacity, EvictionPolicy policy) {
+    for (const auto& sst : ssts) {
+        sst->setBufferPoolParameters(capacity, policy);
+    }
+}
+
+void SortedRun::setIOQueueDepth(size_t depth) {
+    for (const auto& sst : ssts) {
+        sst->setIOQueueDepth(depth);
+    }
+}
+
+void SortedRun::setReadMode(SSTReadMode mode) {
+    for (const auto& sst : ssts) {
+        sst->setReadMode(mode);
+    }
+}
+
+void SortedRun::printKVs() const {
+    for (const auto& sst : ssts) {
+        sst->printKVs();
+    }
+}
@@ -0,0 +1,74 @@
+//
+// SortedRun.h
+//
+
+#ifndef SORTED_RUN_H
+#define SORTED_RUN_H
+
+#include "DiskBTree.h"
+#include <vector>
+#include <memory>
+
+// The SSTs of one level: key ranges are disjoint and the SSTs are kept in key order,
+// so a key is in at most one of them. A level usually holds a single SST; parallel
+// subcompactions write one SST per key range.
+class SortedRun {
+public:
+    // ssts must be in key order with disjoint key ranges
+    explicit SortedRun(std::vector<std::shared_ptr<DiskBTree>> ssts);
+    // Same, with the first key of each SST already known (e.g. from the manifest), so no
+    // leaf is read
+    SortedRun(std::vector<std::shared_ptr<DiskBTree>> ssts, std::vector<KeyValueWrapper> smallestKeys);
+
+    const std::vector<std::shared_ptr<DiskBTree>>& getSSTs() const { return ssts; }
+
+    // First key of each SST
+    const std::vector<KeyValueWrapper>& getSmallestKeys() const { return smallestKeys; }
+
+    // Search the SST whose range holds kv; same contract as DiskBTree::search
+    KeyValueWrapper* search(const KeyValueWrapper& kv);
+
+    // Look up sorted, distinct keys; each SST is searched for the keys in its range together
+    void multiSearch(const std::vector<KeyValueWrapper>& keys, std::vector<KeyValueWrapper>& results);
+
+    size_t getNumberOfKeyValues() const { return numKeyValues; }
+    size_t getNumTombstones() const { return numTombstones; }
+
+    // Range tombstones of all SSTs: a range deletion may reach past the SST holding it
+    const RangeTombstoneList& getRangeTombstones() const { return rangeTombstones; }
+
+    // No entries and no range tombstones
+    bool isEmpty() const { return numKeyValues == 0 && rangeTombstones.empty(); }
+
+    // Filter footprint over all SSTs; bits per key is weighted by their key counts
+    SSTFilterType getFilterType() const;
+    size_t getFilterBytes() const;
+    double getFilterBitsPerKey() const;
+
+    long long getCacheHit() const;
+
+    void setBufferPoolParameters(size_t capacity, EvictionPolicy policy);
+    void setIOQueueDepth(size_t depth);
+    void setReadMode(SSTReadMode mode);
+
+    // print all key value pair from disk
+    void printKVs() const;
+
+private:
+    std::vector<std::shared_ptr<DiskBTree>> ssts;
+
+    // smallestKeys[i] is the first key of ssts[i]
+    std::vector<KeyValueWrapper> smallestKeys;
+
+    size_t numKeyValues = 0;
+    size_t numTombstones = 0;
+    RangeTombstoneList rangeTombstones;
+
+    // Count an SST's entries, tombstones and range tombstones in the run's totals
+    void addStats(const DiskBTree& sst);
+
+    // Index of the SST whose range would hold kv
+    size_t findSST(const KeyValueWrapper& kv) const;
+};
+
+#endif // SORTED_RUN_H
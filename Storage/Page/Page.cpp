@@ -87,6 +87,22 @@ uint64_t Page::getNextLeafOffset() const {
     return leafNodeData.nextLeafOffset;
 }
 
+// Set previous leaf offset
+void Page::setPrevLeafOffset(uint64_t offset) {
+    if (pageType != PageType::LEAF_NODE) {
+        throw std::logic_error("Attempting to set previous leaf offset on non-leaf page");
+    }
+    leafNodeData.prevLeafOffset = offset;
+}
+
+// Get previous leaf offset
+uint64_t Page::getPrevLeafOffset() const {
+    if (pageType != PageType::LEAF_NODE) {
+        throw std::logic_error("Attempting to get previous leaf offset from non-leaf page");
+    }
+    return leafNodeData.prevLeafOffset;
+}
+
 // Set SST metadata
 void Page::setMetadata(uint64_t rootOffset, uint64_t leafBegin, uint64_t leafEnd, const std::string& fileName) {
     if (pageType != PageType::SST_METADATA) {
@@ -129,6 +145,104 @@ bool Page::getSSTBloomFilter(std::vector<char>& bloomFilterData) const {
     return false;
 }
 
+void Page::setSSTFilterStats(uint64_t numKeyValues, uint64_t filterBytes, double bitsPerKey) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST filter stats on non-metadata page");
+    }
+    sstMetadata.numKeyValues = numKeyValues;
+    sstMetadata.filterBytes = filterBytes;
+    sstMetadata.filterBitsPerKey = bitsPerKey;
+}
+
+void Page::getSSTFilterStats(uint64_t& numKeyValues, uint64_t& filterBytes, double& bitsPerKey) const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST filter stats from non-metadata page");
+    }
+    numKeyValues = sstMetadata.numKeyValues;
+    filterBytes = sstMetadata.filterBytes;
+    bitsPerKey = sstMetadata.filterBitsPerKey;
+}
+
+void Page::setSSTFilterRegion(uint8_t filterType, uint64_t filterOffset, uint64_t filterSize) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST filter region on non-metadata page");
+    }
+    sstMetadata.filterType = filterType;
+    sstMetadata.filterOffset = filterOffset;
+    sstMetadata.filterSize = filterSize;
+}
+
+void Page::getSSTFilterRegion(uint8_t& filterType, uint64_t& filterOffset, uint64_t& filterSize) const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST filter region from non-metadata page");
+    }
+    filterType = sstMetadata.filterType;
+    filterOffset = sstMetadata.filterOffset;
+    filterSize = sstMetadata.filterSize;
+}
+
+void Page::setSSTPrefixFilterRegion(uint32_t prefixLength, uint64_t filterOffset, uint64_t filterSize) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST prefix filter region on non-metadata page");
+    }
+    sstMetadata.prefixLength = prefixLength;
+    sstMetadata.prefixFilterOffset = filterOffset;
+    sstMetadata.prefixFilterSize = filterSize;
+}
+
+void Page::getSSTPrefixFilterRegion(uint32_t& prefixLength, uint64_t& filterOffset, uint64_t& filterSize) const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST prefix filter region from non-metadata page");
+    }
+    prefixLength = sstMetadata.prefixLength;
+    filterOffset = sstMetadata.prefixFilterOffset;
+    filterSize = sstMetadata.prefixFilterSize;
+}
+
+void Page::setSSTNumTombstones(uint64_t numTombstones) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST tombstone count on non-metadata page");
+    }
+    sstMetadata.numTombstones = numTombstones;
+}
+
+uint64_t Page::getSSTNumTombstones() const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST tombstone count from non-metadata page");
+    }
+    return sstMetadata.numTombstones;
+}
+
+void Page::setSSTRangeTombstoneRegion(uint64_t regionOffset, uint64_t regionSize) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST range tombstone region on non-metadata page");
+    }
+    sstMetadata.rangeTombstoneOffset = regionOffset;
+    sstMetadata.rangeTombstoneSize = regionSize;
+}
+
+void Page::getSSTRangeTombstoneRegion(uint64_t& regionOffset, uint64_t& regionSize) const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST range tombstone region from non-metadata page");
+    }
+    regionOffset = sstMetadata.rangeTombstoneOffset;
+    regionSize = sstMetadata.rangeTombstoneSize;
+}
+
+void Page::setSSTEarliestExpiry(uint64_t earliestExpiry) {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to set SST earliest expiry on non-metadata page");
+    }
+    sstMetadata.earliestExpiry = earliestExpiry;
+}
+
+uint64_t Page::getSSTEarliestExpiry() const {
+    if (pageType != PageType::SST_METADATA) {
+        throw std::logic_error("Attempting to get SST earliest expiry from non-metadata page");
+    }
+    return sstMetadata.earliestExpiry;
+}
+
 // Serialize the page to a byte buffer
 std::vector<char> Page::serialize() const {
     std::vector<char> buffer;
@@ -182,6 +296,10 @@ std::vector<char> Page::serialize() const {
 
 // Deserialize the page from a byte buffer
 void Page::deserialize(const std::vector<char>& buffer) {
+    deserialize(std::string_view(buffer.data(), buffer.size()));
+}
+
+void Page::deserialize(std::string_view buffer) {
     if (buffer.empty()) {
         throw std::invalid_argument("Cannot deserialize from empty buffer");
     }
@@ -231,7 +349,7 @@ void Page::serializeInternalNode(std::vector<char>& buffer) const {
 }
 
 // Deserialization for Internal Node
-void Page::deserializeInternalNode(const std::vector<char>& buffer) {
+void Page::deserializeInternalNode(std::string_view buffer) {
     size_t offset = 1; // Start after page type
 
     // Deserialize number of keys
@@ -282,9 +400,13 @@ void Page::serializeLeafNode(std::vector<char>& buffer) const {
        uint64_t seqNum = kv.sequenceNumber;
        buffer.insert(buffer.end(), reinterpret_cast<const char*>(&seqNum), reinterpret_cast<const char*>(&seqNum) + sizeof(seqNum));
 
-       // Serialize tombstone
-       uint8_t tombstoneFlag = kv.tombstone ? 1 : 0;
-       buffer.push_back(tombstoneFlag);
+       // Serialize flags: bit 0 tombstone, bit 1 merge operand, bit 2 expiry time follows
+       uint8_t flags = (kv.tombstone ? 1 : 0) | (kv.mergeOperand ? 2 : 0) | (kv.expiresAt != 0 ? 4 : 0);
+       buffer.push_back(flags);
+       if (kv.expiresAt != 0) {
+           buffer.insert(buffer.end(), reinterpret_cast<const char*>(&kv.expiresAt),
+                         reinterpret_cast<const char*>(&kv.expiresAt) + sizeof(kv.expiresAt));
+       }
 
        // Serialize KeyValue
        std::string kvData;
@@ -314,10 +436,14 @@ void Page::serializeLeafNode(std::vector<char>& buffer) const {
        // Serialize Bloom filter data
        buffer.insert(buffer.end(), bloomFilterData.begin(), bloomFilterData.end());
    }
+
+   // Serialize previous leaf offset
+   buffer.insert(buffer.end(), reinterpret_cast<const char*>(&leafNodeData.prevLeafOffset),
+                 reinterpret_cast<const char*>(&leafNodeData.prevLeafOffset) + sizeof(leafNodeData.prevLeafOffset));
 }
 
 // Deserialization for Leaf Node
-void Page::deserializeLeafNode(const std::vector<char>& buffer) {
+void Page::deserializeLeafNode(std::string_view buffer) {
    size_t offset = 1; // Start after page type
 
    // Deserialize number of entries
@@ -333,25 +459,30 @@ void Page::deserializeLeafNode(const std::vector<char>& buffer) {
        std::memcpy(&seqNum, &buffer[offset], sizeof(seqNum));
        offset += sizeof(seqNum);
 
-       // Deserialize tombstone
-       uint8_t tombstoneFlag = buffer[offset];
+       // Deserialize flags
+       uint8_t flags = buffer[offset];
        offset += sizeof(uint8_t);
+       uint64_t expiresAt = 0;
+       if (flags & 4) {
+           std::memcpy(&expiresAt, &buffer[offset], sizeof(expiresAt));
+           offset += sizeof(expiresAt);
+       }
 
        // Deserialize KeyValue
        uint32_t kvSize;
        std::memcpy(&kvSize, &buffer[offset], sizeof(kvSize));
        offset += sizeof(kvSize);
 
-       std::string kvData(buffer.begin() + offset, buffer.begin() + offset + kvSize);
-       offset += kvSize;
-
        KeyValueWrapper kv;
-       if (!kv.kv.ParseFromString(kvData)) {
+       if (!kv.kv.ParseFromArray(buffer.data() + offset, static_cast<int>(kvSize))) {
            throw std::runtime_error("Failed to parse KeyValueWrapper in leaf node");
        }
+       offset += kvSize;
 
        kv.sequenceNumber = seqNum;
-       kv.tombstone = (tombstoneFlag == 1);
+       kv.tombstone = (flags & 1) != 0;
+       kv.mergeOperand = (flags & 2) != 0;
+       kv.expiresAt = expiresAt;
 
        leafNodeData.keyValues.push_back(kv);
    }
@@ -386,6 +517,11 @@ void Page::deserializeLeafNode(const std::vector<char>& buffer) {
    } else {
        leafNodeData.hasBloomFilter = false;
    }
+
+   // Deserialize previous leaf offset
+   if (offset + sizeof(leafNodeData.prevLeafOffset) <= buffer.size()) {
+       std::memcpy(&leafNodeData.prevLeafOffset, &buffer[offset], sizeof(leafNodeData.prevLeafOffset));
+   }
 }
 
 
@@ -423,10 +559,47 @@ void Page::serializeSSTMetadata(std::vector<char>& buffer) const {
         // Serialize Bloom filter data
         buffer.insert(buffer.end(), bloomFilterData.begin(), bloomFilterData.end());
     }
+
+    // Serialize filter statistics
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.numKeyValues),
+                  reinterpret_cast<const char*>(&sstMetadata.numKeyValues) + sizeof(sstMetadata.numKeyValues));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.filterBytes),
+                  reinterpret_cast<const char*>(&sstMetadata.filterBytes) + sizeof(sstMetadata.filterBytes));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.filterBitsPerKey),
+                  reinterpret_cast<const char*>(&sstMetadata.filterBitsPerKey) + sizeof(sstMetadata.filterBitsPerKey));
+
+    // Serialize filter region
+    buffer.push_back(static_cast<char>(sstMetadata.filterType));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.filterOffset),
+                  reinterpret_cast<const char*>(&sstMetadata.filterOffset) + sizeof(sstMetadata.filterOffset));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.filterSize),
+                  reinterpret_cast<const char*>(&sstMetadata.filterSize) + sizeof(sstMetadata.filterSize));
+
+    // Serialize prefix filter region
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.prefixLength),
+                  reinterpret_cast<const char*>(&sstMetadata.prefixLength) + sizeof(sstMetadata.prefixLength));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.prefixFilterOffset),
+                  reinterpret_cast<const char*>(&sstMetadata.prefixFilterOffset) + sizeof(sstMetadata.prefixFilterOffset));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.prefixFilterSize),
+                  reinterpret_cast<const char*>(&sstMetadata.prefixFilterSize) + sizeof(sstMetadata.prefixFilterSize));
+
+    // Serialize tombstone count
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.numTombstones),
+                  reinterpret_cast<const char*>(&sstMetadata.numTombstones) + sizeof(sstMetadata.numTombstones));
+
+    // Serialize range tombstone region
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.rangeTombstoneOffset),
+                  reinterpret_cast<const char*>(&sstMetadata.rangeTombstoneOffset) + sizeof(sstMetadata.rangeTombstoneOffset));
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.rangeTombstoneSize),
+                  reinterpret_cast<const char*>(&sstMetadata.rangeTombstoneSize) + sizeof(sstMetadata.rangeTombstoneSize));
+
+    // Serialize earliest expiry
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&sstMetadata.earliestExpiry),
+                  reinterpret_cast<const char*>(&sstMetadata.earliestExpiry) + sizeof(sstMetadata.earliestExpiry));
 }
 
 // Deserialization for SST Metadata
-void Page::deserializeSSTMetadata(const std::vector<char>& buffer) {
+void Page::deserializeSSTMetadata(std::string_view buffer) {
     size_t offset = 1; // Start after page type
 
     // Deserialize root offset
@@ -478,6 +651,62 @@ void Page::deserializeSSTMetadata(const std::vector<char>& buffer) {
     } else {
         sstMetadata.hasBloomFilter = false;
     }
+
+    // Deserialize filter statistics
+    if (offset + sizeof(uint64_t) * 2 + sizeof(double) > buffer.size()) {
+        return;
+    }
+    std::memcpy(&sstMetadata.numKeyValues, &buffer[offset], sizeof(sstMetadata.numKeyValues));
+    offset += sizeof(sstMetadata.numKeyValues);
+    std::memcpy(&sstMetadata.filterBytes, &buffer[offset], sizeof(sstMetadata.filterBytes));
+    offset += sizeof(sstMetadata.filterBytes);
+    std::memcpy(&sstMetadata.filterBitsPerKey, &buffer[offset], sizeof(sstMetadata.filterBitsPerKey));
+    offset += sizeof(sstMetadata.filterBitsPerKey);
+
+    // Deserialize filter region
+    if (offset + sizeof(uint8_t) + sizeof(uint64_t) * 2 > buffer.size()) {
+        return;
+    }
+    sstMetadata.filterType = static_cast<uint8_t>(buffer[offset]);
+    offset += sizeof(uint8_t);
+    std::memcpy(&sstMetadata.filterOffset, &buffer[offset], sizeof(sstMetadata.filterOffset));
+    offset += sizeof(sstMetadata.filterOffset);
+    std::memcpy(&sstMetadata.filterSize, &buffer[offset], sizeof(sstMetadata.filterSize));
+    offset += sizeof(sstMetadata.filterSize);
+
+    // Deserialize prefix filter region
+    if (offset + sizeof(uint32_t) + sizeof(uint64_t) * 2 > buffer.size()) {
+        return;
+    }
+    std::memcpy(&sstMetadata.prefixLength, &buffer[offset], sizeof(sstMetadata.prefixLength));
+    offset += sizeof(sstMetadata.prefixLength);
+    std::memcpy(&sstMetadata.prefixFilterOffset, &buffer[offset], sizeof(sstMetadata.prefixFilterOffset));
+    offset += sizeof(sstMetadata.prefixFilterOffset);
+    std::memcpy(&sstMetadata.prefixFilterSize, &buffer[offset], sizeof(sstMetadata.prefixFilterSize));
+    offset += sizeof(sstMetadata.prefixFilterSize);
+
+    // Deserialize tombstone count
+    if (offset + sizeof(uint64_t) > buffer.size()) {
+        return;
+    }
+    std::memcpy(&sstMetadata.numTombstones, &buffer[offset], sizeof(sstMetadata.numTombstones));
+    offset += sizeof(sstMetadata.numTombstones);
+
+    // Deserialize range tombstone region
+    if (offset + sizeof(uint64_t) * 2 > buffer.size()) {
+        return;
+    }
+    std::memcpy(&sstMetadata.rangeTombstoneOffset, &buffer[offset], sizeof(sstMetadata.rangeTombstoneOffset));
+    offset += sizeof(sstMetadata.rangeTombstoneOffset);
+    std::memcpy(&sstMetadata.rangeTombstoneSize, &buffer[offset], sizeof(sstMetadata.rangeTombstoneSize));
+    offset += sizeof(sstMetadata.rangeTombstoneSize);
+
+    // Deserialize earliest expiry
+    if (offset + sizeof(uint64_t) > buffer.size()) {
+        return;
+    }
+    std::memcpy(&sstMetadata.earliestExpiry, &buffer[offset], sizeof(sstMetadata.earliestExpiry));
+    offset += sizeof(sstMetadata.earliestExpiry);
 }
 
 // Build Bloom filter for leaf node
@@ -513,6 +742,37 @@ bool Page::leafBloomFilterContains(const KeyValueWrapper& kv) const {
     return leafNodeData.bloomFilter.possiblyContains(kv);
 }
 
+// Build a leaf Bloom filter sized by the number of entries on the page
+void Page::buildLeafBloomFilterFromEntries(double bitsPerKey) {
+    if (pageType != PageType::LEAF_NODE) {
+        throw std::logic_error("Attempting to build Bloom filter on non-leaf page");
+    }
+    size_t numKeys = leafNodeData.keyValues.size();
+    if (numKeys == 0) {
+        leafNodeData.hasBloomFilter = false;
+        return;
+    }
+    buildLeafBloomFilter(BloomFilter::bitsForKeys(numKeys, bitsPerKey), numKeys);
+    for (const auto& kv : leafNodeData.keyValues) {
+        leafNodeData.bloomFilter.add(kv);
+    }
+}
+
+size_t Page::getLeafBloomFilterSize() const {
+    if (pageType != PageType::LEAF_NODE || !leafNodeData.hasBloomFilter) {
+        return 0;
+    }
+    return leafNodeData.bloomFilter.getSerializedSize();
+}
+
+size_t Page::estimateLeafBloomFilterSize(size_t numKeys, double bitsPerKey) {
+    if (numKeys == 0) {
+        return 0;
+    }
+    // bloomFilterSize + Bloom filter data
+    return sizeof(uint32_t) + BloomFilter::serializedSizeForBits(BloomFilter::bitsForKeys(numKeys, bitsPerKey));
+}
+
 // Estimate the base size of the page for serialization
 size_t Page::getBaseSize() const {
     size_t size = sizeof(PageType) + sizeof(uint16_t); // pageType and numEntries
@@ -530,6 +790,7 @@ size_t Page::getBaseSize() const {
                 size += sizeof(uint32_t); // bloomFilterSize
                 size += leafNodeData.bloomFilter.getSerializedSize();
             }
+            size += sizeof(uint64_t); // prevLeafOffset
             break;
         case PageType::SST_METADATA:
             // For SST metadata, sizes of offsets and file name length
@@ -541,6 +802,9 @@ size_t Page::getBaseSize() const {
                 size += sizeof(uint32_t); // bloomFilterSize
                 size += sstMetadata.bloomFilter.getSerializedSize();
             }
+            size += sizeof(uint64_t) * 2 + sizeof(double); // filter statistics
+            size += sizeof(uint8_t) + sizeof(uint64_t) * 2; // filter region
+            size += sizeof(uint32_t) + sizeof(uint64_t) * 2; // prefix filter region
             break;
     }
     return size;
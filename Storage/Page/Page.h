@@ -5,6 +5,7 @@
 #include "KeyValue.h"
 #include "BloomFilter.h"
 #include <vector>
+#include <string_view>
 #include <cstdint>
 #include <string>
 #include <stdexcept>
@@ -27,6 +28,8 @@ public:
 
     // Deserialize the page from a byte buffer
     void deserialize(const std::vector<char>& buffer);
+    // Deserialize from a view, e.g. into a memory-mapped file
+    void deserialize(std::string_view buffer);
 
     // Accessors
     PageType getPageType() const { return pageType; }
@@ -43,12 +46,22 @@ public:
     const std::vector<KeyValueWrapper>& getLeafEntries() const;
     void setNextLeafOffset(uint64_t offset);
     uint64_t getNextLeafOffset() const;
+    // Offset of the previous leaf (0 for the first leaf and for pages written without it)
+    void setPrevLeafOffset(uint64_t offset);
+    uint64_t getPrevLeafOffset() const;
 
     // Build and use Bloom filter for leaf nodes
     void buildLeafBloomFilter(size_t m, size_t n);
     void addToLeafBloomFilter(const KeyValueWrapper& kv);
     bool leafBloomFilterContains(const KeyValueWrapper& kv) const;
 
+    // Size the leaf Bloom filter by the entries actually on the page and add them all
+    void buildLeafBloomFilterFromEntries(double bitsPerKey);
+    // Serialized bytes of the leaf Bloom filter (0 if the page has none)
+    size_t getLeafBloomFilterSize() const;
+    // Bytes a leaf Bloom filter for numKeys entries will add to the page
+    static size_t estimateLeafBloomFilterSize(size_t numKeys, double bitsPerKey);
+
     // SST Metadata specific methods
     void setMetadata(uint64_t rootOffset, uint64_t leafBegin, uint64_t leafEnd, const std::string& fileName);
     void getMetadata(uint64_t& rootOffset, uint64_t& leafBegin, uint64_t& leafEnd, std::string& fileName) const;
@@ -57,6 +70,30 @@ public:
     void setSSTBloomFilter(const std::vector<char>& bloomFilterData);
     bool getSSTBloomFilter(std::vector<char>& bloomFilterData) const;
 
+    // Key count and filter footprint of the SST, stored after the SST Bloom filter
+    void setSSTFilterStats(uint64_t numKeyValues, uint64_t filterBytes, double bitsPerKey);
+    void getSSTFilterStats(uint64_t& numKeyValues, uint64_t& filterBytes, double& bitsPerKey) const;
+
+    // Location of the SST-wide filter written after the tree (type 0 = leaf Bloom filters only)
+    void setSSTFilterRegion(uint8_t filterType, uint64_t filterOffset, uint64_t filterSize);
+    void getSSTFilterRegion(uint8_t& filterType, uint64_t& filterOffset, uint64_t& filterSize) const;
+
+    // Location of the SST prefix Bloom filter (prefixLength 0 = no prefix filter)
+    void setSSTPrefixFilterRegion(uint32_t prefixLength, uint64_t filterOffset, uint64_t filterSize);
+    void getSSTPrefixFilterRegion(uint32_t& prefixLength, uint64_t& filterOffset, uint64_t& filterSize) const;
+
+    // Number of tombstones among the SST's entries
+    void setSSTNumTombstones(uint64_t numTombstones);
+    uint64_t getSSTNumTombstones() const;
+
+    // Location of the SST's range tombstone block (size 0 = none)
+    void setSSTRangeTombstoneRegion(uint64_t regionOffset, uint64_t regionSize);
+    void getSSTRangeTombstoneRegion(uint64_t& regionOffset, uint64_t& regionSize) const;
+
+    // Earliest expiry time among the SST's entries (0 = none expires)
+    void setSSTEarliestExpiry(uint64_t earliestExpiry);
+    uint64_t getSSTEarliestExpiry() const;
+
     // Estimate the base size of the page for serialization
     size_t getBaseSize() const;
 
@@ -92,6 +129,7 @@ private:
     struct LeafNodeData {
         std::vector<KeyValueWrapper> keyValues;
         uint64_t nextLeafOffset; // Offset to next leaf node
+        uint64_t prevLeafOffset = 0; // Offset to previous leaf node
 
         // Bloom filter for the leaf node
         BloomFilter bloomFilter;
@@ -108,6 +146,31 @@ private:
         // SST Bloom filter
         BloomFilter bloomFilter;
         bool hasBloomFilter = false;
+
+        // Filter statistics (zero for SSTs written before they were recorded)
+        uint64_t numKeyValues = 0;
+        uint64_t filterBytes = 0;
+        double filterBitsPerKey = 0;
+
+        // SST-wide filter region
+        uint8_t filterType = 0;
+        uint64_t filterOffset = 0;
+        uint64_t filterSize = 0;
+
+        // Prefix Bloom filter region
+        uint32_t prefixLength = 0;
+        uint64_t prefixFilterOffset = 0;
+        uint64_t prefixFilterSize = 0;
+
+        // Tombstone count (zero for SSTs written before it was recorded)
+        uint64_t numTombstones = 0;
+
+        // Range tombstone block
+        uint64_t rangeTombstoneOffset = 0;
+        uint64_t rangeTombstoneSize = 0;
+
+        // Earliest entry expiry time in milliseconds since the Unix epoch (0 = none)
+        uint64_t earliestExpiry = 0;
     } sstMetadata;
 
     // Helper methods for serialization
@@ -115,9 +178,9 @@ private:
     void serializeLeafNode(std::vector<char>& buffer) const;
     void serializeSSTMetadata(std::vector<char>& buffer) const;
 
-    void deserializeInternalNode(const std::vector<char>& buffer);
-    void deserializeLeafNode(const std::vector<char>& buffer);
-    void deserializeSSTMetadata(const std::vector<char>& buffer);
+    void deserializeInternalNode(std::string_view buffer);
+    void deserializeLeafNode(std::string_view buffer);
+    void deserializeSSTMetadata(std::string_view buffer);
 };
 
 #endif // PAGE_H
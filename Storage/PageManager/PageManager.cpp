@@ -5,14 +5,24 @@
 #include "PageManager.h"
 #include <iostream>
 #include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 // Constructor
 PageManager::PageManager(const std::string& fileName, size_t pageSize)
     : fileName(fileName), pageSize(pageSize), bufferPool(std::make_shared<BufferPool>(1000, EvictionPolicy::LRU)) {
     openFile();
-    // Move to the end to find the next available offset
-    file.seekg(0, std::ios::end);
-    nextPageOffset = file.tellg();
+    // The end of the file is the next available offset
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("PageManager: Failed to stat file " + fileName);
+    }
+    nextPageOffset = static_cast<uint64_t>(st.st_size);
     if (nextPageOffset % pageSize != 0) {
         nextPageOffset += pageSize - (nextPageOffset % pageSize);
     }
@@ -26,25 +36,45 @@ PageManager::PageManager(const std::string& fileName, size_t pageSize)
 
 // Destructor
 PageManager::~PageManager() {
-    if (file.is_open()) {
-        file.close();
-    }
+    close();
 }
 
-// Open the file
+// Open the file in read/write mode, creating it if it doesn't exist
 void PageManager::openFile() {
-    // Open the file in read/write mode, binary
-    file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
-    if (!file.is_open()) {
-        // If the file doesn't exist, create it
-        file.clear();
-        file.open(fileName, std::ios::out | std::ios::binary);
-        file.close();
-        // Re-open in read/write mode
-        file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+    fd = ::open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("PageManager: Failed to open file " + fileName + ": " + std::strerror(errno));
+    }
+}
+
+// pread until size bytes are read; positional, so safe to call from many threads
+void PageManager::readFully(uint64_t offset, char* buffer, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pread(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("PageManager: Failed to read " + std::to_string(size) + " bytes at offset "
+                                     + std::to_string(offset) + " in file " + fileName);
+        }
+        done += static_cast<size_t>(n);
     }
-    if (!file.is_open()) {
-        throw std::runtime_error("PageManager: Failed to open file " + fileName);
+}
+
+void PageManager::writeFully(uint64_t offset, const char* buffer, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pwrite(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("Failed to write raw data to offset " + std::to_string(offset) + " in file "
+                                     + fileName);
+        }
+        done += static_cast<size_t>(n);
     }
 }
 
@@ -61,9 +91,7 @@ void PageManager::writePage(uint64_t offset, const Page& page) {
     if (buffer.size() != pageSize) {
         throw std::runtime_error("PageManager: Serialized page size does not match page size");
     }
-    file.seekp(offset, std::ios::beg);
-    file.write(buffer.data(), pageSize);
-    file.flush();
+    writeFully(offset, buffer.data(), pageSize);
 
     // Update buffer pool
     auto pagePtr = std::make_shared<Page>(page);
@@ -72,6 +100,8 @@ void PageManager::writePage(uint64_t offset, const Page& page) {
 
 // Read a page from disk at the given offset
 Page PageManager::readPage(uint64_t offset) {
+    pageReads++;
+
     // Generate PageId
     PageId pageId{fileName, offset};
 
@@ -83,42 +113,133 @@ Page PageManager::readPage(uint64_t offset) {
         bufferPool->Hit();
         return *page;
     } else {
+        Page page(Page::PageType::LEAF_NODE); // Placeholder, actual type will be set during deserialization
+        if (isMapped(offset, pageSize)) {
+            // Parse straight out of the mapping, no copy
+            page.deserialize(std::string_view(mappedData + offset, pageSize));
+            return page;
+        }
         // Read from disk
-        file.seekg(offset, std::ios::beg);
         std::vector<char> buffer(pageSize);
-        file.read(buffer.data(), pageSize);
-        if (!file) {
-            throw std::runtime_error("PageManager: Failed to read page at offset " + std::to_string(offset));
-        }
-        Page page(Page::PageType::LEAF_NODE); // Placeholder, actual type will be set during deserialization
+        readFully(offset, buffer.data(), pageSize);
         page.deserialize(buffer);
+        if (cacheReads) {
+            bufferPool->putPage(fileName, offset, std::make_shared<Page>(page));
+        }
         return page;
     }
 }
 
-void PageManager::writeRawPage(uint64_t offset, const char* buffer, size_t size) {
-    // Ensure the file is open
-    if (!file.is_open()) {
-        throw std::runtime_error("File is not open: " + fileName);
+std::vector<Page> PageManager::readPages(const std::vector<uint64_t>& offsets) {
+    // Mapped pages are already in memory (or one page fault away)
+    if (ioQueueDepth <= 1 || offsets.size() <= 1 || mappedData != nullptr) {
+        std::vector<Page> pages;
+        pages.reserve(offsets.size());
+        for (uint64_t offset : offsets) {
+            pages.push_back(readPage(offset));
+        }
+        return pages;
     }
 
-    // Seek to the specified offset
-    file.seekp(offset, std::ios::beg);
-    if (!file) {
-        throw std::runtime_error("Failed to seek to offset " + std::to_string(offset) + " in file " + fileName);
+    // Serve what the buffer pool has, read the rest in one batch
+    std::vector<std::shared_ptr<Page>> cached(offsets.size());
+    std::vector<uint64_t> missOffsets;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        pageReads++;
+        cached[i] = bufferPool->getPage(fileName, offsets[i]);
+        if (cached[i] != nullptr) {
+            bufferPool->Hit();
+        } else {
+            missOffsets.push_back(offsets[i]);
+        }
     }
 
-    // Write the raw bytes
-    file.write(buffer, size);
-    if (!file) {
-        throw std::runtime_error("Failed to write raw data to offset " + std::to_string(offset) + " in file " + fileName);
+    std::vector<std::vector<char>> buffers;
+    if (!missOffsets.empty()) {
+        AsyncPageReader* reader;
+        {
+            std::lock_guard<std::mutex> lock(asyncReaderMutex);
+            if (!asyncReader) {
+                asyncReader = std::make_unique<AsyncPageReader>(fileName, pageSize, ioQueueDepth);
+            }
+            reader = asyncReader.get();
+        }
+        buffers = reader->readPages(missOffsets);
+    }
+
+    std::vector<Page> pages;
+    pages.reserve(offsets.size());
+    size_t miss = 0;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        if (cached[i] != nullptr) {
+            pages.push_back(*cached[i]);
+        } else {
+            Page page(Page::PageType::LEAF_NODE); // Placeholder, actual type will be set during deserialization
+            page.deserialize(buffers[miss++]);
+            if (cacheReads) {
+                bufferPool->putPage(fileName, offsets[i], std::make_shared<Page>(page));
+            }
+            pages.push_back(std::move(page));
+        }
     }
+    return pages;
+}
+
+void PageManager::setIOQueueDepth(size_t depth) {
+    std::lock_guard<std::mutex> lock(asyncReaderMutex);
+    ioQueueDepth = depth == 0 ? 1 : depth;
+    asyncReader.reset();
+}
+
+void PageManager::setReadMode(SSTReadMode mode) {
+    unmapFile();
+    readMode = mode;
+    if (mode != SSTReadMode::MMAP || fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("PageManager: Failed to stat file " + fileName);
+    }
+    if (st.st_size == 0) {
+        return;
+    }
+    void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("PageManager: Failed to map file " + fileName + ": " + std::strerror(errno));
+    }
+    mappedData = static_cast<char*>(data);
+    mappedSize = static_cast<size_t>(st.st_size);
+    ::madvise(mappedData, mappedSize, MADV_RANDOM);
+}
 
-    // Flush to ensure data is written to disk
-    file.flush();
-    if (!file) {
-        throw std::runtime_error("Failed to flush data to disk after writing to offset " + std::to_string(offset));
+void PageManager::adviseAccess(uint64_t offset, uint64_t length, bool sequential) {
+    if (mappedData == nullptr || offset >= mappedSize) {
+        return;
     }
+    // madvise wants a page-aligned start
+    uint64_t alignment = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    uint64_t begin = offset - offset % alignment;
+    uint64_t end = std::min<uint64_t>(offset + length, mappedSize);
+    ::madvise(mappedData + begin, end - begin, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+}
+
+void PageManager::unmapFile() {
+    if (mappedData != nullptr) {
+        ::munmap(mappedData, mappedSize);
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+}
+
+void PageManager::writeRawPage(uint64_t offset, const char* buffer, size_t size) {
+    // Ensure the file is open
+    if (fd < 0) {
+        throw std::runtime_error("File is not open: " + fileName);
+    }
+
+    // Write the raw bytes
+    writeFully(offset, buffer, size);
 
     // Optionally, update nextPageOffset if writing at the end
     if (offset >= nextPageOffset) {
@@ -126,6 +247,20 @@ void PageManager::writeRawPage(uint64_t offset, const char* buffer, size_t size)
     }
 }
 
+std::vector<char> PageManager::readRawBytes(uint64_t offset, size_t size) {
+    // Ensure the file is open
+    if (fd < 0) {
+        throw std::runtime_error("File is not open: " + fileName);
+    }
+
+    if (isMapped(offset, size)) {
+        return std::vector<char>(mappedData + offset, mappedData + offset + size);
+    }
+    std::vector<char> buffer(size);
+    readFully(offset, buffer.data(), size);
+    return buffer;
+}
+
 // Get the current end of file offset
 uint64_t PageManager::getEOFOffset() const {
     return nextPageOffset;
@@ -133,8 +268,11 @@ uint64_t PageManager::getEOFOffset() const {
 
 // Close the file
 void PageManager::close() {
-    if (file.is_open()) {
-        file.close();
+    asyncReader.reset();
+    unmapFile();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
     }
 }
 
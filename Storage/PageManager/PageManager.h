@@ -7,11 +7,19 @@
 
 #include "Page.h"
 #include "BufferPool.h"
+#include "AsyncPageReader.h"
 #include <string>
-#include <fstream>
 #include <cstdint>
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
 
+// How pages of an immutable SST are read: positional reads into a buffer
+// (PREAD), or views into a read-only mapping of the whole file (MMAP).
+enum class SSTReadMode { PREAD, MMAP };
+
+// Page I/O for one file. Reads and writes are positional (pread/pwrite on one
+// file descriptor) so any number of threads can read the same file at once.
 class PageManager {
 public:
     // Constructor
@@ -30,9 +38,30 @@ public:
     // Read a page from disk at the given offset
     Page readPage(uint64_t offset);
 
+    // Read several pages, with up to the I/O queue depth of disk reads in flight;
+    // pages[i] is the page at offsets[i]
+    std::vector<Page> readPages(const std::vector<uint64_t>& offsets);
+
+    // Number of page reads kept in flight by readPages (1 = one at a time)
+    void setIOQueueDepth(size_t depth);
+    size_t getIOQueueDepth() const { return ioQueueDepth; }
+
+    // Map the file for reading (MMAP) or unmap it (PREAD). The mapping covers
+    // the file as it is now and is advised MADV_RANDOM for point lookups;
+    // offsets past it are still read with pread.
+    void setReadMode(SSTReadMode mode);
+    SSTReadMode getReadMode() const { return readMode; }
+
+    // Hint how [offset, offset + length) is about to be read: sequentially
+    // (scans, compaction) or randomly (point lookups). No-op unless mapped.
+    void adviseAccess(uint64_t offset, uint64_t length, bool sequential);
+
     // Write raw bytes to disk at the given offset
     void writeRawPage(uint64_t offset, const char* buffer, size_t size);
 
+    // Read raw bytes from disk at the given offset (bypasses the buffer pool)
+    std::vector<char> readRawBytes(uint64_t offset, size_t size);
+
     // Get the current end of file offset
     uint64_t getEOFOffset() const;
 
@@ -41,22 +70,50 @@ public:
 
     // BufferPool configuration
     void setBufferPoolParameters(size_t capacity, EvictionPolicy policy);
+    // Cache pages in a pool shared with other files (a database's block cache); unlike
+    // the pool of this file alone, it also keeps the pages read from disk
+    void setBufferPool(std::shared_ptr<BufferPool> pool) {
+        bufferPool = std::move(pool);
+        cacheReads = true;
+    }
+    const std::shared_ptr<BufferPool>& getBufferPool() const { return bufferPool; }
     long long getCacheHit() const {return bufferPool->getCacheHit();};
 
+    // Number of readPage calls (buffer pool hits included)
+    long long getPageReads() const { return pageReads.load(std::memory_order_relaxed); }
+
     size_t getPageSize() const { return pageSize; }
 
 
 private:
     std::string fileName;
     size_t pageSize;
-    std::fstream file;
+    int fd = -1;
     uint64_t nextPageOffset;
+    std::atomic<long long> pageReads{0};
 
     const size_t DEFAULT_PAGE_SIZE = 4096;
 
     std::shared_ptr<BufferPool> bufferPool;
+    bool cacheReads = false;
+
+    // Reader for readPages, created on first use
+    size_t ioQueueDepth = 1;
+    std::unique_ptr<AsyncPageReader> asyncReader;
+    std::mutex asyncReaderMutex;
+
+    // Read-only mapping in MMAP mode
+    SSTReadMode readMode = SSTReadMode::PREAD;
+    char* mappedData = nullptr;
+    size_t mappedSize = 0;
+    void unmapFile();
+    bool isMapped(uint64_t offset, size_t size) const {
+        return mappedData != nullptr && offset + size <= mappedSize;
+    }
     // Methods to manage file I/O
     void openFile();
+    void readFully(uint64_t offset, char* buffer, size_t size) const;
+    void writeFully(uint64_t offset, const char* buffer, size_t size) const;
 };
 
 #endif // PAGEMANAGER_H
@@ -0,0 +1,82 @@
+//
+// BoundedQueue.h
+//
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Queue between two pipeline stages running on different threads. push() blocks
+// while capacity items are queued and pop() while none are, so the producer runs
+// at most capacity items ahead; with capacity 2 one item is being filled while the
+// other is consumed. Time spent blocked on each side is recorded, which tells
+// which stage is the bottleneck.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity = 2) : capacity(capacity == 0 ? 1 : capacity) {}
+
+    // Wait for room and queue item; returns false (dropping item) once the queue is closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto start = std::chrono::steady_clock::now();
+        notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+        pushWait += std::chrono::steady_clock::now() - start;
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Wait for the next item; returns false once the queue is closed and drained
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto start = std::chrono::steady_clock::now();
+        notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+        popWait += std::chrono::steady_clock::now() - start;
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // End of input from the producer, or the consumer giving up; wakes up both sides
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    // Seconds spent waiting in push() and pop()
+    double getPushWaitSeconds() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::chrono::duration<double>(pushWait).count();
+    }
+    double getPopWaitSeconds() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::chrono::duration<double>(popWait).count();
+    }
+
+private:
+    const size_t capacity;
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    bool closed = false;
+    std::chrono::steady_clock::duration pushWait{};
+    std::chrono::steady_clock::duration popWait{};
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,69 @@
+//
+// RateLimiter.cpp
+//
+
+#include "RateLimiter.h"
+#include <algorithm>
+
+RateLimiter::RateLimiter(uint64_t highBytesPerSecond, uint64_t lowBytesPerSecond) {
+    bucket(Priority::HIGH).bytesPerSecond = highBytesPerSecond;
+    bucket(Priority::LOW).bytesPerSecond = lowBytesPerSecond;
+}
+
+void RateLimiter::setBytesPerSecond(Priority priority, uint64_t bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Bucket& b = bucket(priority);
+    refill(b);
+    b.bytesPerSecond = bytesPerSecond;
+    if (bytesPerSecond == 0) {
+        b.tokens = 0;
+    }
+    // Waiters recompute their sleep at the new rate
+    rateChanged.notify_all();
+}
+
+uint64_t RateLimiter::getBytesPerSecond(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bucket(priority).bytesPerSecond;
+}
+
+void RateLimiter::refill(Bucket& bucket) {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - bucket.lastRefill).count();
+    bucket.lastRefill = now;
+    if (bucket.bytesPerSecond == 0) {
+        return;
+    }
+    double rate = static_cast<double>(bucket.bytesPerSecond);
+    double maxTokens = rate * std::chrono::duration<double>(REFILL_WINDOW).count();
+    bucket.tokens = std::min(bucket.tokens + elapsed * rate, maxTokens);
+}
+
+void RateLimiter::request(size_t bytes, Priority priority) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Bucket& b = bucket(priority);
+    b.totalBytes += bytes;
+    if (b.bytesPerSecond == 0) {
+        return;
+    }
+    refill(b);
+    b.tokens -= static_cast<double>(bytes);
+
+    auto start = std::chrono::steady_clock::now();
+    while (b.bytesPerSecond != 0 && b.tokens < 0) {
+        auto deficit = std::chrono::duration<double>(-b.tokens / static_cast<double>(b.bytesPerSecond));
+        rateChanged.wait_for(lock, std::chrono::duration_cast<std::chrono::steady_clock::duration>(deficit));
+        refill(b);
+    }
+    b.totalWait += std::chrono::steady_clock::now() - start;
+}
+
+uint64_t RateLimiter::getTotalBytes(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bucket(priority).totalBytes;
+}
+
+double RateLimiter::getTotalWaitSeconds(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::chrono::duration<double>(bucket(priority).totalWait).count();
+}
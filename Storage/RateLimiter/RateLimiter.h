@@ -0,0 +1,66 @@
+//
+// RateLimiter.h
+//
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Token bucket limiting the bytes background work writes per second, with one budget
+// per priority: flushes (HIGH) free the memtable that foreground writes wait on, while
+// compactions (LOW) can fall behind without blocking anyone. Tokens refill continuously
+// at the configured rate and accumulate for at most REFILL_WINDOW, which bounds bursts.
+// A request may overdraw the bucket; the caller then sleeps until the debt is repaid.
+// Rates can be changed while writers are waiting.
+class RateLimiter {
+public:
+    enum class Priority : uint8_t {
+        HIGH = 0, // flushes
+        LOW = 1   // compactions
+    };
+
+    // Longest run of unused budget that is kept for a burst
+    static constexpr std::chrono::milliseconds REFILL_WINDOW{100};
+
+    // 0 bytes per second leaves a priority unlimited
+    explicit RateLimiter(uint64_t highBytesPerSecond = 0, uint64_t lowBytesPerSecond = 0);
+
+    void setBytesPerSecond(Priority priority, uint64_t bytesPerSecond);
+    uint64_t getBytesPerSecond(Priority priority) const;
+
+    // Take bytes from the priority's budget, waiting as long as its rate requires
+    void request(size_t bytes, Priority priority);
+
+    // Bytes requested so far and seconds spent waiting for them
+    uint64_t getTotalBytes(Priority priority) const;
+    double getTotalWaitSeconds(Priority priority) const;
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+private:
+    struct Bucket {
+        uint64_t bytesPerSecond = 0;
+        double tokens = 0;
+        std::chrono::steady_clock::time_point lastRefill = std::chrono::steady_clock::now();
+        uint64_t totalBytes = 0;
+        std::chrono::steady_clock::duration totalWait{};
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable rateChanged;
+    Bucket buckets[2];
+
+    Bucket& bucket(Priority priority) { return buckets[static_cast<size_t>(priority)]; }
+    const Bucket& bucket(Priority priority) const { return buckets[static_cast<size_t>(priority)]; }
+
+    // Add the tokens earned since the last refill (caller holds the mutex)
+    static void refill(Bucket& bucket);
+};
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,216 @@
+//
+// SstWriter.cpp
+//
+
+#include "SstWriter.h"
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+SstWriter::SstWriter(const std::string& fileName, size_t pageSize, size_t bufferSize, size_t bytesPerSync,
+                     bool background)
+    : fileName(fileName), pageSize(pageSize), bufferSize(std::max(bufferSize, pageSize)), bytesPerSync(bytesPerSync) {
+    fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("SstWriter: Failed to open file " + fileName + ": " + std::strerror(errno));
+    }
+    buffer.reserve(this->bufferSize);
+    if (background) {
+        queue = std::make_unique<BoundedQueue<WriteTask>>(2);
+        writerThread = std::thread(&SstWriter::runWriter, this);
+    }
+}
+
+SstWriter::~SstWriter() {
+    try {
+        drain();
+    } catch (const std::exception&) {
+        // Reported by finish() if it was called
+    }
+    if (fd >= 0) {
+        try {
+            flushBuffer();
+        } catch (const std::exception&) {
+            // The SST is incomplete either way; its owner removes it
+        }
+        ::close(fd);
+    }
+}
+
+uint64_t SstWriter::appendPage(const Page& page) {
+    if (queue) {
+        return appendPage(std::make_unique<Page>(page));
+    }
+    uint64_t pageOffset = offset;
+    writePage(page);
+    offset += pageSize;
+    return pageOffset;
+}
+
+uint64_t SstWriter::appendPage(std::unique_ptr<Page> page) {
+    if (!queue) {
+        return appendPage(*page);
+    }
+    uint64_t pageOffset = offset;
+    enqueue(WriteTask{std::move(page), {}});
+    offset += pageSize;
+    return pageOffset;
+}
+
+uint64_t SstWriter::appendRegion(const char* data, size_t size) {
+    uint64_t regionOffset = offset;
+    size_t padding = (pageSize - size % pageSize) % pageSize;
+    std::vector<char> region(data, data + size);
+    region.resize(size + padding, 0);
+    offset += region.size();
+    if (queue) {
+        enqueue(WriteTask{nullptr, std::move(region)});
+    } else {
+        append(region.data(), region.size());
+    }
+    return regionOffset;
+}
+
+void SstWriter::rewritePage(uint64_t pageOffset, const Page& page) {
+    if (pageOffset + pageSize > offset) {
+        throw std::runtime_error("SstWriter: Page at offset " + std::to_string(pageOffset) + " was not written yet");
+    }
+    drain();
+    std::vector<char> data = page.serialize();
+    if (data.size() != pageSize) {
+        throw std::runtime_error("SstWriter: Serialized page size does not match page size");
+    }
+    if (pageOffset >= bufferOffset) {
+        // Still buffered
+        std::copy(data.begin(), data.end(), buffer.begin() + static_cast<std::ptrdiff_t>(pageOffset - bufferOffset));
+    } else {
+        writeFully(pageOffset, data.data(), data.size());
+    }
+}
+
+void SstWriter::setRateLimiter(std::shared_ptr<RateLimiter> limiter, RateLimiter::Priority priority) {
+    rateLimiter = std::move(limiter);
+    ioPriority = priority;
+}
+
+void SstWriter::finish(bool sync) {
+    if (fd < 0) {
+        throw std::runtime_error("SstWriter: File is already finished: " + fileName);
+    }
+    bool background = queue != nullptr;
+    drain();
+    auto start = std::chrono::steady_clock::now();
+    flushBuffer();
+    if (sync && ::fsync(fd) != 0) {
+        throw std::runtime_error("SstWriter: Failed to sync file " + fileName + ": " + std::strerror(errno));
+    }
+    ::close(fd);
+    fd = -1;
+    if (background) {
+        // The final write-out and fsync are the tail of the write stage
+        busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void SstWriter::runWriter() {
+    auto start = std::chrono::steady_clock::now();
+    WriteTask task;
+    while (queue->pop(task)) {
+        try {
+            if (task.page) {
+                writePage(*task.page);
+            } else {
+                append(task.data.data(), task.data.size());
+            }
+        } catch (...) {
+            writerError = std::current_exception();
+            // Fail the appends waiting for room
+            queue->close();
+            break;
+        }
+    }
+    busySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                  - queue->getPopWaitSeconds();
+}
+
+void SstWriter::enqueue(WriteTask task) {
+    if (!queue->push(std::move(task))) {
+        // Only the writer thread closes the queue early, when it failed
+        drain();
+    }
+}
+
+void SstWriter::drain() {
+    if (!queue) {
+        return;
+    }
+    queue->close();
+    writerThread.join();
+    queueWaitSeconds = queue->getPushWaitSeconds();
+    queue.reset();
+    if (writerError) {
+        std::exception_ptr error = writerError;
+        writerError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void SstWriter::writePage(const Page& page) {
+    std::vector<char> data = page.serialize();
+    if (data.size() != pageSize) {
+        throw std::runtime_error("SstWriter: Serialized page size does not match page size");
+    }
+    append(data.data(), data.size());
+}
+
+void SstWriter::append(const char* data, size_t size) {
+    while (size > 0) {
+        size_t n = std::min(size, bufferSize - buffer.size());
+        buffer.insert(buffer.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (buffer.size() == bufferSize) {
+            flushBuffer();
+        }
+    }
+}
+
+void SstWriter::flushBuffer() {
+    if (buffer.empty()) {
+        return;
+    }
+    if (rateLimiter) {
+        rateLimiter->request(buffer.size(), ioPriority);
+    }
+    writeFully(bufferOffset, buffer.data(), buffer.size());
+    bufferOffset += buffer.size();
+    buffer.clear();
+
+#ifdef __linux__
+    // Start writeback of what is written so far without waiting for it
+    if (bytesPerSync > 0 && bufferOffset - syncedOffset >= bytesPerSync) {
+        ::sync_file_range(fd, static_cast<off_t>(syncedOffset), static_cast<off_t>(bufferOffset - syncedOffset),
+                          SYNC_FILE_RANGE_WRITE);
+        syncedOffset = bufferOffset;
+    }
+#endif
+}
+
+void SstWriter::writeFully(uint64_t position, const char* data, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pwrite(fd, data + done, size - done, static_cast<off_t>(position + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("SstWriter: Failed to write " + std::to_string(size) + " bytes at offset "
+                                     + std::to_string(position) + " in file " + fileName);
+        }
+        done += static_cast<size_t>(n);
+    }
+}
@@ -0,0 +1,109 @@
+//
+// SstWriter.h
+//
+
+#ifndef SST_WRITER_H
+#define SST_WRITER_H
+
+#include "Page.h"
+#include "BoundedQueue.h"
+#include "RateLimiter.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+// Writes a new SST front to back. Pages are appended to an in-memory buffer that is
+// written out bufferSize bytes at a time; the file is fsynced once by finish().
+// With bytesPerSync > 0, writeback of every bytesPerSync written bytes is started
+// early (sync_file_range on Linux) so the final fsync has little left to do.
+//
+// With background set, pages are serialized and written by a writer thread fed through
+// a double-buffered queue, so the caller can build the next pages meanwhile. Offsets are
+// still returned right away since every page has the same size.
+class SstWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    // Creates or truncates fileName
+    SstWriter(const std::string& fileName, size_t pageSize = 4096, size_t bufferSize = DEFAULT_BUFFER_SIZE,
+              size_t bytesPerSync = 0, bool background = false);
+
+    // Closes the file without syncing if finish() was not called
+    ~SstWriter();
+
+    // Append one page; returns its offset
+    uint64_t appendPage(const Page& page);
+    // Same, handing the page over to the writer thread instead of copying it
+    uint64_t appendPage(std::unique_ptr<Page> page);
+
+    // Append data padded with zeros to whole pages; returns its offset
+    uint64_t appendRegion(const char* data, size_t size);
+
+    // Overwrite the page at an offset that was already appended (e.g. the metadata page);
+    // waits for the writer thread to write everything appended before
+    void rewritePage(uint64_t offset, const Page& page);
+
+    // Charge every write of the buffer to a rate limiter budget; set before appending
+    void setRateLimiter(std::shared_ptr<RateLimiter> limiter, RateLimiter::Priority priority);
+
+    // Offset of the next appended page
+    uint64_t getOffset() const { return offset; }
+    size_t getPageSize() const { return pageSize; }
+
+    // Write out the buffer, fsync (unless sync is false, e.g. for temporary files) and close
+    void finish(bool sync = true);
+
+    // Seconds the writer thread spent serializing, writing and syncing, and seconds
+    // appends waited for the writer thread to make room (both 0 without background)
+    double getBusySeconds() const { return busySeconds; }
+    double getQueueWaitSeconds() const { return queueWaitSeconds; }
+
+    SstWriter(const SstWriter&) = delete;
+    SstWriter& operator=(const SstWriter&) = delete;
+
+private:
+    std::string fileName;
+    size_t pageSize;
+    size_t bufferSize;
+    size_t bytesPerSync;
+    int fd = -1;
+
+    // Bytes not yet written start at file offset bufferOffset
+    std::vector<char> buffer;
+    uint64_t bufferOffset = 0;
+    uint64_t offset = 0;
+    uint64_t syncedOffset = 0;
+
+    std::shared_ptr<RateLimiter> rateLimiter;
+    RateLimiter::Priority ioPriority = RateLimiter::Priority::HIGH;
+
+    // A page to serialize or raw bytes, in append order
+    struct WriteTask {
+        std::unique_ptr<Page> page;
+        std::vector<char> data;
+    };
+    std::unique_ptr<BoundedQueue<WriteTask>> queue;
+    std::thread writerThread;
+    std::exception_ptr writerError;
+    double busySeconds = 0;
+    double queueWaitSeconds = 0;
+
+    // Body of the writer thread
+    void runWriter();
+    // Hand a task to the writer thread, rethrowing its error if it stopped
+    void enqueue(WriteTask task);
+    // Let the writer thread write everything queued and stop; appends are synchronous afterwards
+    void drain();
+
+    void writePage(const Page& page);
+    // Add bytes to the buffer, writing it out whenever it fills up
+    void append(const char* data, size_t size);
+    void flushBuffer();
+    void writeFully(uint64_t position, const char* data, size_t size) const;
+};
+
+#endif // SST_WRITER_H
@@ -0,0 +1,121 @@
+//
+// WAL.cpp
+//
+
+#include "WAL.h"
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+WAL::WAL(const std::string& filePath) : filePath(filePath) {
+    ofs.open(filePath, std::ios::binary | std::ios::app);
+    if (!ofs) {
+        throw std::runtime_error("WAL::WAL() Failed to open log file: " + filePath);
+    }
+    size = fs::file_size(filePath);
+}
+
+WAL::~WAL() {
+    if (ofs.is_open()) {
+        ofs.close();
+    }
+}
+
+void WAL::append(const WriteBatch& batch) {
+    const std::string& rep = batch.getRep();
+    uint32_t payloadSize = static_cast<uint32_t>(rep.size());
+    uint32_t sum = checksum(rep.data(), rep.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ofs.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+    ofs.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+    ofs.write(rep.data(), rep.size());
+    ofs.flush();
+    if (!ofs) {
+        throw std::runtime_error("WAL::append() Failed to write log file: " + filePath);
+    }
+    size += 2 * sizeof(uint32_t) + payloadSize;
+}
+
+void WAL::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ofs.close();
+    ofs.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        throw std::runtime_error("WAL::reset() Failed to truncate log file: " + filePath);
+    }
+    size = 0;
+}
+
+void WAL::roll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string rolledPath = rolledSegmentPath(filePath);
+    if (fs::exists(rolledPath)) {
+        throw std::logic_error("WAL::roll() Rolled segment has not been removed: " + rolledPath);
+    }
+    ofs.close();
+    fs::rename(filePath, rolledPath);
+    ofs.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+        throw std::runtime_error("WAL::roll() Failed to open log file: " + filePath);
+    }
+    size = 0;
+}
+
+void WAL::removeRolledSegment() {
+    std::lock_guard<std::mutex> lock(mutex);
+    fs::remove(rolledSegmentPath(filePath));
+}
+
+uint64_t WAL::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+size_t WAL::replay(const std::string& filePath, const std::function<void(const WriteBatch&)>& apply) {
+    return replaySegment(rolledSegmentPath(filePath), apply) + replaySegment(filePath, apply);
+}
+
+size_t WAL::replaySegment(const std::string& filePath, const std::function<void(const WriteBatch&)>& apply) {
+    std::ifstream ifs(filePath, std::ios::binary);
+    if (!ifs) {
+        return 0;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+
+    size_t offset = 0;
+    size_t numBatches = 0;
+    const size_t recordHeaderSize = 2 * sizeof(uint32_t);
+    while (offset + recordHeaderSize <= data.size()) {
+        uint32_t size, sum;
+        std::memcpy(&size, data.data() + offset, sizeof(size));
+        std::memcpy(&sum, data.data() + offset + sizeof(size), sizeof(sum));
+        const char* payload = data.data() + offset + recordHeaderSize;
+        if (size < WriteBatch::HEADER_SIZE || offset + recordHeaderSize + size > data.size()
+            || checksum(payload, size) != sum) {
+            break;
+        }
+        apply(WriteBatch::fromRep(std::string(payload, size)));
+        offset += recordHeaderSize + size;
+        numBatches++;
+    }
+
+    if (offset < data.size()) {
+        fs::resize_file(filePath, offset);
+    }
+    return numBatches;
+}
+
+// FNV-1a; only needs to catch torn writes at the tail of the log
+uint32_t WAL::checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,68 @@
+//
+// WAL.h
+//
+
+#ifndef WAL_H
+#define WAL_H
+
+#include "WriteBatch.h"
+#include <string>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+#include <mutex>
+
+// Write-ahead log for the memtable. Every write batch is appended as one record
+//
+//   uint32 payload size | uint32 checksum | WriteBatch rep
+//
+// before it is applied, so the memtable can be rebuilt after a restart. The log
+// is reset once the memtable has been flushed to an SST.
+//
+// A log shared by several memtables (column families) cannot be reset by any one
+// of them. It is rolled instead: the current segment is renamed to filePath.1 and
+// a new one started; once every memtable holding writes from the rolled segment
+// has been flushed, the segment is removed.
+class WAL {
+public:
+    explicit WAL(const std::string& filePath);
+    ~WAL();
+
+    // Append one batch and flush it to the OS
+    void append(const WriteBatch& batch);
+
+    // Truncate the log (its contents are now persisted in SSTs)
+    void reset();
+
+    // Move the current segment aside and start a new one. Fails if the segment
+    // rolled before has not been removed yet.
+    void roll();
+    // Delete the rolled segment (its contents are now persisted in SSTs)
+    void removeRolledSegment();
+
+    // Bytes in the current segment
+    uint64_t getSize() const;
+
+    const std::string& getFilePath() const { return filePath; }
+    static std::string rolledSegmentPath(const std::string& filePath) { return filePath + ".1"; }
+
+    // Apply every complete record of the log at filePath in order (starting with a
+    // segment rolled off it that is still there) and return the number of batches.
+    // A torn or corrupt record ends a segment; it and anything after it are cut off
+    // so new records are appended after the last good one.
+    static size_t replay(const std::string& filePath, const std::function<void(const WriteBatch&)>& apply);
+
+    // Checksum of a record payload (also used by the manifest log)
+    static uint32_t checksum(const char* data, size_t size);
+
+private:
+    std::string filePath;
+    std::ofstream ofs;
+    uint64_t size = 0;
+    mutable std::mutex mutex;
+
+    static size_t replaySegment(const std::string& filePath,
+                                const std::function<void(const WriteBatch&)>& apply);
+};
+
+#endif // WAL_H
@@ -0,0 +1,186 @@
+//
+// XorFilter.cpp
+//
+
+#include "XorFilter.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+XorFilter::XorFilter() : seed(0), blockLength(0), numKeys(0) {
+    // Default constructor for deserialization
+}
+
+XorFilter::XorFilter(std::vector<uint64_t> keyHashes) : seed(0), blockLength(0), numKeys(0) {
+    // Peeling requires distinct keys
+    std::sort(keyHashes.begin(), keyHashes.end());
+    keyHashes.erase(std::unique(keyHashes.begin(), keyHashes.end()), keyHashes.end());
+    numKeys = keyHashes.size();
+
+    // Capacity 1.23 * n + 32 gives a high probability of successful peeling
+    size_t capacity = 32 + static_cast<size_t>(1.23 * static_cast<double>(numKeys));
+    blockLength = capacity / 3;
+
+    // Retry with a new seed until the hypergraph peels
+    uint64_t nextSeed = 0x726b2b9d438b9d4dULL;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        seed = nextSeed;
+        if (tryBuild(keyHashes)) {
+            return;
+        }
+        nextSeed = mix(nextSeed, attempt + 1);
+    }
+    throw std::runtime_error("XorFilter: Failed to build filter");
+}
+
+bool XorFilter::tryBuild(const std::vector<uint64_t>& keyHashes) {
+    size_t arrayLength = blockLength * 3;
+    fingerprints.assign(arrayLength, 0);
+
+    // For every slot: number of keys mapped to it and the xor of their hashes
+    std::vector<uint32_t> counts(arrayLength, 0);
+    std::vector<uint64_t> xorMasks(arrayLength, 0);
+
+    for (uint64_t key : keyHashes) {
+        uint64_t hash = mix(key, seed);
+        for (int i = 0; i < 3; ++i) {
+            uint32_t index = slot(hash, i);
+            counts[index]++;
+            xorMasks[index] ^= hash;
+        }
+    }
+
+    // Peel slots that hold exactly one key
+    std::vector<uint32_t> queue;
+    queue.reserve(arrayLength);
+    for (uint32_t index = 0; index < arrayLength; ++index) {
+        if (counts[index] == 1) {
+            queue.push_back(index);
+        }
+    }
+
+    // Peeling order: (hash, slot that identifies it)
+    std::vector<std::pair<uint64_t, uint32_t>> stack;
+    stack.reserve(keyHashes.size());
+
+    while (!queue.empty()) {
+        uint32_t index = queue.back();
+        queue.pop_back();
+        if (counts[index] != 1) {
+            continue;
+        }
+        uint64_t hash = xorMasks[index];
+        stack.emplace_back(hash, index);
+        for (int i = 0; i < 3; ++i) {
+            uint32_t other = slot(hash, i);
+            counts[other]--;
+            xorMasks[other] ^= hash;
+            if (counts[other] == 1) {
+                queue.push_back(other);
+            }
+        }
+    }
+
+    if (stack.size() != keyHashes.size()) {
+        return false;
+    }
+
+    // Assign fingerprints in reverse peeling order
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        uint64_t hash = it->first;
+        uint32_t index = it->second;
+        uint8_t value = fingerprint(hash);
+        for (int i = 0; i < 3; ++i) {
+            uint32_t other = slot(hash, i);
+            if (other != index) {
+                value ^= fingerprints[other];
+            }
+        }
+        fingerprints[index] = value;
+    }
+    return true;
+}
+
+bool XorFilter::possiblyContains(const KeyValueWrapper& kv) const {
+    return possiblyContainsHash(hashKey(kv));
+}
+
+bool XorFilter::possiblyContainsHash(uint64_t keyHash) const {
+    if (blockLength == 0) {
+        // Empty filter
+        return false;
+    }
+    uint64_t hash = mix(keyHash, seed);
+    uint8_t value = fingerprint(hash);
+    value ^= fingerprints[slot(hash, 0)];
+    value ^= fingerprints[slot(hash, 1)];
+    value ^= fingerprints[slot(hash, 2)];
+    return value == 0;
+}
+
+std::vector<char> XorFilter::serialize() const {
+    std::vector<char> data(sizeof(seed) + sizeof(blockLength) + sizeof(numKeys));
+
+    // Serialize seed, blockLength, numKeys
+    size_t offset = 0;
+    std::memcpy(data.data() + offset, &seed, sizeof(seed));
+    offset += sizeof(seed);
+    std::memcpy(data.data() + offset, &blockLength, sizeof(blockLength));
+    offset += sizeof(blockLength);
+    std::memcpy(data.data() + offset, &numKeys, sizeof(numKeys));
+    offset += sizeof(numKeys);
+
+    // Append fingerprints
+    data.insert(data.end(), fingerprints.begin(), fingerprints.end());
+    return data;
+}
+
+void XorFilter::deserialize(const std::vector<char>& data) {
+    if (data.size() < sizeof(seed) + sizeof(blockLength) + sizeof(numKeys)) {
+        throw std::runtime_error("Invalid xor filter data");
+    }
+
+    size_t offset = 0;
+    std::memcpy(&seed, data.data() + offset, sizeof(seed));
+    offset += sizeof(seed);
+    std::memcpy(&blockLength, data.data() + offset, sizeof(blockLength));
+    offset += sizeof(blockLength);
+    std::memcpy(&numKeys, data.data() + offset, sizeof(numKeys));
+    offset += sizeof(numKeys);
+
+    if (data.size() - offset < blockLength * 3) {
+        throw std::runtime_error("Invalid xor filter data: truncated fingerprints");
+    }
+    fingerprints.assign(data.begin() + offset, data.begin() + offset + blockLength * 3);
+}
+
+size_t XorFilter::getSerializedSize() const {
+    return sizeof(seed) + sizeof(blockLength) + sizeof(numKeys) + fingerprints.size();
+}
+
+uint64_t XorFilter::hashKey(const KeyValueWrapper& kv) {
+    return std::hash<std::string>{}(kv.getKeyString());
+}
+
+uint32_t XorFilter::slot(uint64_t hash, int i) const {
+    // Rotate to get three independent 32-bit values, then map each into its block
+    uint64_t rotated = i == 0 ? hash : ((hash << (21 * i)) | (hash >> (64 - 21 * i)));
+    uint64_t reduced = (static_cast<uint64_t>(static_cast<uint32_t>(rotated)) * blockLength) >> 32;
+    return static_cast<uint32_t>(reduced + i * blockLength);
+}
+
+uint8_t XorFilter::fingerprint(uint64_t hash) {
+    return static_cast<uint8_t>(hash ^ (hash >> 32));
+}
+
+uint64_t XorFilter::mix(uint64_t key, uint64_t seed) {
+    // murmur3 64-bit finalizer
+    uint64_t h = key + seed;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,60 @@
+//
+// XorFilter.h
+//
+
+#ifndef XOR_FILTER_H
+#define XOR_FILTER_H
+
+#include "KeyValue.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+
+// Static xor filter with 8-bit fingerprints (Graf & Lemire, "Xor Filters").
+// Built once from the full key set of an immutable SST: ~9.84 bits per key
+// for a false positive rate of ~0.39%, about 20% less memory than a Bloom
+// filter with the same false positive rate.
+class XorFilter {
+public:
+    // Default constructor for deserialization
+    XorFilter();
+
+    // Build the filter from the hashes of all keys (duplicates are ignored)
+    explicit XorFilter(std::vector<uint64_t> keyHashes);
+
+    // Check if a key is possibly in the filter
+    bool possiblyContains(const KeyValueWrapper& kv) const;
+    bool possiblyContainsHash(uint64_t keyHash) const;
+
+    // Serialization and deserialization
+    std::vector<char> serialize() const;
+    void deserialize(const std::vector<char>& data);
+
+    // Get the size of the serialized filter
+    size_t getSerializedSize() const;
+
+    // Number of distinct keys the filter was built from
+    size_t getNumKeys() const { return numKeys; }
+
+    // Hash of the key only (not the value), shared by builders and readers
+    static uint64_t hashKey(const KeyValueWrapper& kv);
+
+    // Expected false positive rate of 8-bit fingerprints
+    static constexpr double FALSE_POSITIVE_RATE = 1.0 / 256;
+
+private:
+    uint64_t seed;
+    uint64_t blockLength;
+    uint64_t numKeys;
+    std::vector<uint8_t> fingerprints; // 3 * blockLength slots
+
+    // Try to build with the current seed; false if peeling fails
+    bool tryBuild(const std::vector<uint64_t>& keyHashes);
+
+    // Slot of the key in block i (0, 1, 2)
+    uint32_t slot(uint64_t hash, int i) const;
+    static uint8_t fingerprint(uint64_t hash);
+    static uint64_t mix(uint64_t key, uint64_t seed);
+};
+
+#endif // XOR_FILTER_H
@@ -4,6 +4,7 @@
 // VeloxDB.cpp
 #include "VeloxDB.h"
 #include <iostream>
+#include <fstream>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -51,11 +52,22 @@ void VeloxDB::Open(const std::string& db_name) {
         std::cout << "Existing database directory: " << db_name << std::endl;
     }
 
+    // Set API attribute fs::path
+    set_path(db_path);
+
+    // With column families, the default one must not reset the WAL they share while replaying it
+    bool hasColumnFamilies = fs::exists(db_path / COLUMN_FAMILIES_FILE);
+    if (hasColumnFamilies) {
+        std::unique_lock<std::shared_mutex> lock(columnFamiliesMutex);
+        shareDefaultColumnFamily();
+    }
+
     // Set the database path in LSMTree
     lsmTree->setDBPath(db_path.string());
 
-    // Set API attribute fs::path
-    set_path(db_path);
+    if (hasColumnFamilies) {
+        openColumnFamilies();
+    }
 
     // Set the flag to indicate the database is open
     is_open = true;
@@ -68,11 +80,49 @@ void VeloxDB::Close() {
 
     // Save state of LSMTree
     lsmTree->saveState();
+    {
+        std::unique_lock<std::shared_mutex> lock(columnFamiliesMutex);
+        for (auto& [id, family] : columnFamilies) {
+            family->saveState();
+        }
+        columnFamilies.clear();
+    }
 
     // Set the flag to indicate the database is closed
     is_open = false;
 }
 
+// Batch write method
+void VeloxDB::Write(WriteBatch& batch) {
+    check_if_open();
+    if (batch.Count() == 0) {
+        return;
+    }
+    std::vector<uint32_t> ids = batch.ColumnFamilyIds();
+    if (ids.size() == 1) {
+        columnFamilyTree(ids.front()).write(batch);
+    } else {
+        // Lock the families in id order, then log the batch once for all of them
+        std::vector<LSMTree*> trees;
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        for (uint32_t id : ids) {
+            trees.push_back(&columnFamilyTree(id));
+        }
+        for (LSMTree* tree : trees) {
+            locks.push_back(tree->lockForWrite());
+        }
+        for (LSMTree* tree : trees) {
+            tree->prepareWrite(batch);
+        }
+        batch.setSequence(shared->lastSequenceNumber.fetch_add(batch.Count()) + 1);
+        shared->wal->append(batch);
+        for (LSMTree* tree : trees) {
+            tree->applyWrite(batch);
+        }
+    }
+    reclaimWALIfFull();
+}
+
 // Get method
 KeyValueWrapper VeloxDB::Get(const KeyValueWrapper& keyValueWrapper) {
     check_if_open();
@@ -81,23 +131,75 @@ KeyValueWrapper VeloxDB::Get(const KeyValueWrapper& keyValueWrapper) {
     return lsmTree->get(keyValueWrapper);
 }
 
+KeyValueWrapper VeloxDB::Get(const KeyValueWrapper& keyValueWrapper, const std::shared_ptr<const Snapshot>& snapshot) {
+    check_if_open();
+    if (!snapshot) {
+        throw std::invalid_argument("Snapshot is null");
+    }
+    return lsmTree->get(keyValueWrapper, *snapshot);
+}
+
+// Snapshot method
+std::shared_ptr<const Snapshot> VeloxDB::GetSnapshot() {
+    check_if_open();
+    return lsmTree->getSnapshot();
+}
+
+// MultiGet method
+std::vector<KeyValueWrapper> VeloxDB::MultiGet(const std::vector<KeyValueWrapper>& keys) {
+    check_if_open();
+    return lsmTree->multiGet(keys);
+}
+
 // Scan method
-std::vector<KeyValueWrapper> VeloxDB::Scan(const KeyValueWrapper& small_key, const KeyValueWrapper& large_key) {
+std::vector<KeyValueWrapper> VeloxDB::Scan(const KeyValueWrapper& small_key, const KeyValueWrapper& large_key,
+                                           const ScanOptions& options) {
     check_if_open();
 
     std::vector<KeyValueWrapper> vectorResult;
     // Use lsmTree's scan method
-    lsmTree->scan(small_key, large_key, vectorResult);
+    lsmTree->scan(small_key, large_key, vectorResult, options);
 
 
     return vectorResult;
 }
 
+// Iterator over the whole database
+std::unique_ptr<DBIterator> VeloxDB::NewIterator(const std::shared_ptr<const Snapshot>& snapshot) {
+    check_if_open();
+    return lsmTree->newIterator(snapshot);
+}
+
+// Prefix scan method
+std::vector<KeyValueWrapper> VeloxDB::ScanPrefix(const std::string& prefix, const ScanOptions& options) {
+    check_if_open();
+
+    std::vector<KeyValueWrapper> vectorResult;
+    lsmTree->scanPrefix(prefix, vectorResult, options);
+
+    return vectorResult;
+}
+
 // Delete method
 void VeloxDB::Delete(KeyValueWrapper& keyValueWrapper) {
     check_if_open();
     keyValueWrapper.setTombstone(true);
     lsmTree->put(keyValueWrapper);
+    reclaimWALIfFull();
+}
+
+// Range delete method
+void VeloxDB::DeleteRange(const KeyValueWrapper& start_key, const KeyValueWrapper& end_key) {
+    check_if_open();
+    lsmTree->deleteRange(start_key, end_key);
+    reclaimWALIfFull();
+}
+
+// Merge method
+void VeloxDB::Merge(const KeyValueWrapper& keyValueWrapper) {
+    check_if_open();
+    lsmTree->merge(keyValueWrapper);
+    reclaimWALIfFull();
 }
 
 // Update method
@@ -111,9 +213,233 @@ int VeloxDB::Update(const KeyValueWrapper& keyValueWrapper) {
         return 0;
     }
     lsmTree->put(keyValueWrapper);
+    reclaimWALIfFull();
     return 1;
 }
 
+// Create a column family, sharing the WAL and block cache with the others
+ColumnFamilyHandle VeloxDB::CreateColumnFamily(const std::string& name, const ColumnFamilyOptions& options) {
+    check_if_open();
+    std::unique_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    if (name.empty() || name == ColumnFamilyHandle::DEFAULT_NAME) {
+        throw std::invalid_argument("Invalid column family name: " + name);
+    }
+    for (const auto& [id, family] : columnFamilies) {
+        if (family->getColumnFamily().getName() == name) {
+            throw std::invalid_argument("Column family already exists: " + name);
+        }
+    }
+    if (!shared) {
+        shareDefaultColumnFamily();
+    }
+
+    uint32_t id = columnFamilies.empty() ? ColumnFamilyHandle::DEFAULT_ID + 1 : columnFamilies.rbegin()->first + 1;
+    ColumnFamilyHandle handle(id, name);
+    columnFamilyOptions[name] = options;
+    columnFamilies[id] = makeColumnFamily(handle);
+    // Registered before anything is written to it, so a restart finds its records in the WAL
+    writeColumnFamilies();
+    return handle;
+}
+
+ColumnFamilyHandle VeloxDB::GetColumnFamily(const std::string& name) const {
+    if (name == ColumnFamilyHandle::DEFAULT_NAME) {
+        return ColumnFamilyHandle();
+    }
+    std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    for (const auto& [id, family] : columnFamilies) {
+        if (family->getColumnFamily().getName() == name) {
+            return family->getColumnFamily();
+        }
+    }
+    throw std::invalid_argument("Unknown column family: " + name);
+}
+
+std::vector<ColumnFamilyHandle> VeloxDB::ListColumnFamilies() const {
+    std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    std::vector<ColumnFamilyHandle> handles{ColumnFamilyHandle()};
+    for (const auto& [id, family] : columnFamilies) {
+        handles.push_back(family->getColumnFamily());
+    }
+    return handles;
+}
+
+void VeloxDB::setColumnFamilyOptions(const std::string& name, const ColumnFamilyOptions& options) {
+    std::unique_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    columnFamilyOptions[name] = options;
+}
+
+KeyValueWrapper VeloxDB::Get(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& keyValueWrapper) {
+    check_if_open();
+    return columnFamilyTree(columnFamily).get(keyValueWrapper);
+}
+
+void VeloxDB::DeleteRange(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& start_key,
+                          const KeyValueWrapper& end_key) {
+    check_if_open();
+    columnFamilyTree(columnFamily).deleteRange(start_key, end_key);
+    reclaimWALIfFull();
+}
+
+std::vector<KeyValueWrapper> VeloxDB::Scan(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& small_key,
+                                           const KeyValueWrapper& large_key, const ScanOptions& options) {
+    check_if_open();
+    std::vector<KeyValueWrapper> vectorResult;
+    columnFamilyTree(columnFamily).scan(small_key, large_key, vectorResult, options);
+    return vectorResult;
+}
+
+std::unique_ptr<DBIterator> VeloxDB::NewIterator(const ColumnFamilyHandle& columnFamily) {
+    check_if_open();
+    return columnFamilyTree(columnFamily).newIterator();
+}
+
+LSMTree& VeloxDB::columnFamilyTree(uint32_t id) const {
+    if (id == ColumnFamilyHandle::DEFAULT_ID) {
+        return *lsmTree;
+    }
+    std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    auto it = columnFamilies.find(id);
+    if (it == columnFamilies.end()) {
+        throw std::invalid_argument("Unknown column family id: " + std::to_string(id));
+    }
+    return *it->second;
+}
+
+void VeloxDB::shareDefaultColumnFamily() {
+    shared = lsmTree->shareWithColumnFamilies(std::make_shared<BufferPool>(bufferPoolCapacity, bufferPoolPolicy));
+}
+
+std::unique_ptr<LSMTree> VeloxDB::makeColumnFamily(const ColumnFamilyHandle& handle) {
+    auto it = columnFamilyOptions.find(handle.getName());
+    ColumnFamilyOptions options = it == columnFamilyOptions.end() ? ColumnFamilyOptions() : it->second;
+    size_t memtableSize = options.memtableSize > 0 ? options.memtableSize : static_cast<size_t>(memtable_size);
+
+    auto family = std::make_unique<LSMTree>(memtableSize, columnFamilyPath(handle.getId()).string(), handle, shared,
+                                            options.mergeOperator);
+    family->setDefaultTTL(options.defaultTTLSeconds.value_or(lsmTree->getDefaultTTL()));
+    family->setFilterType(options.filterType.value_or(lsmTree->getFilterType()));
+    family->setBloomFilterBitsPerKey(options.bloomBitsPerKey.value_or(lsmTree->getBloomFilterBitsPerKey()));
+    family->setPrefixExtractor(options.prefixLength.value_or(lsmTree->getPrefixLength()));
+    family->setMonkeyFilterAllocation(lsmTree->isMonkeyFilterAllocation());
+    family->setIOQueueDepth(lsmTree->getIOQueueDepth());
+    family->setSSTReadMode(lsmTree->getSSTReadMode());
+    family->setSSTBytesPerSync(lsmTree->getSSTBytesPerSync());
+    family->setMaxSubcompactions(lsmTree->getMaxSubcompactions());
+    family->setTombstoneCompactionRatio(lsmTree->getTombstoneCompactionRatio());
+    return family;
+}
+
+void VeloxDB::forEachColumnFamily(const std::function<void(LSMTree&, const ColumnFamilyOptions&)>& apply) {
+    std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    apply(*lsmTree, ColumnFamilyOptions());
+    for (auto& [id, family] : columnFamilies) {
+        auto it = columnFamilyOptions.find(family->getColumnFamily().getName());
+        apply(*family, it == columnFamilyOptions.end() ? ColumnFamilyOptions() : it->second);
+    }
+}
+
+void VeloxDB::openColumnFamilies() {
+    {
+        std::unique_lock<std::shared_mutex> lock(columnFamiliesMutex);
+        for (const auto& handle : readColumnFamilies()) {
+            columnFamilies[handle.getId()] = makeColumnFamily(handle);
+        }
+    }
+    // The default family replayed its records when its path was set
+    WAL::replay(shared->wal->getFilePath(), [this](const WriteBatch& batch) {
+        for (auto& [id, family] : columnFamilies) {
+            family->recover(batch);
+        }
+    });
+
+    // A restart while reclaiming the WAL leaves the rolled segment behind; its writes are
+    // in the memtables again, so finish the job
+    if (fs::exists(WAL::rolledSegmentPath(shared->wal->getFilePath()))) {
+        lsmTree->flush();
+        for (auto& [id, family] : columnFamilies) {
+            family->flush();
+        }
+        shared->wal->removeRolledSegment();
+    }
+}
+
+void VeloxDB::reclaimWALIfFull() {
+    std::shared_ptr<ColumnFamilyShared> sharedState;
+    {
+        std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+        sharedState = shared;
+    }
+    if (!sharedState || sharedState->wal->getSize() < maxWALSize) {
+        return;
+    }
+    std::lock_guard<std::mutex> reclaimLock(walReclaimMutex);
+    if (sharedState->wal->getSize() < maxWALSize) {
+        return; // another writer got here first
+    }
+    // Writes logged before the roll are applied by the time their family's flush gets its lock
+    sharedState->wal->roll();
+    lsmTree->flush();
+    {
+        std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+        for (auto& [id, family] : columnFamilies) {
+            family->flush();
+        }
+    }
+    sharedState->wal->removeRolledSegment();
+}
+
+void VeloxDB::compactExpiredColumnFamilies() {
+    lsmTree->compactExpired();
+    std::shared_lock<std::shared_mutex> lock(columnFamiliesMutex);
+    for (auto& [id, family] : columnFamilies) {
+        family->compactExpired();
+    }
+}
+
+// Registry: uint32 count | count x (uint32 id | uint32 name length | name), replaced atomically
+void VeloxDB::writeColumnFamilies() const {
+    fs::path registryPath = path / COLUMN_FAMILIES_FILE;
+    fs::path tempPath = registryPath.string() + ".tmp";
+    std::ofstream ofs(tempPath, std::ios::binary | std::ios::trunc);
+    uint32_t count = static_cast<uint32_t>(columnFamilies.size());
+    ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& [id, family] : columnFamilies) {
+        const std::string& name = family->getColumnFamily().getName();
+        uint32_t nameLength = static_cast<uint32_t>(name.size());
+        ofs.write(reinterpret_cast<const char*>(&id), sizeof(id));
+        ofs.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        ofs.write(name.data(), nameLength);
+    }
+    ofs.close();
+    if (!ofs) {
+        throw std::runtime_error("VeloxDB: failed to write column family registry " + tempPath.string());
+    }
+    fs::rename(tempPath, registryPath);
+}
+
+std::vector<ColumnFamilyHandle> VeloxDB::readColumnFamilies() const {
+    fs::path registryPath = path / COLUMN_FAMILIES_FILE;
+    std::ifstream ifs(registryPath, std::ios::binary);
+    uint32_t count = 0;
+    if (!ifs.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        throw std::runtime_error("VeloxDB: failed to read column family registry " + registryPath.string());
+    }
+    std::vector<ColumnFamilyHandle> handles;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t id, nameLength;
+        ifs.read(reinterpret_cast<char*>(&id), sizeof(id));
+        ifs.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
+        std::string name(nameLength, '\0');
+        ifs.read(&name[0], nameLength);
+        if (!ifs) {
+            throw std::runtime_error("VeloxDB: truncated column family registry " + registryPath.string());
+        }
+        handles.emplace_back(id, name);
+    }
+    return handles;
+}
+
 // Helper function to set path
 void VeloxDB::set_path(const fs::path& db_path) {
     path = db_path;
@@ -137,3 +463,120 @@ void VeloxDB::printCacheHit() const {
     // Example:
     // std::cout << "Cache hit: " << lsmTree->getTotalCacheHits() << " times." << std::endl;
 }
+
+// Number of page reads kept in flight
+void VeloxDB::setIOQueueDepth(size_t depth) {
+    forEachColumnFamily([depth](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setIOQueueDepth(depth);
+    });
+}
+
+// pread or mmap for SST pages
+void VeloxDB::setSSTReadMode(SSTReadMode mode) {
+    forEachColumnFamily([mode](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setSSTReadMode(mode);
+    });
+}
+
+// Incremental syncing of SST writes
+void VeloxDB::setSSTBytesPerSync(size_t bytesPerSync) {
+    forEachColumnFamily([bytesPerSync](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setSSTBytesPerSync(bytesPerSync);
+    });
+}
+
+// Parallel key-range subcompactions
+void VeloxDB::setMaxSubcompactions(size_t n) {
+    forEachColumnFamily([n](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setMaxSubcompactions(n);
+    });
+}
+
+// Tombstone-triggered compaction
+void VeloxDB::setTombstoneCompactionRatio(double ratio) {
+    forEachColumnFamily([ratio](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setTombstoneCompactionRatio(ratio);
+    });
+}
+
+// Merge operands
+void VeloxDB::setMergeOperator(std::shared_ptr<const MergeOperator> mergeOperator) {
+    lsmTree->setMergeOperator(std::move(mergeOperator));
+}
+
+// Expiry
+void VeloxDB::setDefaultTTL(uint64_t ttlSeconds) {
+    forEachColumnFamily([ttlSeconds](LSMTree& tree, const ColumnFamilyOptions& options) {
+        if (!options.defaultTTLSeconds) {
+            tree.setDefaultTTL(ttlSeconds);
+        }
+    });
+}
+
+void VeloxDB::setPeriodicCompactionSeconds(uint64_t seconds) {
+    periodicCompaction.reset();
+    if (seconds > 0) {
+        periodicCompaction = std::make_unique<PeriodicTask>("VeloxDB: periodic compaction",
+                                                            std::chrono::seconds(seconds),
+                                                            [this] { compactExpiredColumnFamilies(); });
+    }
+}
+
+// Background write budgets
+void VeloxDB::setFlushRateLimit(uint64_t bytesPerSecond) {
+    lsmTree->setFlushRateLimit(bytesPerSecond);
+}
+
+void VeloxDB::setCompactionRateLimit(uint64_t bytesPerSecond) {
+    lsmTree->setCompactionRateLimit(bytesPerSecond);
+}
+
+// Full compaction: merge all SSTs into the bottommost level
+void VeloxDB::Compact() {
+    check_if_open();
+    lsmTree->compactAll();
+}
+
+// Set the average Bloom filter bits per key
+void VeloxDB::setBloomFilterBitsPerKey(double bitsPerKey) {
+    forEachColumnFamily([bitsPerKey](LSMTree& tree, const ColumnFamilyOptions& options) {
+        if (!options.bloomBitsPerKey) {
+            tree.setBloomFilterBitsPerKey(bitsPerKey);
+        }
+    });
+}
+
+// Allocate filter bits per level (more bits for smaller levels)
+void VeloxDB::setMonkeyFilterAllocation(bool enabled) {
+    forEachColumnFamily([enabled](LSMTree& tree, const ColumnFamilyOptions&) {
+        tree.setMonkeyFilterAllocation(enabled);
+    });
+}
+
+// Choose between per-leaf Bloom filters and one xor filter per SST
+void VeloxDB::setFilterType(SSTFilterType type) {
+    forEachColumnFamily([type](LSMTree& tree, const ColumnFamilyOptions& options) {
+        if (!options.filterType) {
+            tree.setFilterType(type);
+        }
+    });
+}
+
+// Build prefix Bloom filters on the first prefixLength bytes of string keys
+void VeloxDB::setPrefixExtractor(size_t prefixLength) {
+    forEachColumnFamily([prefixLength](LSMTree& tree, const ColumnFamilyOptions& options) {
+        if (!options.prefixLength) {
+            tree.setPrefixExtractor(prefixLength);
+        }
+    });
+}
+
+// Print filter memory and expected false positive rate per level
+void VeloxDB::printFilterStats() const {
+    lsmTree->printFilterStats();
+}
+
+// Print how busy each compaction stage was
+void VeloxDB::printCompactionStats() const {
+    lsmTree->printCompactionStats();
+}
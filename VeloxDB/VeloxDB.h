@@ -8,8 +8,26 @@
 
 #include "KeyValue.h"
 #include "LSMTree.h"
+#include "ColumnFamily.h"
+#include "PeriodicTask.h"
 #include <memory>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+
+// Options of a column family; the database's settings apply to everything not listed,
+// and to the TTL and filter settings left unset
+struct ColumnFamilyOptions {
+    size_t memtableSize = 0; // 0 = the database's memtable size
+    std::shared_ptr<const MergeOperator> mergeOperator;
+    std::optional<uint64_t> defaultTTLSeconds; // 0 = none, also if the database has one
+    std::optional<SSTFilterType> filterType;
+    std::optional<double> bloomBitsPerKey;
+    std::optional<size_t> prefixLength;
+};
 
 class VeloxDB {
 public:
@@ -26,18 +44,46 @@ public:
     // API methods
     template<typename K, typename V>
     void Put(K key, V value);
+    // PUT with a time to live (expires ttlSeconds from now)
+    template<typename K, typename V>
+    void Put(K key, V value, uint64_t ttlSeconds);
+
+    // WRITE (applies all records of the batch atomically)
+    void Write(WriteBatch& batch);
 
     // GET
     KeyValueWrapper Get(const KeyValueWrapper& keyValueWrapper);
     // Overloaded Get method (takes a key and uses it for lookup)
     template<typename K>
     KeyValueWrapper Get(K key);
+    // Get as of a snapshot
+    KeyValueWrapper Get(const KeyValueWrapper& keyValueWrapper, const std::shared_ptr<const Snapshot>& snapshot);
+    template<typename K>
+    KeyValueWrapper Get(K key, const std::shared_ptr<const Snapshot>& snapshot);
+
+    // SNAPSHOT (consistent view for Get, Scan via ScanOptions::snapshot and NewIterator;
+    // holds on to the data it sees until released; the next write copies the memtable)
+    std::shared_ptr<const Snapshot> GetSnapshot();
+
+    // MULTIGET (results[i] answers keys[i]; empty if not found)
+    std::vector<KeyValueWrapper> MultiGet(const std::vector<KeyValueWrapper>& keys);
+    // Overloaded MultiGet method (takes plain keys)
+    template<typename K>
+    std::vector<KeyValueWrapper> MultiGet(const std::vector<K>& keys);
 
     // SCAN
-    std::vector<KeyValueWrapper> Scan(const KeyValueWrapper& small_key, const KeyValueWrapper& large_key);
+    // options.limit caps the number of rows, options.reverse returns them largest key first
+    std::vector<KeyValueWrapper> Scan(const KeyValueWrapper& small_key, const KeyValueWrapper& large_key,
+                                      const ScanOptions& options = ScanOptions());
     // Overloaded Scan method (takes two keys and uses them for scanning)
     template<typename K1, typename K2>
-    std::vector<KeyValueWrapper> Scan(K1 small_key, K2 large_key);
+    std::vector<KeyValueWrapper> Scan(K1 small_key, K2 large_key, const ScanOptions& options = ScanOptions());
+
+    // ITERATOR (streams the database in key order; Seek/SeekToFirst before use)
+    std::unique_ptr<DBIterator> NewIterator(const std::shared_ptr<const Snapshot>& snapshot = nullptr);
+
+    // SCAN PREFIX (string keys starting with prefix)
+    std::vector<KeyValueWrapper> ScanPrefix(const std::string& prefix, const ScanOptions& options = ScanOptions());
 
     // DELETE
     void Delete(KeyValueWrapper& keyValueWrapper);
@@ -45,21 +91,111 @@ public:
     template<typename K>
     void Delete(K key);
 
+    // DELETE RANGE (every key in [start_key, end_key), with one write)
+    void DeleteRange(const KeyValueWrapper& start_key, const KeyValueWrapper& end_key);
+    template<typename K1, typename K2>
+    void DeleteRange(K1 start_key, K2 end_key);
+
+    // MERGE (combine value into the key's current value with the merge operator,
+    // without reading it first)
+    void Merge(const KeyValueWrapper& keyValueWrapper);
+    template<typename K, typename V>
+    void Merge(K key, V value);
+
     // UPDATE
     int Update(const KeyValueWrapper& keyValueWrapper);
     // Overloaded Update method (takes a key and uses it for lookup)
     template<typename K, typename V>
     int Update(K key, V value);
 
+    // COLUMN FAMILIES (separate keyspaces, each with its own memtable, levels and options,
+    // sharing the WAL, block cache and background thread; Write applies a batch spanning
+    // several of them atomically). Everything written without a handle goes to the default family.
+    ColumnFamilyHandle CreateColumnFamily(const std::string& name,
+                                          const ColumnFamilyOptions& options = ColumnFamilyOptions());
+    ColumnFamilyHandle GetColumnFamily(const std::string& name) const;
+    std::vector<ColumnFamilyHandle> ListColumnFamilies() const;
+    // Options of a family opened by Open; set before Open (merge operands in the WAL need the operator)
+    void setColumnFamilyOptions(const std::string& name, const ColumnFamilyOptions& options);
+
+    // The data operations for a column family
+    template<typename K, typename V>
+    void Put(const ColumnFamilyHandle& columnFamily, K key, V value);
+    KeyValueWrapper Get(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& keyValueWrapper);
+    template<typename K>
+    KeyValueWrapper Get(const ColumnFamilyHandle& columnFamily, K key);
+    template<typename K>
+    void Delete(const ColumnFamilyHandle& columnFamily, K key);
+    void DeleteRange(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& start_key,
+                     const KeyValueWrapper& end_key);
+    template<typename K, typename V>
+    void Merge(const ColumnFamilyHandle& columnFamily, K key, V value);
+    std::vector<KeyValueWrapper> Scan(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& small_key,
+                                      const KeyValueWrapper& large_key, const ScanOptions& options = ScanOptions());
+    template<typename K1, typename K2>
+    std::vector<KeyValueWrapper> Scan(const ColumnFamilyHandle& columnFamily, K1 small_key, K2 large_key,
+                                      const ScanOptions& options = ScanOptions());
+    std::unique_ptr<DBIterator> NewIterator(const ColumnFamilyHandle& columnFamily);
+
+    // Once the WAL shared by the column families grows past this many bytes, it is rolled
+    // and every family flushed so the old segment can be deleted
+    static constexpr uint64_t DEFAULT_MAX_WAL_SIZE = 64ull << 20;
+    void setMaxWALSize(uint64_t bytes) { maxWALSize = bytes; }
+
 
-    // Set buffer pool parameters
+    // Merge all SSTs into the bottommost level
+    void Compact();
+
+    // Set buffer pool parameters (also of the block cache the column families share,
+    // created with the first of them)
     void setBufferPoolParameters(size_t capacity, EvictionPolicy policy);
     void printCacheHit() const;
 
+    // Page reads kept in flight by MultiGet and scans (io_uring or a pread thread pool)
+    void setIOQueueDepth(size_t depth);
+
+    // Read SSTs with pread (default) or memory-mapped, for datasets that fit in RAM
+    void setSSTReadMode(SSTReadMode mode);
+
+    // Start writeback every bytesPerSync bytes while writing an SST (0 = only the final fsync)
+    void setSSTBytesPerSync(size_t bytesPerSync);
+
+    // Merge large compactions as up to n key-range subcompactions in parallel (1 = no split)
+    void setMaxSubcompactions(size_t n);
+
+    // Operator for Merge (e.g. Int64AddOperator, StringAppendOperator); set before Open
+    void setMergeOperator(std::shared_ptr<const MergeOperator> mergeOperator);
+
+    // TTL for every Put and Merge written without one (0 = none), in every column family
+    // without a TTL of its own; expired pairs are hidden from reads and dropped by compaction
+    void setDefaultTTL(uint64_t ttlSeconds);
+    // Rewrite SSTs holding expired pairs every `seconds` in the background, one thread for
+    // all column families (0 = only after flushes)
+    void setPeriodicCompactionSeconds(uint64_t seconds);
+
+    // Compact SSTs with at least this share of tombstones after a flush (0 = never)
+    void setTombstoneCompactionRatio(double ratio);
+
+    // Bytes per second flushes and compactions of all column families may write together
+    // (0 = unlimited); takes effect immediately
+    void setFlushRateLimit(uint64_t bytesPerSecond);
+    void setCompactionRateLimit(uint64_t bytesPerSecond);
+
+    // Bloom filter parameters (applied to SSTs written after the call)
+    void setBloomFilterBitsPerKey(double bitsPerKey);
+    void setMonkeyFilterAllocation(bool enabled);
+    void setFilterType(SSTFilterType type);
+    // Capped prefix length for prefix Bloom filters (0 disables them)
+    void setPrefixExtractor(size_t prefixLength);
+    void printFilterStats() const;
+
+    // Print the busy time and utilization of the compaction read, merge and write stages
+    void printCompactionStats() const;
+
 private:
+    int memtable_size; // declared before lsmTree, which is constructed from it
     std::unique_ptr<LSMTree> lsmTree;
 
-    int memtable_size;
     std::filesystem::path path; // Path for storing SSTs
     bool is_open = false;
 
@@ -70,8 +206,47 @@ private:
         }
     }
     // Buffer pool parameters
-    size_t bufferPoolCapacity;
-    EvictionPolicy bufferPoolPolicy;
+    size_t bufferPoolCapacity = 1000;
+    EvictionPolicy bufferPoolPolicy = EvictionPolicy::LRU;
+
+    // Column families besides the default one (lsmTree), by id, and the state they share
+    // with it (nullptr until the database has any). Families are only added while open.
+    std::map<uint32_t, std::unique_ptr<LSMTree>> columnFamilies;
+    std::map<std::string, ColumnFamilyOptions> columnFamilyOptions;
+    std::shared_ptr<ColumnFamilyShared> shared;
+    mutable std::shared_mutex columnFamiliesMutex;
+
+    // Reclaiming the shared WAL
+    uint64_t maxWALSize = DEFAULT_MAX_WAL_SIZE;
+    std::mutex walReclaimMutex;
+
+    // Background thread compacting expired pairs of every family
+    std::unique_ptr<PeriodicTask> periodicCompaction;
+
+    // Ids and names of the column families, in db_path/column_families
+    static constexpr const char* COLUMN_FAMILIES_FILE = "column_families";
+    void writeColumnFamilies() const;
+    std::vector<ColumnFamilyHandle> readColumnFamilies() const;
+    std::filesystem::path columnFamilyPath(uint32_t id) const { return path / ("cf_" + std::to_string(id)); }
+
+    // Open the registered families and replay their writes from the shared WAL
+    void openColumnFamilies();
+    // A family configured with its options and, for everything else, the database's settings
+    // as the default family holds them
+    std::unique_ptr<LSMTree> makeColumnFamily(const ColumnFamilyHandle& handle);
+    // Apply a database setting to the default family and every other one, given their options
+    void forEachColumnFamily(const std::function<void(LSMTree&, const ColumnFamilyOptions&)>& apply);
+    // Start sharing the default family's WAL and sequence numbers, and a block cache
+    // (caller holds columnFamiliesMutex exclusively)
+    void shareDefaultColumnFamily();
+
+    // Tree of a family; throws for unknown ones
+    LSMTree& columnFamilyTree(uint32_t id) const;
+    LSMTree& columnFamilyTree(const ColumnFamilyHandle& handle) const { return columnFamilyTree(handle.getId()); }
+
+    // Roll the shared WAL and flush every family once it exceeds maxWALSize
+    void reclaimWALIfFull();
+    void compactExpiredColumnFamilies();
 };
 
 #include "VeloxDB.tpp"
@@ -11,6 +11,18 @@ void VeloxDB::Put(K key, V value) {
     // Create a KeyValueWrapper instance and insert it into the lsmTree
     KeyValueWrapper kvWrapper(key, value);
     lsmTree->put(kvWrapper);
+    reclaimWALIfFull();
+}
+
+// Put with a time to live: the pair expires ttlSeconds from now
+template<typename K, typename V>
+void VeloxDB::Put(K key, V value, uint64_t ttlSeconds) {
+    check_if_open();
+
+    KeyValueWrapper kvWrapper(key, value);
+    kvWrapper.setTTL(ttlSeconds);
+    lsmTree->put(kvWrapper);
+    reclaimWALIfFull();
 }
 
 // Overloaded Get method to simplify retrieval by passing a key directly
@@ -22,14 +34,32 @@ KeyValueWrapper VeloxDB::Get(K key) {
     return Get(kvWrapper);
 }
 
+template<typename K>
+KeyValueWrapper VeloxDB::Get(K key, const std::shared_ptr<const Snapshot>& snapshot) {
+    KeyValueWrapper kvWrapper(key, "");
+    return Get(kvWrapper, snapshot);
+}
+
+// Overloaded MultiGet method to simplify retrieval by passing keys directly
+template<typename K>
+std::vector<KeyValueWrapper> VeloxDB::MultiGet(const std::vector<K>& keys) {
+    check_if_open();
+    std::vector<KeyValueWrapper> kvWrappers;
+    kvWrappers.reserve(keys.size());
+    for (const auto& key : keys) {
+        kvWrappers.emplace_back(key, "");
+    }
+    return MultiGet(kvWrappers);
+}
+
 // Overloaded Scan method to simplify scanning by passing two keys directly
 template<typename K1, typename K2>
-std::vector<KeyValueWrapper> VeloxDB::Scan(K1 small_key, K2 large_key) {
+std::vector<KeyValueWrapper> VeloxDB::Scan(K1 small_key, K2 large_key, const ScanOptions& options) {
     check_if_open();
     // Convert the keys to KeyValueWrapper and call the existing Scan method
     KeyValueWrapper kvSmallKey(small_key, "");
     KeyValueWrapper kvLargeKey(large_key, "");
-    return Scan(kvSmallKey, kvLargeKey);
+    return Scan(kvSmallKey, kvLargeKey, options);
 }
 
 // Overloaded Delete method to simplify retrieval by passing a key directly
@@ -41,6 +71,18 @@ void VeloxDB::Delete(K key) {
     return Delete(kvWrapper);
 }
 
+// Overloaded DeleteRange method taking the bounds directly
+template<typename K1, typename K2>
+void VeloxDB::DeleteRange(K1 start_key, K2 end_key) {
+    DeleteRange(KeyValueWrapper(start_key, ""), KeyValueWrapper(end_key, ""));
+}
+
+// Overloaded Merge method taking the key and operand directly
+template<typename K, typename V>
+void VeloxDB::Merge(K key, V value) {
+    Merge(KeyValueWrapper(key, value));
+}
+
 // Overloaded Update method to simplify retrieval by passing a key directly
 template<typename K, typename V>
 int VeloxDB::Update(K key, V value) {
@@ -48,4 +90,39 @@ int VeloxDB::Update(K key, V value) {
     // Convert the key to a KeyValueWrapper and call the existing Get method
     KeyValueWrapper kvWrapper(key, value);
     return Update(kvWrapper);
+}
+
+// Column family overloads
+template<typename K, typename V>
+void VeloxDB::Put(const ColumnFamilyHandle& columnFamily, K key, V value) {
+    check_if_open();
+    columnFamilyTree(columnFamily).put(KeyValueWrapper(key, value));
+    reclaimWALIfFull();
+}
+
+template<typename K>
+KeyValueWrapper VeloxDB::Get(const ColumnFamilyHandle& columnFamily, K key) {
+    return Get(columnFamily, KeyValueWrapper(key, ""));
+}
+
+template<typename K>
+void VeloxDB::Delete(const ColumnFamilyHandle& columnFamily, K key) {
+    check_if_open();
+    KeyValueWrapper kvWrapper(key, "");
+    kvWrapper.setTombstone(true);
+    columnFamilyTree(columnFamily).put(kvWrapper);
+    reclaimWALIfFull();
+}
+
+template<typename K, typename V>
+void VeloxDB::Merge(const ColumnFamilyHandle& columnFamily, K key, V value) {
+    check_if_open();
+    columnFamilyTree(columnFamily).merge(KeyValueWrapper(key, value));
+    reclaimWALIfFull();
+}
+
+template<typename K1, typename K2>
+std::vector<KeyValueWrapper> VeloxDB::Scan(const ColumnFamilyHandle& columnFamily, K1 small_key, K2 large_key,
+                                           const ScanOptions& options) {
+    return Scan(columnFamily, KeyValueWrapper(small_key, ""), KeyValueWrapper(large_key, ""), options);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+//
+// ColumnFamily.h
+//
+
+#ifndef COLUMN_FAMILY_H
+#define COLUMN_FAMILY_H
+
+#include <string>
+#include <cstdint>
+
+// Names a column family of a VeloxDB: a separate keyspace with its own memtable,
+// levels and options, sharing the WAL, block cache and background thread of the
+// database. Handles come from VeloxDB::CreateColumnFamily / GetColumnFamily; the
+// default family (id 0) holds everything written without one.
+class ColumnFamilyHandle {
+public:
+    static constexpr uint32_t DEFAULT_ID = 0;
+    static constexpr const char* DEFAULT_NAME = "default";
+
+    ColumnFamilyHandle() = default;
+    explicit ColumnFamilyHandle(uint32_t id, std::string name) : id(id), name(std::move(name)) {}
+
+    uint32_t getId() const { return id; }
+    const std::string& getName() const { return name; }
+
+private:
+    uint32_t id = DEFAULT_ID;
+    std::string name = DEFAULT_NAME;
+};
+
+#endif // COLUMN_FAMILY_H
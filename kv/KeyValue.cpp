@@ -246,14 +246,71 @@ std::string KeyValueWrapper::keyValueTypeToString(KeyValue::KeyValueType type) c
 }
 
 size_t KeyValueWrapper::getSerializedSize() const {
-    // sizeof kv pair + sequence number (uint64_t) + tombstone (uint8_t)
-    return sizeof(kv.key_case()) + sizeof(kv.value_case()) + sizeof(kv.key_type()) + sizeof(kv.value_type()) + sizeof(size_t) + sizeof(uint64_t);
+    // sequence number (uint64_t) + flags (uint8_t) + [expiry (uint64_t)] + kv size (uint32_t) + serialized kv pair
+    return sizeof(uint64_t) + sizeof(uint8_t) + (expiresAt != 0 ? sizeof(uint64_t) : 0) + sizeof(uint32_t)
+           + kv.ByteSizeLong();
 }
 
-// Sequence number
-void KeyValueWrapper::generateSequenceNumber() {
+std::string KeyValueWrapper::getKeyString() const {
+    switch (kv.key_case()) {
+        case KeyValue::kIntKey:
+            return std::to_string(kv.int_key());
+        case KeyValue::kLongKey:
+            return std::to_string(kv.long_key());
+        case KeyValue::kDoubleKey:
+            return std::to_string(kv.double_key());
+        case KeyValue::kStringKey:
+            return kv.string_key();
+        case KeyValue::kCharKey:
+            return kv.char_key();
+        default:
+            // Empty key
+            return "";
+    }
+}
+
+KeyValueField KeyValueWrapper::getKey() const {
+    switch (kv.key_case()) {
+        case KeyValue::kIntKey:
+            return kv.int_key();
+        case KeyValue::kLongKey:
+            return static_cast<long long>(kv.long_key());
+        case KeyValue::kDoubleKey:
+            return kv.double_key();
+        case KeyValue::kStringKey:
+            return kv.string_key();
+        case KeyValue::kCharKey:
+            return kv.char_key().empty() ? '\0' : kv.char_key()[0];
+        default:
+            return std::monostate();
+    }
+}
+
+KeyValueField KeyValueWrapper::getValue() const {
+    switch (kv.value_case()) {
+        case KeyValue::kIntValue:
+            return kv.int_value();
+        case KeyValue::kLongValue:
+            return static_cast<long long>(kv.long_value());
+        case KeyValue::kDoubleValue:
+            return kv.double_value();
+        case KeyValue::kStringValue:
+            return kv.string_value();
+        case KeyValue::kCharValue:
+            return kv.char_value().empty() ? '\0' : kv.char_value()[0];
+        default:
+            return std::monostate();
+    }
+}
+
+// Time to live
+void KeyValueWrapper::setTTL(uint64_t ttlSeconds) {
+    expiresAt = currentTimeMillis() + ttlSeconds * 1000;
+}
+
+uint64_t KeyValueWrapper::currentTimeMillis() {
     using namespace std::chrono;
-    sequenceNumber = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
 // Tombstone API
@@ -9,9 +9,13 @@
 #include <stdexcept>
 #include <string>
 #include <chrono> // For time functions
+#include <variant>
 
 using namespace std;
 
+// A key or a value as the type it was written with (std::monostate if it is unset)
+using KeyValueField = std::variant<std::monostate, int, long long, double, std::string, char>;
+
 class KeyValueWrapper {
 public:
    // Default constructor
@@ -52,12 +56,18 @@ public:
    // Protobuf-generated KeyValue object
    KeyValue kv;
 
-   // Sequence number for versioning
+   // Sequence number for versioning, assigned by the tree when the write is applied (0 = not written yet)
    uint64_t sequenceNumber = 0;
 
    // Tombstone flag for deletion
    bool tombstone = false;
 
+   // The value is an operand for the merge operator, not the key's full value
+   bool mergeOperand = false;
+
+   // Expiry time in milliseconds since the Unix epoch (0 = never expires)
+   uint64_t expiresAt = 0;
+
    bool isDefault() const {
        // Check if the key is unset
        return kv.key_case() == KeyValue::KEY_NOT_SET && kv.value_case() == KeyValue::VALUE_NOT_SET;
@@ -65,15 +75,29 @@ public:
 
    size_t getSerializedSize() const;
 
+   // The key and the value, each as the type it was written with
+   KeyValueField getKey() const;
+   KeyValueField getValue() const;
+
+   // Key rendered as a string, used for hashing by the SST filters
+   std::string getKeyString() const;
+
    // Methods to set and get tombstone
    void setTombstone(bool isTombstone);
    void markAsTombstone();
    bool isTombstone() const;
 
-private:
-   // Helper to generate sequence number
-   void generateSequenceNumber();
+   // Methods to set and get the merge operand flag
+   void setMergeOperand(bool isMergeOperand) { mergeOperand = isMergeOperand; }
+   bool isMergeOperand() const { return mergeOperand; }
 
+   // Time to live: expire ttlSeconds from now
+   void setTTL(uint64_t ttlSeconds);
+   bool isExpired(uint64_t nowMillis) const { return expiresAt != 0 && expiresAt <= nowMillis; }
+   // Clock used for expiry times
+   static uint64_t currentTimeMillis();
+
+private:
    // Helper to deduce and set the key type in Protobuf
    template<typename T>
    void setKey(T key);
@@ -0,0 +1,83 @@
+//
+// MergeOperator.cpp
+//
+
+#include "MergeOperator.h"
+#include <stdexcept>
+
+KeyValueWrapper MergeOperator::fold(const KeyValueWrapper* base, const std::vector<KeyValueWrapper>& operands,
+                                    bool partial, size_t* numRejected) const {
+    if (operands.empty()) {
+        throw std::invalid_argument("MergeOperator::fold() No operands to apply");
+    }
+    // Oldest operand first
+    KeyValueWrapper value;
+    const KeyValueWrapper* existing = base;
+    for (auto it = operands.rbegin(); it != operands.rend(); ++it) {
+        try {
+            value = merge(existing, *it);
+        } catch (const std::invalid_argument&) {
+            if (numRejected == nullptr) {
+                throw;
+            }
+            ++*numRejected;
+            continue;
+        }
+        existing = &value;
+    }
+
+    KeyValueWrapper result(operands.front());
+    if (existing == nullptr) {
+        if (!partial) {
+            result.kv.clear_value();
+            result.setTombstone(true);
+            result.setMergeOperand(false);
+        }
+        return result;
+    }
+    result.kv.clear_value();
+    result.kv.MergeFrom(existing->kv);
+    result.kv.set_value_type(existing->kv.value_type());
+    result.setTombstone(false);
+    result.setMergeOperand(partial);
+    return result;
+}
+
+namespace {
+int64_t integerValue(const KeyValueWrapper& kv) {
+    switch (kv.kv.value_case()) {
+        case KeyValue::kIntValue:
+            return kv.kv.int_value();
+        case KeyValue::kLongValue:
+            return kv.kv.long_value();
+        default:
+            throw std::invalid_argument("Int64AddOperator: value is not an integer");
+    }
+}
+
+std::string stringValue(const KeyValueWrapper& kv) {
+    switch (kv.kv.value_case()) {
+        case KeyValue::kStringValue:
+            return kv.kv.string_value();
+        case KeyValue::kCharValue:
+            return kv.kv.char_value();
+        default:
+            throw std::invalid_argument("StringAppendOperator: value is not a string");
+    }
+}
+}
+
+KeyValueWrapper Int64AddOperator::merge(const KeyValueWrapper* existing, const KeyValueWrapper& operand) const {
+    KeyValueWrapper result;
+    result.kv.set_long_value((existing ? integerValue(*existing) : 0) + integerValue(operand));
+    result.kv.set_value_type(KeyValue::LONG);
+    return result;
+}
+
+KeyValueWrapper StringAppendOperator::merge(const KeyValueWrapper* existing, const KeyValueWrapper& operand) const {
+    KeyValueWrapper result;
+    result.kv.set_string_value(existing ? stringValue(*existing) + delimiter + stringValue(operand)
+                                        : stringValue(operand));
+    result.kv.set_value_type(KeyValue::STRING);
+    return result;
+}
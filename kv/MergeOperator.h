@@ -0,0 +1,54 @@
+//
+// MergeOperator.h
+//
+
+#ifndef MERGE_OPERATOR_H
+#define MERGE_OPERATOR_H
+
+#include "KeyValue.h"
+#include <string>
+#include <vector>
+
+// Combines the operands written with Merge into a value without reading the old one
+// first. The operator must be associative: operands are folded whenever two versions of
+// a key meet (in the memtable, during compaction, on reads), in whatever grouping.
+class MergeOperator {
+public:
+    virtual ~MergeOperator() = default;
+
+    virtual std::string name() const = 0;
+
+    // Value of the key after applying operand to existing (nullptr = the key has no value).
+    // Only the value fields of the result are used. Throws std::invalid_argument for an
+    // operand or existing value it cannot combine.
+    virtual KeyValueWrapper merge(const KeyValueWrapper* existing, const KeyValueWrapper& operand) const = 0;
+
+    // Apply operands (newest first) to base (nullptr = no value). The result carries the
+    // newest operand's key and sequence number; with partial it stays a merge operand,
+    // for when older versions of the key may still lie below. With numRejected, operands
+    // merge() rejects are skipped and counted instead of thrown; if none applies, the result
+    // is the base, or without one a deletion (the newest operand itself when partial).
+    KeyValueWrapper fold(const KeyValueWrapper* base, const std::vector<KeyValueWrapper>& operands,
+                         bool partial = false, size_t* numRejected = nullptr) const;
+};
+
+// Adds integer operands as int64; the result is a long value
+class Int64AddOperator : public MergeOperator {
+public:
+    std::string name() const override { return "Int64AddOperator"; }
+    KeyValueWrapper merge(const KeyValueWrapper* existing, const KeyValueWrapper& operand) const override;
+};
+
+// Appends string operands, separated by delimiter
+class StringAppendOperator : public MergeOperator {
+public:
+    explicit StringAppendOperator(std::string delimiter = ",") : delimiter(std::move(delimiter)) {}
+
+    std::string name() const override { return "StringAppendOperator"; }
+    KeyValueWrapper merge(const KeyValueWrapper* existing, const KeyValueWrapper& operand) const override;
+
+private:
+    std::string delimiter;
+};
+
+#endif // MERGE_OPERATOR_H
@@ -0,0 +1,25 @@
+//
+// PrefixExtractor.cpp
+//
+
+#include "PrefixExtractor.h"
+
+PrefixExtractor::PrefixExtractor(size_t length) : length(length) {}
+
+bool PrefixExtractor::inDomain(const KeyValueWrapper& kv) const {
+    return isEnabled() && kv.kv.key_case() == KeyValue::kStringKey;
+}
+
+std::string PrefixExtractor::transform(const KeyValueWrapper& kv) const {
+    return transform(kv.kv.string_key());
+}
+
+std::string PrefixExtractor::transform(const std::string& key) const {
+    return key.substr(0, length);
+}
+
+// Every key starting with `prefix` maps to transform(prefix) only when the
+// query prefix is at least as long as the extracted prefix
+bool PrefixExtractor::canFilter(const std::string& prefix) const {
+    return isEnabled() && prefix.size() >= length;
+}
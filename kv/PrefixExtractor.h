@@ -0,0 +1,37 @@
+//
+// PrefixExtractor.h
+//
+
+#ifndef PREFIX_EXTRACTOR_H
+#define PREFIX_EXTRACTOR_H
+
+#include "KeyValue.h"
+#include <string>
+#include <cstddef>
+
+// Capped fixed-length prefix extractor: the prefix of a string key is its first
+// `length` bytes, or the whole key if it is shorter. Only string keys are in the
+// domain; numeric and char keys have no prefix.
+class PrefixExtractor {
+public:
+    // length 0 disables prefix extraction
+    explicit PrefixExtractor(size_t length = 0);
+
+    bool isEnabled() const { return length > 0; }
+    size_t getLength() const { return length; }
+
+    // Whether the key has a prefix under this extractor
+    bool inDomain(const KeyValueWrapper& kv) const;
+
+    // Prefix of a key in the domain
+    std::string transform(const KeyValueWrapper& kv) const;
+    std::string transform(const std::string& key) const;
+
+    // Whether a filter on extracted prefixes can answer a ScanPrefix(prefix) query
+    bool canFilter(const std::string& prefix) const;
+
+private:
+    size_t length;
+};
+
+#endif // PREFIX_EXTRACTOR_H
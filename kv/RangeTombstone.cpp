@@ -0,0 +1,173 @@
+//
+// RangeTombstone.cpp
+//
+
+#include "RangeTombstone.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+RangeTombstoneList::RangeTombstoneList(const RangeTombstoneList& other) {
+    *this = other;
+}
+
+RangeTombstoneList::RangeTombstoneList(RangeTombstoneList&& other) noexcept {
+    *this = std::move(other);
+}
+
+RangeTombstoneList& RangeTombstoneList::operator=(const RangeTombstoneList& other) {
+    if (this != &other) {
+        std::lock_guard<std::mutex> lock(other.fragmentsMutex);
+        tombstones = other.tombstones;
+        fragmentStarts = other.fragmentStarts;
+        fragmentSequences = other.fragmentSequences;
+        fragmentsBuilt = other.fragmentsBuilt.load();
+    }
+    return *this;
+}
+
+RangeTombstoneList& RangeTombstoneList::operator=(RangeTombstoneList&& other) noexcept {
+    if (this != &other) {
+        tombstones = std::move(other.tombstones);
+        fragmentStarts = std::move(other.fragmentStarts);
+        fragmentSequences = std::move(other.fragmentSequences);
+        fragmentsBuilt = other.fragmentsBuilt.load();
+    }
+    return *this;
+}
+
+void RangeTombstoneList::add(const RangeTombstone& tombstone) {
+    if (!(tombstone.start < tombstone.end)) {
+        return;
+    }
+    tombstones.push_back(tombstone);
+    fragmentsBuilt = false;
+}
+
+void RangeTombstoneList::add(const RangeTombstoneList& other) {
+    if (other.empty()) {
+        return;
+    }
+    tombstones.insert(tombstones.end(), other.tombstones.begin(), other.tombstones.end());
+    fragmentsBuilt = false;
+}
+
+uint64_t RangeTombstoneList::maxCoveringSequence(const KeyValueWrapper& key) const {
+    if (tombstones.empty()) {
+        return 0;
+    }
+    ensureFragments();
+    auto it = std::upper_bound(fragmentStarts.begin(), fragmentStarts.end(), key);
+    if (it == fragmentStarts.begin()) {
+        return 0;
+    }
+    return fragmentSequences[it - fragmentStarts.begin() - 1];
+}
+
+void RangeTombstoneList::ensureFragments() const {
+    if (fragmentsBuilt.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(fragmentsMutex);
+    if (!fragmentsBuilt.load(std::memory_order_relaxed)) {
+        buildFragments();
+        fragmentsBuilt.store(true, std::memory_order_release);
+    }
+}
+
+// Sweep the start and end keys in order, keeping the sequence numbers of the
+// tombstones open at each point
+void RangeTombstoneList::buildFragments() const {
+    struct Event {
+        const KeyValueWrapper* key;
+        bool isStart;
+        uint64_t sequenceNumber;
+    };
+    std::vector<Event> events;
+    events.reserve(tombstones.size() * 2);
+    for (const auto& tombstone : tombstones) {
+        events.push_back({&tombstone.start, true, tombstone.sequenceNumber});
+        events.push_back({&tombstone.end, false, tombstone.sequenceNumber});
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return *a.key < *b.key; });
+
+    fragmentStarts.clear();
+    fragmentSequences.clear();
+    std::multiset<uint64_t> open;
+    for (size_t i = 0; i < events.size();) {
+        const KeyValueWrapper& key = *events[i].key;
+        for (; i < events.size() && *events[i].key == key; ++i) {
+            if (events[i].isStart) {
+                open.insert(events[i].sequenceNumber);
+            } else {
+                open.erase(open.find(events[i].sequenceNumber));
+            }
+        }
+        uint64_t sequenceNumber = open.empty() ? 0 : *open.rbegin();
+        if (!fragmentSequences.empty() && fragmentSequences.back() == sequenceNumber) {
+            continue; // same coverage as the fragment before, extend it
+        }
+        fragmentStarts.push_back(key);
+        fragmentSequences.push_back(sequenceNumber);
+    }
+}
+
+std::vector<char> RangeTombstoneList::serialize() const {
+    std::vector<char> data;
+    auto append = [&data](const void* bytes, size_t size) {
+        data.insert(data.end(), static_cast<const char*>(bytes), static_cast<const char*>(bytes) + size);
+    };
+    auto appendKey = [&append](const KeyValueWrapper& key) {
+        std::string payload;
+        if (!key.kv.SerializeToString(&payload)) {
+            throw std::runtime_error("RangeTombstoneList::serialize() Failed to serialize key");
+        }
+        uint32_t length = static_cast<uint32_t>(payload.size());
+        append(&length, sizeof(length));
+        append(payload.data(), payload.size());
+    };
+
+    uint32_t count = static_cast<uint32_t>(tombstones.size());
+    append(&count, sizeof(count));
+    for (const auto& tombstone : tombstones) {
+        append(&tombstone.sequenceNumber, sizeof(tombstone.sequenceNumber));
+        appendKey(tombstone.start);
+        appendKey(tombstone.end);
+    }
+    return data;
+}
+
+RangeTombstoneList RangeTombstoneList::deserialize(const std::vector<char>& data) {
+    size_t offset = 0;
+    auto read = [&data, &offset](void* bytes, size_t size) {
+        if (offset + size > data.size()) {
+            throw std::runtime_error("RangeTombstoneList::deserialize() Truncated range tombstones");
+        }
+        std::memcpy(bytes, data.data() + offset, size);
+        offset += size;
+    };
+    auto readKey = [&read, &data, &offset]() {
+        uint32_t length;
+        read(&length, sizeof(length));
+        KeyValue proto;
+        if (offset + length > data.size() || !proto.ParseFromArray(data.data() + offset, static_cast<int>(length))) {
+            throw std::runtime_error("RangeTombstoneList::deserialize() Failed to parse key");
+        }
+        offset += length;
+        return KeyValueWrapper(proto);
+    };
+
+    RangeTombstoneList list;
+    uint32_t count;
+    read(&count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+        RangeTombstone tombstone;
+        read(&tombstone.sequenceNumber, sizeof(tombstone.sequenceNumber));
+        tombstone.start = readKey();
+        tombstone.end = readKey();
+        list.tombstones.push_back(std::move(tombstone));
+    }
+    list.fragmentsBuilt = count == 0;
+    return list;
+}
@@ -0,0 +1,72 @@
+//
+// RangeTombstone.h
+//
+
+#ifndef RANGE_TOMBSTONE_H
+#define RANGE_TOMBSTONE_H
+
+#include "KeyValue.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Deletes every key in [start, end) written before sequenceNumber
+struct RangeTombstone {
+    KeyValueWrapper start;
+    KeyValueWrapper end;
+    uint64_t sequenceNumber = 0;
+};
+
+// The range tombstones of a memtable or SST. Lookups go through a fragmented view:
+// the tombstones are cut at every start and end key into disjoint fragments, each
+// holding the highest sequence number covering it, so a key is checked with one
+// binary search however many tombstones overlap. The fragments are built on the first
+// lookup after tombstones were added, so adding N tombstones costs one build, not N;
+// concurrent lookups on a list that is not being added to are safe.
+//
+// Serialized as
+//
+//   uint32 count | count x (uint64 sequence number | uint32 length | start KeyValue
+//                           | uint32 length | end KeyValue)
+class RangeTombstoneList {
+public:
+    RangeTombstoneList() = default;
+    RangeTombstoneList(const RangeTombstoneList& other);
+    RangeTombstoneList(RangeTombstoneList&& other) noexcept;
+    RangeTombstoneList& operator=(const RangeTombstoneList& other);
+    RangeTombstoneList& operator=(RangeTombstoneList&& other) noexcept;
+
+    // Empty ranges (start >= end) are ignored
+    void add(const RangeTombstone& tombstone);
+    void add(const RangeTombstoneList& other);
+
+    bool empty() const { return tombstones.empty(); }
+    size_t size() const { return tombstones.size(); }
+    const std::vector<RangeTombstone>& getTombstones() const { return tombstones; }
+
+    // Highest sequence number of a tombstone covering key (0 if none does)
+    uint64_t maxCoveringSequence(const KeyValueWrapper& key) const;
+
+    // Whether kv is deleted by a tombstone written after it
+    bool covers(const KeyValueWrapper& kv) const { return maxCoveringSequence(kv) > kv.sequenceNumber; }
+
+    std::vector<char> serialize() const;
+    static RangeTombstoneList deserialize(const std::vector<char>& data);
+
+private:
+    std::vector<RangeTombstone> tombstones;
+
+    // Fragment i spans [fragmentStarts[i], fragmentStarts[i + 1]) and is covered up to
+    // fragmentSequences[i] (0 = not covered; the last fragment is open-ended and uncovered).
+    // Valid once fragmentsBuilt is set; built under fragmentsMutex.
+    mutable std::vector<KeyValueWrapper> fragmentStarts;
+    mutable std::vector<uint64_t> fragmentSequences;
+    mutable std::atomic<bool> fragmentsBuilt{true};
+    mutable std::mutex fragmentsMutex;
+
+    void ensureFragments() const;
+    void buildFragments() const;
+};
+
+#endif // RANGE_TOMBSTONE_H
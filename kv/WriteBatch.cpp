@@ -0,0 +1,247 @@
+//
+// WriteBatch.cpp
+//
+
+#include "WriteBatch.h"
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+WriteBatch::WriteBatch() {
+    Clear();
+}
+
+void WriteBatch::Put(const KeyValueWrapper& kv) {
+    addRecord(PUT, kv, ColumnFamilyHandle::DEFAULT_ID);
+}
+
+void WriteBatch::Delete(const KeyValueWrapper& kv) {
+    addRecord(DELETE, kv, ColumnFamilyHandle::DEFAULT_ID);
+}
+
+void WriteBatch::Merge(const KeyValueWrapper& kv) {
+    addRecord(MERGE, kv, ColumnFamilyHandle::DEFAULT_ID);
+}
+
+void WriteBatch::DeleteRange(const KeyValueWrapper& start, const KeyValueWrapper& end) {
+    DeleteRange(ColumnFamilyHandle(), start, end);
+}
+
+void WriteBatch::Put(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv) {
+    addRecord(PUT, kv, columnFamily.getId());
+}
+
+void WriteBatch::Delete(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv) {
+    addRecord(DELETE, kv, columnFamily.getId());
+}
+
+void WriteBatch::Merge(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv) {
+    addRecord(MERGE, kv, columnFamily.getId());
+}
+
+void WriteBatch::DeleteRange(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& start,
+                             const KeyValueWrapper& end) {
+    std::string startPayload, endPayload;
+    if (!start.kv.SerializeToString(&startPayload) || !end.kv.SerializeToString(&endPayload)) {
+        throw std::runtime_error("WriteBatch::DeleteRange() Failed to serialize range keys");
+    }
+    uint32_t startLength = static_cast<uint32_t>(startPayload.size());
+    std::string payload(reinterpret_cast<const char*>(&startLength), sizeof(startLength));
+    payload.append(startPayload);
+    payload.append(endPayload);
+    appendRecord(DELETE_RANGE, 0, columnFamily.getId(), payload);
+}
+
+uint32_t WriteBatch::Count() const {
+    uint32_t count;
+    std::memcpy(&count, rep.data() + sizeof(uint64_t), sizeof(count));
+    return count;
+}
+
+std::vector<uint32_t> WriteBatch::ColumnFamilyIds() const {
+    std::set<uint32_t> ids;
+    Record record;
+    size_t offset = HEADER_SIZE;
+    for (uint32_t i = 0; i < Count(); ++i) {
+        offset = readRecord(offset, record);
+        ids.insert(record.columnFamilyId);
+    }
+    return {ids.begin(), ids.end()};
+}
+
+bool WriteBatch::HasMerge(uint32_t columnFamilyId) const {
+    // Only the record headers are read
+    Record record;
+    size_t offset = HEADER_SIZE;
+    for (uint32_t i = 0; i < Count(); ++i) {
+        offset = readRecord(offset, record);
+        if (record.type == MERGE && record.columnFamilyId == columnFamilyId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WriteBatch::SetDefaultExpiry(uint64_t expiresAt, uint32_t columnFamilyId) {
+    if (expiresAt == 0) {
+        return;
+    }
+    WriteBatch updated;
+    updated.setSequence(getSequence());
+    Record record;
+    size_t offset = HEADER_SIZE;
+    for (uint32_t i = 0; i < Count(); ++i) {
+        offset = readRecord(offset, record);
+        if ((record.type == PUT || record.type == MERGE) && record.expiresAt == 0
+            && record.columnFamilyId == columnFamilyId) {
+            record.expiresAt = expiresAt;
+        }
+        updated.appendRecord(record.type, record.expiresAt, record.columnFamilyId,
+                             rep.substr(record.payloadOffset, record.payloadLength));
+    }
+    rep.swap(updated.rep);
+}
+
+void WriteBatch::Clear() {
+    rep.assign(HEADER_SIZE, '\0');
+}
+
+uint64_t WriteBatch::getSequence() const {
+    uint64_t sequence;
+    std::memcpy(&sequence, rep.data(), sizeof(sequence));
+    return sequence;
+}
+
+void WriteBatch::setSequence(uint64_t sequence) {
+    std::memcpy(&rep[0], &sequence, sizeof(sequence));
+}
+
+size_t WriteBatch::readRecord(size_t offset, Record& record) const {
+    if (offset + 1 + sizeof(uint32_t) > rep.size()) {
+        throw std::runtime_error("WriteBatch::readRecord() Truncated record header");
+    }
+    auto typeByte = static_cast<uint8_t>(rep[offset]);
+    uint32_t length;
+    std::memcpy(&length, rep.data() + offset + 1, sizeof(length));
+    offset += 1 + sizeof(length);
+    if (offset + length > rep.size()) {
+        throw std::runtime_error("WriteBatch::readRecord() Truncated record");
+    }
+    size_t next = offset + length;
+
+    record.type = static_cast<RecordType>(typeByte & ~(EXPIRES | COLUMN_FAMILY));
+    record.expiresAt = 0;
+    record.columnFamilyId = ColumnFamilyHandle::DEFAULT_ID;
+    if (typeByte & EXPIRES) {
+        if (length < sizeof(record.expiresAt)) {
+            throw std::runtime_error("WriteBatch::readRecord() Truncated expiry time");
+        }
+        std::memcpy(&record.expiresAt, rep.data() + offset, sizeof(record.expiresAt));
+        offset += sizeof(record.expiresAt);
+        length -= sizeof(record.expiresAt);
+    }
+    if (typeByte & COLUMN_FAMILY) {
+        if (length < sizeof(record.columnFamilyId)) {
+            throw std::runtime_error("WriteBatch::readRecord() Truncated column family id");
+        }
+        std::memcpy(&record.columnFamilyId, rep.data() + offset, sizeof(record.columnFamilyId));
+        offset += sizeof(record.columnFamilyId);
+        length -= sizeof(record.columnFamilyId);
+    }
+    record.payloadOffset = offset;
+    record.payloadLength = length;
+    return next;
+}
+
+void WriteBatch::appendRecord(RecordType type, uint64_t expiresAt, uint32_t columnFamilyId,
+                              const std::string& payload) {
+    uint8_t typeByte = type;
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    if (expiresAt != 0) {
+        typeByte |= EXPIRES;
+        length += sizeof(expiresAt);
+    }
+    if (columnFamilyId != ColumnFamilyHandle::DEFAULT_ID) {
+        typeByte |= COLUMN_FAMILY;
+        length += sizeof(columnFamilyId);
+    }
+
+    rep.push_back(static_cast<char>(typeByte));
+    rep.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    if (typeByte & EXPIRES) {
+        rep.append(reinterpret_cast<const char*>(&expiresAt), sizeof(expiresAt));
+    }
+    if (typeByte & COLUMN_FAMILY) {
+        rep.append(reinterpret_cast<const char*>(&columnFamilyId), sizeof(columnFamilyId));
+    }
+    rep.append(payload);
+
+    uint32_t count = Count() + 1;
+    std::memcpy(&rep[sizeof(uint64_t)], &count, sizeof(count));
+}
+
+void WriteBatch::addRecord(RecordType type, const KeyValueWrapper& kv, uint32_t columnFamilyId) {
+    std::string payload;
+    if (!kv.kv.SerializeToString(&payload)) {
+        throw std::runtime_error("WriteBatch::addRecord() Failed to serialize key-value pair");
+    }
+    appendRecord(type, type == DELETE ? 0 : kv.expiresAt, columnFamilyId, payload);
+}
+
+void WriteBatch::forEach(const std::function<void(KeyValueWrapper&)>& apply,
+                         const std::function<void(RangeTombstone&)>& applyRange, uint32_t columnFamilyId) const {
+    uint64_t sequence = getSequence();
+    Record record;
+    size_t offset = HEADER_SIZE;
+    for (uint32_t i = 0; i < Count(); ++i) {
+        offset = readRecord(offset, record);
+        if (record.columnFamilyId != columnFamilyId) {
+            continue;
+        }
+        const char* payload = rep.data() + record.payloadOffset;
+        uint32_t length = record.payloadLength;
+
+        if (record.type == DELETE_RANGE) {
+            if (!applyRange) {
+                throw std::runtime_error("WriteBatch::forEach() No handler for a DeleteRange record");
+            }
+            uint32_t startLength = 0;
+            if (length >= sizeof(startLength)) {
+                std::memcpy(&startLength, payload, sizeof(startLength));
+            }
+            const char* startData = payload + sizeof(startLength);
+            KeyValue startProto, endProto;
+            if (length < sizeof(startLength) || startLength > length - sizeof(startLength)
+                || !startProto.ParseFromArray(startData, static_cast<int>(startLength))
+                || !endProto.ParseFromArray(startData + startLength,
+                                            static_cast<int>(length - sizeof(startLength) - startLength))) {
+                throw std::runtime_error("WriteBatch::forEach() Failed to parse DeleteRange record");
+            }
+
+            RangeTombstone tombstone{KeyValueWrapper(startProto), KeyValueWrapper(endProto), sequence + i};
+            applyRange(tombstone);
+            continue;
+        }
+
+        KeyValue proto;
+        if (!proto.ParseFromArray(payload, static_cast<int>(length))) {
+            throw std::runtime_error("WriteBatch::forEach() Failed to parse record");
+        }
+
+        KeyValueWrapper kv(proto);
+        kv.sequenceNumber = sequence + i;
+        kv.setTombstone(record.type == DELETE);
+        kv.setMergeOperand(record.type == MERGE);
+        kv.expiresAt = record.expiresAt;
+        apply(kv);
+    }
+}
+
+WriteBatch WriteBatch::fromRep(std::string rep) {
+    if (rep.size() < HEADER_SIZE) {
+        throw std::runtime_error("WriteBatch::fromRep() Batch is smaller than its header");
+    }
+    WriteBatch batch;
+    batch.rep = std::move(rep);
+    return batch;
+}
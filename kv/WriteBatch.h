@@ -0,0 +1,144 @@
+//
+// WriteBatch.h
+//
+
+#ifndef WRITE_BATCH_H
+#define WRITE_BATCH_H
+
+#include "KeyValue.h"
+#include "RangeTombstone.h"
+#include "ColumnFamily.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// A group of Put/Delete/DeleteRange/Merge records applied atomically by VeloxDB::Write.
+//
+// Records are encoded back to back in one contiguous buffer, which is also the
+// WAL payload, so the batch is logged with a single append:
+//
+//   header : uint64 first sequence number | uint32 record count
+//   record : uint8 type | uint32 length | serialized KeyValue
+//
+// A DeleteRange record holds both keys: uint32 start length | start KeyValue | end KeyValue.
+// A record of an entry with an expiry time has the EXPIRES bit set in its type and the
+// time (uint64 milliseconds since the Unix epoch) in front of the KeyValue. A record
+// of a column family other than the default one has the COLUMN_FAMILY bit set and the
+// uint32 family id after that (or in front of the KeyValue if there is no expiry).
+//
+// Record i gets sequence number (first sequence number + i), whatever its family.
+class WriteBatch {
+public:
+    enum RecordType : uint8_t { PUT = 0, DELETE = 1, DELETE_RANGE = 2, MERGE = 3 };
+    static constexpr uint8_t EXPIRES = 0x80;
+    static constexpr uint8_t COLUMN_FAMILY = 0x40;
+
+    static constexpr size_t HEADER_SIZE = sizeof(uint64_t) + sizeof(uint32_t);
+
+    WriteBatch();
+
+    template<typename K, typename V>
+    void Put(K key, V value);
+    template<typename K>
+    void Delete(K key);
+    template<typename K, typename V>
+    void Merge(K key, V operand);
+
+    void Put(const KeyValueWrapper& kv);
+    void Delete(const KeyValueWrapper& kv);
+    // Operand for the merge operator
+    void Merge(const KeyValueWrapper& kv);
+    // Delete every key in [start, end)
+    void DeleteRange(const KeyValueWrapper& start, const KeyValueWrapper& end);
+
+    // The same records for a column family
+    template<typename K, typename V>
+    void Put(const ColumnFamilyHandle& columnFamily, K key, V value);
+    template<typename K>
+    void Delete(const ColumnFamilyHandle& columnFamily, K key);
+    template<typename K, typename V>
+    void Merge(const ColumnFamilyHandle& columnFamily, K key, V operand);
+
+    void Put(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv);
+    void Delete(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv);
+    void Merge(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& kv);
+    void DeleteRange(const ColumnFamilyHandle& columnFamily, const KeyValueWrapper& start,
+                     const KeyValueWrapper& end);
+
+    // Number of records
+    uint32_t Count() const;
+    // Ids of the column families with records in the batch, ascending
+    std::vector<uint32_t> ColumnFamilyIds() const;
+    // Whether any record of the column family is a Merge
+    bool HasMerge(uint32_t columnFamilyId = ColumnFamilyHandle::DEFAULT_ID) const;
+    // Give the Put and Merge records of the column family without an expiry time this one
+    void SetDefaultExpiry(uint64_t expiresAt, uint32_t columnFamilyId = ColumnFamilyHandle::DEFAULT_ID);
+    void Clear();
+    // Size of the encoded batch in bytes
+    size_t ApproximateSize() const { return rep.size(); }
+
+    // Sequence number of the first record (assigned when the batch is written)
+    uint64_t getSequence() const;
+    void setSequence(uint64_t sequence);
+
+    // Decode each record of the column family with its sequence number, tombstone/merge operand flags and
+    // expiry set; DeleteRange records go to applyRange (an error if it is not given)
+    void forEach(const std::function<void(KeyValueWrapper&)>& apply,
+                 const std::function<void(RangeTombstone&)>& applyRange = nullptr,
+                 uint32_t columnFamilyId = ColumnFamilyHandle::DEFAULT_ID) const;
+
+    // Encoded batch, and a batch rebuilt from one (e.g. read back from the WAL)
+    const std::string& getRep() const { return rep; }
+    static WriteBatch fromRep(std::string rep);
+
+private:
+    std::string rep;
+
+    // Header of an encoded record
+    struct Record {
+        RecordType type;
+        uint64_t expiresAt = 0;
+        uint32_t columnFamilyId = ColumnFamilyHandle::DEFAULT_ID;
+        size_t payloadOffset;   // the KeyValue (or DeleteRange keys)
+        uint32_t payloadLength;
+    };
+
+    // Decode the header of the record at offset and return the offset of the next one
+    size_t readRecord(size_t offset, Record& record) const;
+    void appendRecord(RecordType type, uint64_t expiresAt, uint32_t columnFamilyId, const std::string& payload);
+    void addRecord(RecordType type, const KeyValueWrapper& kv, uint32_t columnFamilyId);
+};
+
+template<typename K, typename V>
+void WriteBatch::Put(K key, V value) {
+    Put(KeyValueWrapper(key, value));
+}
+
+template<typename K>
+void WriteBatch::Delete(K key) {
+    Delete(KeyValueWrapper(key, ""));
+}
+
+template<typename K, typename V>
+void WriteBatch::Merge(K key, V operand) {
+    Merge(KeyValueWrapper(key, operand));
+}
+
+template<typename K, typename V>
+void WriteBatch::Put(const ColumnFamilyHandle& columnFamily, K key, V value) {
+    Put(columnFamily, KeyValueWrapper(key, value));
+}
+
+template<typename K>
+void WriteBatch::Delete(const ColumnFamilyHandle& columnFamily, K key) {
+    Delete(columnFamily, KeyValueWrapper(key, ""));
+}
+
+template<typename K, typename V>
+void WriteBatch::Merge(const ColumnFamilyHandle& columnFamily, K key, V operand) {
+    Merge(columnFamily, KeyValueWrapper(key, operand));
+}
+
+#endif // WRITE_BATCH_H
@@ -7,6 +7,7 @@
 
 #include <gtest/gtest.h>
 #include "DiskBTree.h"
+#include "SSTBuilder.h"
 #include "KeyValue.h"
 #include <filesystem>
 #include <cstdlib>
@@ -416,6 +417,169 @@ TEST(DiskBTreeTest, ScanStringKeys) {
     cleanUp(sstFileName);
 }
 
+// Test the prefix Bloom filter is written after the tree and reloaded on open
+TEST(DiskBTreeTest, PrefixFilterRegion) {
+    std::string sstFileName = "test_sst_prefix_filter.sst";
+    cleanUp(sstFileName);
+
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 1000; ++i) {
+        std::string prefix = (i % 2 == 0) ? "acct" : "user";
+        keyValues.emplace_back(prefix + ":" + std::to_string(i), i);
+    }
+    std::sort(keyValues.begin(), keyValues.end());
+
+    SSTBuildOptions options;
+    options.prefixLength = 4;
+    {
+        DiskBTree btree(sstFileName, keyValues, 4096, options);
+        EXPECT_TRUE(btree.mayContainPrefix("acct"));
+        EXPECT_TRUE(btree.mayContainPrefix("user:12"));
+    }
+
+    DiskBTree reopened(sstFileName);
+    EXPECT_EQ(reopened.getPrefixLength(), 4);
+    EXPECT_TRUE(reopened.mayContainPrefix("acct"));
+    EXPECT_TRUE(reopened.mayContainPrefix("user:12"));
+    // Prefixes shorter than the extracted prefix cannot be filtered
+    EXPECT_TRUE(reopened.mayContainPrefix("zz"));
+
+    int rejected = 0;
+    for (int i = 0; i < 100; ++i) {
+        if (!reopened.mayContainPrefix("p" + std::to_string(100 + i))) {
+            rejected++;
+        }
+    }
+    EXPECT_GT(rejected, 90);
+
+    // Point lookups are unaffected
+    KeyValueWrapper* result = reopened.search(KeyValueWrapper("user:999", ""));
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->kv.int_value(), 999);
+    delete result;
+
+    cleanUp(sstFileName);
+}
+
+// Batched lookups match single searches and read each page at most once
+TEST(DiskBTreeTest, MultiSearch) {
+    std::string sstFileName = "test_sst_multi_search.sst";
+    cleanUp(sstFileName);
+
+    // Even keys only, so odd keys are misses
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 20000; i += 2) {
+        keyValues.emplace_back(i, i * 10);
+    }
+    DiskBTree btree(sstFileName, keyValues);
+
+    std::vector<KeyValueWrapper> keys;
+    for (int i = -10; i < 20010; i += 7) {
+        keys.emplace_back(i, 0);
+    }
+    std::vector<KeyValueWrapper> results;
+    long long readsBefore = btree.getPageReads();
+    btree.multiSearch(keys, results);
+    long long batchReads = btree.getPageReads() - readsBefore;
+    ASSERT_EQ(results.size(), keys.size());
+
+    readsBefore = btree.getPageReads();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        KeyValueWrapper* single = btree.search(keys[i]);
+        if (single == nullptr) {
+            EXPECT_TRUE(results[i].isEmpty()) << keys[i].kv.int_key();
+        } else {
+            ASSERT_FALSE(results[i].isEmpty()) << keys[i].kv.int_key();
+            EXPECT_EQ(results[i].kv.int_value(), single->kv.int_value());
+            delete single;
+        }
+    }
+    long long singleReads = btree.getPageReads() - readsBefore;
+
+    // Every page holds many of the keys, so the shared descent reads far fewer pages
+    size_t numPages = fs::file_size(sstFileName) / btree.getPageSize();
+    EXPECT_LE(batchReads, static_cast<long long>(numPages));
+    EXPECT_LT(batchReads * 5, singleReads);
+
+    cleanUp(sstFileName);
+}
+
+// Test an SST streamed through SSTBuilder: internal pages sit between the leaves, which
+// stay linked in both directions, and the tree and filters answer like a bulk-built one
+TEST(DiskBTreeTest, StreamingBuilder) {
+    std::string sstFileName = "test_sst_streaming_builder.sst";
+    cleanUp(sstFileName);
+
+    // Long keys keep the fanout small, so the tree has several internal levels
+    auto keyOf = [](int i) {
+        std::string number = std::to_string(i);
+        return std::string(6 - number.size(), '0') + number + std::string(200, 'k');
+    };
+    SSTBuildOptions options;
+    options.filterType = SSTFilterType::XOR;
+    options.prefixLength = 4;
+    {
+        SSTBuilder builder(sstFileName, options);
+        for (int i = 0; i < 20000; i += 2) {
+            builder.add(KeyValueWrapper(keyOf(i), std::to_string(i)));
+        }
+        EXPECT_EQ(builder.getNumEntries(), 10000u);
+        builder.finish();
+    }
+
+    DiskBTree btree(sstFileName);
+    EXPECT_EQ(btree.getNumberOfKeyValues(), 10000u);
+    EXPECT_EQ(btree.getFilterType(), SSTFilterType::XOR);
+
+    // Walk the leaf chain forward, then backward
+    std::vector<uint64_t> leafOffsets;
+    int expected = 0;
+    uint64_t previous = 0;
+    for (uint64_t offset = btree.getLeafBeginOffset(); offset != 0;) {
+        Page page = btree.pageManager->readPage(offset);
+        ASSERT_EQ(page.getPageType(), Page::PageType::LEAF_NODE);
+        EXPECT_EQ(page.getPrevLeafOffset(), previous);
+        for (const auto& kv : page.getLeafEntries()) {
+            EXPECT_EQ(kv.kv.string_key(), keyOf(expected));
+            expected += 2;
+        }
+        leafOffsets.push_back(offset);
+        previous = offset;
+        offset = page.getNextLeafOffset();
+    }
+    EXPECT_EQ(expected, 20000);
+    EXPECT_EQ(leafOffsets.back(), btree.getLeafEndOffset());
+    size_t numPages = (btree.getLeafEndOffset() - btree.getLeafBeginOffset()) / btree.getPageSize() + 1;
+    EXPECT_GT(numPages, leafOffsets.size());
+
+    for (int i = 0; i < 20000; i += 37) {
+        std::unique_ptr<KeyValueWrapper> result(btree.search(KeyValueWrapper(keyOf(i), "")));
+        if (i % 2 == 0) {
+            ASSERT_NE(result, nullptr) << i;
+            EXPECT_EQ(result->kv.string_value(), std::to_string(i));
+        } else {
+            EXPECT_EQ(result, nullptr) << i;
+        }
+    }
+    std::vector<KeyValueWrapper> scanned;
+    btree.scan(KeyValueWrapper(keyOf(1000), ""), KeyValueWrapper(keyOf(2999), ""), scanned);
+    EXPECT_EQ(scanned.size(), 1000u);
+    EXPECT_TRUE(btree.mayContainPrefix("0012"));
+    EXPECT_FALSE(btree.mayContainPrefix("0200"));
+    cleanUp(sstFileName);
+
+    // A builder without entries still writes an SST that can be opened
+    {
+        SSTBuilder builder(sstFileName);
+        builder.finish();
+    }
+    DiskBTree empty(sstFileName);
+    EXPECT_EQ(empty.getNumberOfKeyValues(), 0u);
+    std::unique_ptr<KeyValueWrapper> missing(empty.search(KeyValueWrapper(1, 0)));
+    EXPECT_EQ(missing, nullptr);
+    cleanUp(sstFileName);
+}
+
 // Test multiple searches in a loop to assess performance
 TEST(DiskBTreeTest, SearchPerformanceTest) {
     std::string sstFileName = "test_sst_search_performance.sst";
@@ -0,0 +1,118 @@
+//
+// AsyncPageReaderTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "AsyncPageReader.h"
+#include "DiskBTree.h"
+#include "DiskBTreeIterator.h"
+#include "LSMTree.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <random>
+
+namespace fs = std::filesystem;
+
+namespace {
+void removeAsyncTestPath(const std::string& path) {
+    if (fs::exists(path)) {
+        fs::remove_all(path);
+    }
+}
+}
+
+// Every backend returns the requested pages in request order
+TEST(AsyncPageReaderTest, ReadsPagesInRequestOrder) {
+    std::string fileName = "test_async_reader.bin";
+    const size_t pageSize = 4096;
+    const size_t numPages = 64;
+    {
+        std::ofstream ofs(fileName, std::ios::binary);
+        for (size_t i = 0; i < numPages; ++i) {
+            std::vector<char> page(pageSize, static_cast<char>(i));
+            ofs.write(page.data(), page.size());
+        }
+    }
+
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < numPages; ++i) {
+        offsets.push_back(i * pageSize);
+    }
+    std::shuffle(offsets.begin(), offsets.end(), std::mt19937(7));
+
+    for (size_t depth : {1, 4, 16}) {
+        AsyncPageReader reader(fileName, pageSize, depth);
+        EXPECT_EQ(reader.getBackend() == AsyncPageReader::Backend::SYNC, depth == 1);
+        std::vector<std::vector<char>> pages = reader.readPages(offsets);
+        ASSERT_EQ(pages.size(), offsets.size());
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            ASSERT_EQ(pages[i].size(), pageSize);
+            char expected = static_cast<char>(offsets[i] / pageSize);
+            EXPECT_TRUE(std::all_of(pages[i].begin(), pages[i].end(), [expected](char c) { return c == expected; }))
+                << "depth " << depth << ", page " << offsets[i] / pageSize;
+        }
+    }
+
+    // Reading past the end of the file fails
+    AsyncPageReader reader(fileName, pageSize, 4);
+    EXPECT_THROW(reader.readPages({0, numPages * pageSize}), std::runtime_error);
+
+    fs::remove(fileName);
+}
+
+// Batched lookups and scans give the same answers with reads in flight
+TEST(AsyncPageReaderTest, QueueDepthKeepsResults) {
+    std::string dbPath = "test_lsm_io_queue_depth";
+    removeAsyncTestPath(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 0; i < 5000; ++i) {
+            lsmTree.put(KeyValueWrapper(i * 2, i));
+        }
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 10000; i += 3) {
+            keys.emplace_back(i, 0);
+        }
+
+        std::vector<KeyValueWrapper> expected = lsmTree.multiGet(keys);
+        std::vector<KeyValueWrapper> expectedScan;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(9000, 0), expectedScan);
+        std::vector<KeyValueWrapper> expectedReverse;
+        ScanOptions reverse;
+        reverse.reverse = true;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(9000, 0), expectedReverse, reverse);
+
+        lsmTree.setIOQueueDepth(8);
+        EXPECT_EQ(lsmTree.getIOQueueDepth(), 8u);
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        ASSERT_EQ(results.size(), expected.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_EQ(results[i].isEmpty(), expected[i].isEmpty()) << keys[i].kv.int_key();
+            if (!expected[i].isEmpty()) {
+                EXPECT_EQ(results[i].kv.int_value(), expected[i].kv.int_value());
+            }
+        }
+
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(9000, 0), scanned);
+        ASSERT_EQ(scanned.size(), expectedScan.size());
+        for (size_t i = 0; i < scanned.size(); ++i) {
+            EXPECT_EQ(scanned[i].kv.int_key(), expectedScan[i].kv.int_key());
+        }
+        std::vector<KeyValueWrapper> reversed;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(9000, 0), reversed, reverse);
+        ASSERT_EQ(reversed.size(), expectedReverse.size());
+        for (size_t i = 0; i < reversed.size(); ++i) {
+            EXPECT_EQ(reversed[i].kv.int_key(), expectedReverse[i].kv.int_key());
+        }
+
+        // SSTs written afterwards inherit the depth
+        for (int i = 0; i < 1000; ++i) {
+            lsmTree.put(KeyValueWrapper(i * 2 + 1, -i));
+        }
+        EXPECT_EQ(lsmTree.multiGet({KeyValueWrapper(1, 0)})[0].kv.int_value(), 0);
+        EXPECT_EQ(lsmTree.multiGet({KeyValueWrapper(1999, 0)})[0].kv.int_value(), -999);
+    }
+    removeAsyncTestPath(dbPath);
+}
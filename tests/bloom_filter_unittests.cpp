@@ -274,3 +274,19 @@ TEST(BloomFilterTest, DifferentKeyTypes) {
     KeyValueWrapper kvNotAdded("not_added", "no_value");
     EXPECT_FALSE(bf.possiblyContains(kvNotAdded));
 }
+
+// Test sizing helpers used to size leaf filters by actual key count
+TEST(BloomFilterTest, SizeByBitsPerKey) {
+    EXPECT_EQ(BloomFilter::bitsForKeys(100, 10.0), 1000);
+    EXPECT_EQ(BloomFilter::bitsForKeys(1, 2.0), 8); // At least one byte
+    EXPECT_THROW(BloomFilter::bitsForKeys(100, 0.0), std::invalid_argument);
+
+    BloomFilter bf(BloomFilter::bitsForKeys(100, 10.0), 100);
+    EXPECT_EQ(bf.getSerializedSize(), BloomFilter::serializedSizeForBits(1000));
+
+    // More bits per key means fewer false positives
+    double fpr5 = BloomFilter::estimateFalsePositiveRate(5.0);
+    double fpr10 = BloomFilter::estimateFalsePositiveRate(10.0);
+    EXPECT_GT(fpr5, fpr10);
+    EXPECT_NEAR(fpr10, 0.0082, 0.001);
+}
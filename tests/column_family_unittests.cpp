@@ -0,0 +1,246 @@
+//
+// ColumnFamilyTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "VeloxDB.h"
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+void removeColumnFamilyTestPath(const std::string& path) {
+    if (fs::exists(path)) {
+        fs::remove_all(path);
+    }
+}
+}
+
+// Each family is its own keyspace with its own memtable size and levels
+TEST(ColumnFamilyTest, IndependentKeyspaces) {
+    std::string dbName = "test_db_column_families";
+    removeColumnFamilyTestPath(dbName);
+
+    VeloxDB db(1000);
+    db.Open(dbName);
+    ColumnFamilyOptions small;
+    small.memtableSize = 100;
+    ColumnFamilyHandle users = db.CreateColumnFamily("users", small);
+    ColumnFamilyHandle orders = db.CreateColumnFamily("orders");
+    EXPECT_THROW(db.CreateColumnFamily("users"), std::invalid_argument);
+    EXPECT_THROW(db.GetColumnFamily("missing"), std::invalid_argument);
+    EXPECT_EQ(db.GetColumnFamily("orders").getId(), orders.getId());
+    EXPECT_EQ(db.ListColumnFamilies().size(), 3u);
+
+    for (int i = 0; i < 500; ++i) {
+        db.Put(i, i);
+        db.Put(users, i, i * 10);
+    }
+    db.Put(orders, 1, 7);
+    db.Delete(users, 5);
+    db.DeleteRange(users, KeyValueWrapper(100, ""), KeyValueWrapper(200, ""));
+
+    EXPECT_EQ(db.Get(5).kv.int_value(), 5);
+    EXPECT_TRUE(db.Get(users, 5).isEmpty());
+    EXPECT_EQ(db.Get(users, 6).kv.int_value(), 60);
+    EXPECT_EQ(db.Get(orders, 1).kv.int_value(), 7);
+    EXPECT_TRUE(db.Get(orders, 2).isEmpty());
+    EXPECT_EQ(db.Scan(150, 160).size(), 11u);
+    EXPECT_TRUE(db.Scan(users, 150, 160).empty());
+    EXPECT_EQ(db.Scan(users, 0, 499).size(), 399u);
+
+    // Only the users family filled its memtable
+    auto numSSTs = [&dbName](const std::string& dir) {
+        size_t count = 0;
+        for (const auto& entry : fs::directory_iterator(dbName + "/" + dir)) {
+            count += entry.path().extension() == ".sst";
+        }
+        return count;
+    };
+    EXPECT_GT(numSSTs("cf_" + std::to_string(users.getId())), 0u);
+    EXPECT_EQ(numSSTs("cf_" + std::to_string(orders.getId())), 0u);
+    EXPECT_EQ(numSSTs(""), 0u);
+
+    db.Close();
+    removeColumnFamilyTestPath(dbName);
+}
+
+// A batch spanning families is logged once; after a restart every family replays its part
+// of the shared WAL, and parts already flushed are not applied twice
+TEST(ColumnFamilyTest, AtomicBatchRecoversFromSharedWAL) {
+    std::string dbName = "test_db_column_family_batch";
+    removeColumnFamilyTestPath(dbName);
+    ColumnFamilyOptions counterOptions;
+    counterOptions.mergeOperator = std::make_shared<Int64AddOperator>();
+    counterOptions.memtableSize = 5;
+    {
+        VeloxDB db(1000);
+        db.Open(dbName);
+        ColumnFamilyHandle users = db.CreateColumnFamily("users");
+        ColumnFamilyHandle counters = db.CreateColumnFamily("counters", counterOptions);
+
+        for (int i = 0; i < 60; ++i) {
+            WriteBatch batch;
+            batch.Put(i, i);
+            batch.Put(users, i, -i);
+            batch.Merge(counters, i % 10, 1);
+            db.Write(batch);
+            EXPECT_EQ(db.Get(i).sequenceNumber, batch.getSequence());
+            EXPECT_EQ(db.Get(users, i).sequenceNumber, batch.getSequence() + 1);
+        }
+        // The counters family flushed its operands, the others did not flush
+        EXPECT_EQ(db.Get(counters, 3).kv.long_value(), 6);
+        EXPECT_TRUE(fs::exists(dbName + "/cf_" + std::to_string(counters.getId()) + "/manifest.log"));
+        EXPECT_FALSE(fs::exists(dbName + "/manifest.log"));
+
+        // A failed batch leaves no trace in any family
+        WriteBatch bad;
+        bad.Put(users, 1000, 1);
+        bad.Put(ColumnFamilyHandle(99, "unknown"), 1, 1);
+        EXPECT_THROW(db.Write(bad), std::invalid_argument);
+        EXPECT_TRUE(db.Get(users, 1000).isEmpty());
+        db.Close();
+    }
+    {
+        VeloxDB db(1000);
+        db.setColumnFamilyOptions("counters", counterOptions);
+        db.Open(dbName);
+        ColumnFamilyHandle users = db.GetColumnFamily("users");
+        ColumnFamilyHandle counters = db.GetColumnFamily("counters");
+        for (int i = 0; i < 60; ++i) {
+            EXPECT_EQ(db.Get(i).kv.int_value(), i) << i;
+            EXPECT_EQ(db.Get(users, i).kv.int_value(), -i) << i;
+        }
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(db.Get(counters, i).kv.long_value(), 6) << i;
+        }
+
+        // New writes are ordered after everything recovered
+        db.Put(users, 0, 1);
+        EXPECT_GT(db.Get(users, 0).sequenceNumber, db.Get(59).sequenceNumber);
+        db.Close();
+    }
+    removeColumnFamilyTestPath(dbName);
+}
+
+// Past the size limit the shared WAL is rolled, every family flushed and the old segment
+// deleted; the flushed data comes back from the manifests
+TEST(ColumnFamilyTest, SharedWALIsReclaimed) {
+    std::string dbName = "test_db_column_family_wal";
+    removeColumnFamilyTestPath(dbName);
+    {
+        VeloxDB db(100000);
+        db.Open(dbName);
+        ColumnFamilyHandle users = db.CreateColumnFamily("users");
+        db.setMaxWALSize(16 * 1024);
+        for (int i = 0; i < 2000; ++i) {
+            db.Put(i, i);
+            db.Put(users, i, i * 2);
+        }
+        EXPECT_LT(fs::file_size(dbName + "/wal.log"), 16u * 1024);
+        EXPECT_FALSE(fs::exists(WAL::rolledSegmentPath(dbName + "/wal.log")));
+        db.Close();
+    }
+    {
+        VeloxDB db(100000);
+        db.Open(dbName);
+        ColumnFamilyHandle users = db.GetColumnFamily("users");
+        for (int i = 0; i < 2000; i += 7) {
+            EXPECT_EQ(db.Get(i).kv.int_value(), i) << i;
+            EXPECT_EQ(db.Get(users, i).kv.int_value(), i * 2) << i;
+        }
+        db.Close();
+    }
+    removeColumnFamilyTestPath(dbName);
+}
+
+// Families of a database cache their SST pages in one buffer pool
+TEST(ColumnFamilyTest, SharedBlockCache) {
+    std::string dbPath = "test_lsm_column_family_cache";
+    removeColumnFamilyTestPath(dbPath);
+    {
+        LSMTree defaultFamily(100, dbPath);
+        auto shared = defaultFamily.shareWithColumnFamilies(std::make_shared<BufferPool>(100, EvictionPolicy::LRU));
+        LSMTree users(100, dbPath + "/cf_1", ColumnFamilyHandle(1, "users"), shared);
+        for (int i = 0; i < 200; ++i) {
+            defaultFamily.put(KeyValueWrapper(i, i));
+            users.put(KeyValueWrapper(i, i));
+        }
+        for (int round = 0; round < 2; ++round) {
+            EXPECT_EQ(defaultFamily.get(KeyValueWrapper(10, 0)).kv.int_value(), 10);
+            EXPECT_EQ(users.get(KeyValueWrapper(10, 0)).kv.int_value(), 10);
+        }
+        EXPECT_GT(shared->blockCache->getCacheHit(), 0);
+        EXPECT_EQ(defaultFamily.getTotalCacheHits(), users.getTotalCacheHits());
+        EXPECT_EQ(defaultFamily.getTotalCacheHits(), shared->blockCache->getCacheHit());
+    }
+    removeColumnFamilyTestPath(dbPath);
+}
+
+// Database settings reach every family, created before or after the call, unless the
+// family's options set them
+TEST(ColumnFamilyTest, DatabaseSettingsReachEveryFamily) {
+    std::string dbName = "test_column_family_settings";
+    removeColumnFamilyTestPath(dbName);
+    {
+        VeloxDB db(50);
+        db.Open(dbName);
+        ColumnFamilyHandle before = db.CreateColumnFamily("before");
+        ColumnFamilyOptions bloomOptions;
+        bloomOptions.filterType = SSTFilterType::LEAF_BLOOM;
+        ColumnFamilyHandle bloom = db.CreateColumnFamily("bloom", bloomOptions);
+        db.setFilterType(SSTFilterType::XOR);
+        db.setPrefixExtractor(4);
+        ColumnFamilyHandle after = db.CreateColumnFamily("after");
+        for (const auto& handle : {before, bloom, after}) {
+            for (int i = 0; i < 120; ++i) {
+                db.Put(handle, "key" + std::to_string(i), i);
+            }
+        }
+        db.Close();
+    }
+    auto checkSSTs = [&dbName](uint32_t id, SSTFilterType filterType) {
+        size_t numSSTs = 0;
+        for (const auto& entry : fs::directory_iterator(fs::path(dbName) / ("cf_" + std::to_string(id)))) {
+            if (entry.path().extension() == ".sst") {
+                DiskBTree sst(entry.path().string());
+                EXPECT_EQ(sst.getFilterType(), filterType) << entry.path();
+                EXPECT_EQ(sst.getPrefixLength(), 4u) << entry.path();
+                numSSTs++;
+            }
+        }
+        EXPECT_GT(numSSTs, 0u) << id;
+    };
+    checkSSTs(1, SSTFilterType::XOR);
+    checkSSTs(2, SSTFilterType::LEAF_BLOOM);
+    checkSSTs(3, SSTFilterType::XOR);
+    removeColumnFamilyTestPath(dbName);
+}
+
+// The database's default TTL reaches every family without a TTL of its own
+TEST(ColumnFamilyTest, DefaultTTLReachesEveryFamily) {
+    std::string dbName = "test_column_family_ttl";
+    removeColumnFamilyTestPath(dbName);
+    {
+        VeloxDB db;
+        db.Open(dbName);
+        ColumnFamilyHandle before = db.CreateColumnFamily("before");
+        ColumnFamilyOptions permanentOptions;
+        permanentOptions.defaultTTLSeconds = 0;
+        ColumnFamilyHandle permanent = db.CreateColumnFamily("permanent", permanentOptions);
+        db.setDefaultTTL(3600);
+        ColumnFamilyHandle after = db.CreateColumnFamily("after");
+
+        for (const auto& handle : {before, permanent, after}) {
+            db.Put(handle, 1, 1);
+        }
+        db.Put(2, 2);
+        EXPECT_GT(db.Get(before, 1).expiresAt, 0u);
+        EXPECT_GT(db.Get(after, 1).expiresAt, 0u);
+        EXPECT_GT(db.Get(2).expiresAt, 0u);
+        EXPECT_EQ(db.Get(permanent, 1).expiresAt, 0u);
+        db.Close();
+    }
+    removeColumnFamilyTestPath(dbName);
+}
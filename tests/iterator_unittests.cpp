@@ -0,0 +1,465 @@
+//
+// IteratorTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "Memtable.h"
+#include "DiskBTreeIterator.h"
+#include "SSTPrefetchIterator.h"
+#include "MergingIterator.h"
+#include "DBIterator.h"
+#include "LoserTree.h"
+#include "LSMTree.h"
+#include "VeloxDB.h"
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+void removeIteratorTestPath(const std::string& path) {
+    if (fs::exists(path)) {
+        fs::remove_all(path);
+    }
+}
+
+// Sorted child iterator over a vector, used to test the merging logic alone
+class VectorIterator : public Iterator {
+public:
+    explicit VectorIterator(std::vector<KeyValueWrapper> entries) : entries(std::move(entries)) {}
+    bool Valid() const override { return pos < entries.size(); }
+    void SeekToFirst() override { pos = 0; }
+    void SeekToLast() override { pos = entries.empty() ? entries.size() : entries.size() - 1; }
+    void Seek(const KeyValueWrapper& target) override {
+        pos = std::lower_bound(entries.begin(), entries.end(), target) - entries.begin();
+    }
+    void SeekForPrev(const KeyValueWrapper& target) override {
+        size_t upper = std::upper_bound(entries.begin(), entries.end(), target) - entries.begin();
+        pos = upper == 0 ? entries.size() : upper - 1;
+    }
+    void Next() override { pos++; }
+    void Prev() override { pos = pos == 0 ? entries.size() : pos - 1; }
+    const KeyValueWrapper& entry() const override { return entries[pos]; }
+private:
+    std::vector<KeyValueWrapper> entries;
+    size_t pos = entries.size();
+};
+}
+
+// The memtable iterator returns keys in order regardless of insertion order
+TEST(IteratorTest, MemtableIteratorInOrder) {
+    Memtable memtable(1000);
+    std::vector<int> keys(500);
+    for (int i = 0; i < 500; ++i) keys[i] = i * 2;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    for (int key : keys) {
+        memtable.put(KeyValueWrapper(key, key * 10));
+    }
+
+    std::unique_ptr<Iterator> it = memtable.newIterator();
+    int expected = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        EXPECT_EQ(std::get<int>(it->key()), expected);
+        EXPECT_EQ(std::get<int>(it->value()), expected * 10);
+        expected += 2;
+    }
+    EXPECT_EQ(expected, 1000);
+
+    // Seek lands on the first key >= target
+    it->Seek(KeyValueWrapper(301, 0));
+    ASSERT_TRUE(it->Valid());
+    EXPECT_EQ(std::get<int>(it->key()), 302);
+    it->Seek(KeyValueWrapper(5000, 0));
+    EXPECT_FALSE(it->Valid());
+
+    // The iterator keeps the flushed tree alive
+    it->SeekToFirst();
+    memtable.flush();
+    ASSERT_TRUE(it->Valid());
+    EXPECT_EQ(std::get<int>(it->key()), 0);
+}
+
+// key() and value() return the key and the value, each as the type it was written with
+TEST(IteratorTest, KeyAndValueAccessors) {
+    Memtable memtable(100);
+    memtable.put(KeyValueWrapper(std::string("apple"), 1.5));
+    memtable.put(KeyValueWrapper(std::string("banana"), 'b'));
+    memtable.put(KeyValueWrapper(std::string("cherry"), std::string("red")));
+
+    std::unique_ptr<Iterator> it = memtable.newIterator();
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    EXPECT_EQ(it->key(), KeyValueField(std::string("apple")));
+    EXPECT_EQ(it->value(), KeyValueField(1.5));
+    it->Next();
+    EXPECT_EQ(std::get<std::string>(it->key()), "banana");
+    EXPECT_EQ(std::get<char>(it->value()), 'b');
+    it->Next();
+    EXPECT_EQ(std::get<std::string>(it->key()), "cherry");
+    EXPECT_EQ(std::get<std::string>(it->value()), "red");
+    it->Next();
+    EXPECT_FALSE(it->Valid());
+
+    KeyValueWrapper longPair(static_cast<long long>(1) << 40, 7);
+    EXPECT_EQ(std::get<long long>(longPair.getKey()), static_cast<long long>(1) << 40);
+    EXPECT_EQ(std::get<int>(longPair.getValue()), 7);
+    EXPECT_TRUE(std::holds_alternative<std::monostate>(KeyValueWrapper().getKey()));
+}
+
+// The SST iterator walks the leaf chain from any seek position
+TEST(IteratorTest, DiskBTreeIteratorSeek) {
+    std::string fileName = "test_iterator_sst.sst";
+    removeIteratorTestPath(fileName);
+
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 3000; i += 3) {
+        keyValues.emplace_back(i, i * 10);
+    }
+    auto sst = std::make_shared<DiskBTree>(fileName, keyValues);
+
+    DiskBTreeIterator it(sst);
+    int count = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        EXPECT_EQ(std::get<int>(it.key()), count * 3);
+        count++;
+    }
+    EXPECT_EQ(count, 1000);
+
+    for (int target = 0; target < 3010; target += 7) {
+        it.Seek(KeyValueWrapper(target, 0));
+        int expected = (target + 2) / 3 * 3;
+        if (expected >= 3000) {
+            EXPECT_FALSE(it.Valid());
+        } else {
+            ASSERT_TRUE(it.Valid());
+            EXPECT_EQ(std::get<int>(it.key()), expected);
+        }
+    }
+
+    removeIteratorTestPath(fileName);
+}
+
+// The prefetching iterator reads ahead on its own thread and stops at the upper bound
+TEST(IteratorTest, SSTPrefetchIteratorBounds) {
+    std::string fileName = "test_iterator_prefetch.sst";
+    removeIteratorTestPath(fileName);
+
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 30000; i += 3) {
+        keyValues.emplace_back(i, i * 10);
+    }
+    auto sst = std::make_shared<DiskBTree>(fileName, keyValues);
+
+    for (size_t depth : {1, 8}) {
+        sst->setIOQueueDepth(depth);
+        SSTPrefetchIterator all(sst);
+        int count = 0;
+        for (all.SeekToFirst(); all.Valid(); all.Next()) {
+            ASSERT_EQ(all.entry().kv.int_key(), count * 3);
+            count++;
+        }
+        EXPECT_EQ(count, 10000);
+
+        KeyValueWrapper upper(20000, 0);
+        SSTPrefetchIterator bounded(sst, &upper);
+        bounded.Seek(KeyValueWrapper(10000, 0));
+        ASSERT_TRUE(bounded.Valid());
+        EXPECT_EQ(bounded.entry().kv.int_key(), 10002);
+        int last = 0;
+        for (; bounded.Valid() && bounded.entry() < upper; bounded.Next()) {
+            last = bounded.entry().kv.int_key();
+        }
+        EXPECT_EQ(last, 19998);
+        // Abandoning the iterator early stops its reader
+        bounded.stop();
+        EXPECT_FALSE(bounded.Valid());
+        EXPECT_GE(bounded.getReadBusySeconds(), 0.0);
+        EXPECT_THROW(bounded.Prev(), std::logic_error);
+    }
+
+    removeIteratorTestPath(fileName);
+}
+
+// The memtable iterator walks backwards through predecessors
+TEST(IteratorTest, MemtableIteratorReverse) {
+    Memtable memtable(1000);
+    std::vector<int> keys(300);
+    for (int i = 0; i < 300; ++i) keys[i] = i * 2;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+    for (int key : keys) {
+        memtable.put(KeyValueWrapper(key, key));
+    }
+
+    std::unique_ptr<Iterator> it = memtable.newIterator();
+    int expected = 598;
+    for (it->SeekToLast(); it->Valid(); it->Prev()) {
+        EXPECT_EQ(std::get<int>(it->key()), expected);
+        expected -= 2;
+    }
+    EXPECT_EQ(expected, -2);
+
+    // SeekForPrev lands on the last key <= target
+    it->SeekForPrev(KeyValueWrapper(301, 0));
+    ASSERT_TRUE(it->Valid());
+    EXPECT_EQ(std::get<int>(it->key()), 300);
+    it->SeekForPrev(KeyValueWrapper(-1, 0));
+    EXPECT_FALSE(it->Valid());
+}
+
+// The SST iterator follows backward leaf links from any position
+TEST(IteratorTest, DiskBTreeIteratorReverse) {
+    std::string fileName = "test_iterator_sst_reverse.sst";
+    removeIteratorTestPath(fileName);
+
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 3000; i += 3) {
+        keyValues.emplace_back(i, i * 10);
+    }
+    auto sst = std::make_shared<DiskBTree>(fileName, keyValues);
+
+    DiskBTreeIterator it(sst);
+    int expected = 2997;
+    for (it.SeekToLast(); it.Valid(); it.Prev()) {
+        ASSERT_EQ(std::get<int>(it.key()), expected);
+        expected -= 3;
+    }
+    EXPECT_EQ(expected, -3);
+
+    for (int target = -5; target < 3010; target += 7) {
+        it.SeekForPrev(KeyValueWrapper(target, 0));
+        if (target < 0) {
+            EXPECT_FALSE(it.Valid());
+        } else {
+            ASSERT_TRUE(it.Valid());
+            EXPECT_EQ(std::get<int>(it.key()), std::min(target / 3 * 3, 2997));
+        }
+    }
+
+    // Direction changes in the middle of a leaf chain
+    it.Seek(KeyValueWrapper(1500, 0));
+    it.Prev();
+    EXPECT_EQ(std::get<int>(it.key()), 1497);
+    it.Next();
+    it.Next();
+    EXPECT_EQ(std::get<int>(it.key()), 1503);
+
+    removeIteratorTestPath(fileName);
+}
+
+// Equal keys come out of the merging iterator in child order
+TEST(IteratorTest, MergingIteratorOrder) {
+    KeyValueWrapper newer(2, 200);
+    KeyValueWrapper older(2, 100);
+    std::vector<std::unique_ptr<Iterator>> children;
+    children.push_back(std::make_unique<VectorIterator>(std::vector<KeyValueWrapper>{KeyValueWrapper(1, 10), newer}));
+    children.push_back(std::make_unique<VectorIterator>(std::vector<KeyValueWrapper>{older, KeyValueWrapper(3, 30)}));
+
+    MergingIterator it(std::move(children));
+    std::vector<int> values;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        values.push_back(std::get<int>(it.value()));
+    }
+    EXPECT_EQ(values, (std::vector<int>{10, 200, 100, 30}));
+}
+
+// The loser tree yields the sorted union of k inputs for every k, in both directions
+TEST(IteratorTest, LoserTreeKWayMerge) {
+    std::mt19937 rng(123);
+    for (size_t k = 1; k <= 16; ++k) {
+        std::vector<std::unique_ptr<VectorIterator>> inputs;
+        std::vector<Iterator*> handles;
+        std::vector<int> expected;
+        for (size_t i = 0; i < k; ++i) {
+            std::vector<KeyValueWrapper> entries;
+            int key = static_cast<int>(rng() % 10);
+            int count = static_cast<int>(rng() % 50); // some inputs are empty
+            for (int j = 0; j < count; ++j) {
+                key += 1 + static_cast<int>(rng() % 20);
+                entries.emplace_back(key, static_cast<int>(i));
+                expected.push_back(key);
+            }
+            inputs.push_back(std::make_unique<VectorIterator>(entries));
+            handles.push_back(inputs.back().get());
+        }
+        std::sort(expected.begin(), expected.end());
+
+        LoserTree tree(handles);
+        for (auto* input : handles) input->SeekToFirst();
+        tree.build(true);
+        std::vector<int> merged;
+        int lastKey = -1;
+        size_t lastInput = 0;
+        while (!tree.empty()) {
+            int key = tree.top().kv.int_key();
+            // Equal keys come out in input order
+            if (key == lastKey) {
+                EXPECT_GT(tree.winner(), lastInput);
+            }
+            lastKey = key;
+            lastInput = tree.winner();
+            merged.push_back(key);
+            tree.input(tree.winner())->Next();
+            tree.replay();
+        }
+        EXPECT_EQ(merged, expected) << "k = " << k;
+
+        for (auto* input : handles) input->SeekToLast();
+        tree.build(false);
+        std::vector<int> reversed;
+        while (!tree.empty()) {
+            reversed.push_back(tree.top().kv.int_key());
+            tree.input(tree.winner())->Prev();
+            tree.replay();
+        }
+        std::reverse(reversed.begin(), reversed.end());
+        EXPECT_EQ(reversed, expected) << "k = " << k;
+    }
+}
+
+// The DB iterator keeps the newest version of each key and hides deleted keys
+TEST(IteratorTest, DBIteratorResolvesVersions) {
+    std::string dbPath = "test_iterator_lsm";
+    removeIteratorTestPath(dbPath);
+    {
+        LSMTree lsmTree(100, dbPath);
+        for (int i = 0; i < 1000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        // Overwrite every 5th key and delete every 7th key; the new versions sit in newer levels
+        for (int i = 0; i < 1000; i += 5) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 0; i < 1000; i += 7) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+
+        std::unique_ptr<DBIterator> it = lsmTree.newIterator();
+        int expected = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            while (expected % 7 == 0) expected++;
+            ASSERT_EQ(std::get<int>(it->key()), expected);
+            EXPECT_EQ(std::get<int>(it->value()), expected % 5 == 0 ? -expected : expected);
+            expected++;
+        }
+        EXPECT_EQ(expected, 1000);
+
+        // Range scans now stream through the same iterator
+        std::vector<KeyValueWrapper> result;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(200, 0), result);
+        int visible = 0;
+        for (int i = 100; i <= 200; ++i) {
+            if (i % 7 != 0) visible++;
+        }
+        EXPECT_EQ(result.size(), visible);
+    }
+    removeIteratorTestPath(dbPath);
+}
+
+// Switching direction on the DB iterator revisits the same keys
+TEST(IteratorTest, DBIteratorDirectionSwitch) {
+    std::string dbPath = "test_iterator_direction";
+    removeIteratorTestPath(dbPath);
+    {
+        LSMTree lsmTree(64, dbPath);
+        for (int i = 0; i < 400; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 0; i < 400; i += 3) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 0; i < 400; i += 4) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+        auto visibleValue = [](int i) { return i % 3 == 0 ? -i : i; };
+
+        std::unique_ptr<DBIterator> it = lsmTree.newIterator();
+        int expected = 399;
+        for (it->SeekToLast(); it->Valid(); it->Prev()) {
+            while (expected % 4 == 0) expected--;
+            ASSERT_EQ(std::get<int>(it->key()), expected);
+            EXPECT_EQ(std::get<int>(it->value()), visibleValue(expected));
+            expected--;
+        }
+        EXPECT_EQ(expected, 0);
+
+        it->Seek(KeyValueWrapper(200, 0));
+        ASSERT_TRUE(it->Valid());
+        EXPECT_EQ(std::get<int>(it->key()), 201);
+        it->Prev();
+        EXPECT_EQ(std::get<int>(it->key()), 199);
+        it->Prev();
+        EXPECT_EQ(std::get<int>(it->key()), 198);
+        EXPECT_EQ(std::get<int>(it->value()), -198);
+        it->Next();
+        EXPECT_EQ(std::get<int>(it->key()), 199);
+        it->Next();
+        EXPECT_EQ(std::get<int>(it->key()), 201);
+    }
+    removeIteratorTestPath(dbPath);
+}
+
+// Limited and descending scans return the first rows in scan order
+TEST(IteratorTest, ScanLimitAndReverse) {
+    std::string dbPath = "test_iterator_scan_options";
+    removeIteratorTestPath(dbPath);
+
+    auto db = std::make_unique<VeloxDB>(100);
+    db->Open(dbPath);
+    for (int i = 0; i < 1000; ++i) {
+        db->Put(i, i * 10);
+    }
+
+    ScanOptions options;
+    options.limit = 5;
+    std::vector<KeyValueWrapper> result = db->Scan(100, 900, options);
+    ASSERT_EQ(result.size(), 5);
+    EXPECT_EQ(result.front().kv.int_key(), 100);
+    EXPECT_EQ(result.back().kv.int_key(), 104);
+
+    options.reverse = true;
+    result = db->Scan(100, 900, options);
+    ASSERT_EQ(result.size(), 5);
+    EXPECT_EQ(result.front().kv.int_key(), 900);
+    EXPECT_EQ(result.back().kv.int_key(), 896);
+
+    options.limit = 0;
+    result = db->Scan(10, 19, options);
+    ASSERT_EQ(result.size(), 10);
+    for (size_t i = 0; i < result.size(); ++i) {
+        EXPECT_EQ(result[i].kv.int_key(), 19 - static_cast<int>(i));
+        EXPECT_EQ(result[i].kv.int_value(), (19 - static_cast<int>(i)) * 10);
+    }
+
+    db->Close();
+    removeIteratorTestPath(dbPath);
+}
+
+// VeloxDB::NewIterator streams from a seek position
+TEST(IteratorTest, VeloxDBNewIterator) {
+    std::string dbPath = "test_iterator_db";
+    removeIteratorTestPath(dbPath);
+
+    auto db = std::make_unique<VeloxDB>(100);
+    db->Open(dbPath);
+    for (int i = 0; i < 500; ++i) {
+        db->Put(i, i * 10);
+    }
+
+    auto it = db->NewIterator();
+    int count = 0;
+    for (it->Seek(KeyValueWrapper(250, 0)); it->Valid() && std::get<int>(it->key()) < 260; it->Next()) {
+        EXPECT_EQ(std::get<int>(it->value()), std::get<int>(it->key()) * 10);
+        count++;
+    }
+    EXPECT_EQ(count, 10);
+
+    it.reset();
+    db->Close();
+    removeIteratorTestPath(dbPath);
+}
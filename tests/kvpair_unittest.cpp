@@ -27,6 +27,9 @@ TEST(KeyValueWrapperTest, Accessors) {
     // Use the generated Protobuf accessors to verify the key and value
     EXPECT_EQ(kv.kv.int_key(), 100);
     EXPECT_EQ(kv.kv.string_value(), "TestValue");
+
+    // Not numbered until a tree writes it
+    EXPECT_EQ(kv.sequenceNumber, 0u);
 }
 
 
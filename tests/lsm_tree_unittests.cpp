@@ -8,6 +8,8 @@
 #include <filesystem>
 #include <cstdlib>
 #include <ctime>
+#include <thread>
+#include <atomic>
 
 namespace fs = std::filesystem;
 
@@ -304,4 +306,973 @@ TEST(LSMTreeTest, ScanAcrossLevels_II) {
 
     // Clean up
     cleanUpDir(dbPath);
-}
\ No newline at end of file
+}
+// Test 9: Leaf filters are sized by bits per key and reported per level
+TEST(LSMTreeTest, FilterStatsPerLevel) {
+    std::string dbPath = "test_lsm_filter_stats";
+    cleanUpDir(dbPath);
+
+    LSMTree lsmTree(500, dbPath);
+    lsmTree.setBloomFilterBitsPerKey(8.0);
+
+    std::vector<KeyValueWrapper> keyValues = lsm_generateIntKeyValues(1500);
+    for (const auto& kv : keyValues) {
+        lsmTree.put(kv);
+    }
+
+    auto stats = lsmTree.getFilterStats();
+    ASSERT_FALSE(stats.empty());
+    for (const auto& levelStats : stats) {
+        if (levelStats.numKeys == 0) continue;
+        EXPECT_DOUBLE_EQ(levelStats.bitsPerKey, 8.0);
+        // About one byte per key plus a small header per leaf page
+        EXPECT_GE(levelStats.filterBytes, levelStats.numKeys);
+        EXPECT_LT(levelStats.filterBytes, levelStats.numKeys * 2);
+        EXPECT_NEAR(levelStats.expectedFPR, BloomFilter::estimateFalsePositiveRate(8.0), 1e-9);
+    }
+
+    // Lookups still succeed with resized filters
+    for (int i = 0; i < 1500; i += 7) {
+        KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+        EXPECT_EQ(result.kv.int_value(), i * 10);
+    }
+
+    cleanUpDir(dbPath);
+}
+
+// Test 10: Monkey allocation gives smaller levels more bits at the same total budget
+TEST(LSMTreeTest, MonkeyFilterAllocation) {
+    std::vector<size_t> levelSizes = {1000, 2000, 4000, 8000};
+    std::vector<double> bits = LSMTree::computeMonkeyBitsPerKey(levelSizes, 10.0);
+    ASSERT_EQ(bits.size(), levelSizes.size());
+
+    double used = 0, total = 0;
+    double uniformFPR = 0, monkeyFPR = 0;
+    for (size_t i = 0; i < levelSizes.size(); ++i) {
+        if (i > 0) {
+            EXPECT_GT(bits[i - 1], bits[i]);
+        }
+        used += bits[i] * levelSizes[i];
+        total += levelSizes[i];
+        uniformFPR += BloomFilter::estimateFalsePositiveRate(10.0);
+        monkeyFPR += std::exp(-bits[i] * std::log(2.0) * std::log(2.0));
+    }
+    EXPECT_NEAR(used / total, 10.0, 0.01);
+    EXPECT_LT(monkeyFPR, uniformFPR);
+
+    std::string dbPath = "test_lsm_monkey";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(100, dbPath);
+        lsmTree.setMonkeyFilterAllocation(true);
+        std::vector<KeyValueWrapper> keyValues = lsm_generateIntKeyValues(1000);
+        for (const auto& kv : keyValues) {
+            lsmTree.put(kv);
+        }
+        EXPECT_GT(lsmTree.getBloomBitsPerKeyForLevel(1), lsmTree.getBloomBitsPerKeyForLevel(3));
+        for (int i = 0; i < 1000; i += 13) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(i, 0)).kv.int_value(), i * 10);
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 11: SSTs written with the xor filter type report it per level
+TEST(LSMTreeTest, XorFilterType) {
+    std::string dbPath = "test_lsm_xor_filter";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(200, dbPath);
+        lsmTree.setFilterType(SSTFilterType::XOR);
+        std::vector<KeyValueWrapper> keyValues = lsm_generateIntKeyValues(1000);
+        for (const auto& kv : keyValues) {
+            lsmTree.put(kv);
+        }
+
+        for (const auto& levelStats : lsmTree.getFilterStats()) {
+            if (levelStats.numKeys == 0) continue;
+            EXPECT_EQ(levelStats.filterType, SSTFilterType::XOR);
+            EXPECT_GT(levelStats.filterBytes, levelStats.numKeys);
+            EXPECT_DOUBLE_EQ(levelStats.expectedFPR, XorFilter::FALSE_POSITIVE_RATE);
+        }
+        for (int i = 0; i < 1000; i += 3) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(i, 0)).kv.int_value(), i * 10);
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 12: Prefix scans return exactly the prefixed keys and skip SSTs without the prefix
+TEST(LSMTreeTest, ScanPrefix) {
+    std::string dbPath = "test_lsm_scan_prefix";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(100, dbPath);
+        lsmTree.setPrefixExtractor(4);
+
+        // Each batch of 100 keys fills the memtable once, so batches land in different SSTs
+        std::vector<std::string> prefixes = {"acct", "user", "item", "zone"};
+        for (const auto& prefix : prefixes) {
+            for (int i = 0; i < 100; ++i) {
+                lsmTree.put(KeyValueWrapper(prefix + ":" + std::to_string(1000 + i), i));
+            }
+        }
+        // A few more in the memtable
+        lsmTree.put(KeyValueWrapper(std::string("acct:2000"), 2000));
+        lsmTree.put(KeyValueWrapper(std::string("acctx"), 1));
+        lsmTree.put(KeyValueWrapper(1, 1));
+
+        std::vector<KeyValueWrapper> result;
+        lsmTree.scanPrefix("user:", result);
+        ASSERT_EQ(result.size(), 100);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(result[i].kv.string_key(), "user:" + std::to_string(1000 + i));
+            EXPECT_EQ(result[i].kv.int_value(), i);
+        }
+
+        result.clear();
+        lsmTree.scanPrefix("acct", result);
+        ASSERT_EQ(result.size(), 102);
+        EXPECT_EQ(result.back().kv.string_key(), "acctx");
+
+        result.clear();
+        lsmTree.scanPrefix("zone:1050", result);
+        ASSERT_EQ(result.size(), 1);
+        EXPECT_EQ(result[0].kv.int_value(), 50);
+
+        // Absent prefixes are answered by the filters alone
+        size_t skipsBefore = lsmTree.getPrefixFilterSkips();
+        for (int i = 0; i < 20; ++i) {
+            result.clear();
+            lsmTree.scanPrefix("miss" + std::to_string(i), result);
+            EXPECT_TRUE(result.empty());
+        }
+        EXPECT_GT(lsmTree.getPrefixFilterSkips(), skipsBefore);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 13: Full compaction merges every level in one k-way pass
+TEST(LSMTreeTest, CompactAllLevels) {
+    std::string dbPath = "test_lsm_compact_all";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(100, dbPath);
+        for (int i = 0; i < 1000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        // Newer versions and deletes end up in the upper levels
+        for (int i = 0; i < 1000; i += 10) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 5; i < 1000; i += 50) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+
+        size_t occupiedLevels = 0;
+        for (const auto& levelStats : lsmTree.getFilterStats()) {
+            if (levelStats.numKeys > 0) occupiedLevels++;
+        }
+        ASSERT_GE(occupiedLevels, 3);
+
+        lsmTree.compactAll();
+
+        occupiedLevels = 0;
+        for (const auto& levelStats : lsmTree.getFilterStats()) {
+            if (levelStats.numKeys > 0) {
+                occupiedLevels++;
+                // One entry per distinct key (tombstones are kept)
+                EXPECT_EQ(levelStats.numKeys, 1000);
+            }
+        }
+        EXPECT_EQ(occupiedLevels, 1);
+
+        for (int i = 0; i < 1000; ++i) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            if (i % 50 == 5) {
+                EXPECT_TRUE(result.isEmpty()) << i;
+            } else {
+                EXPECT_EQ(result.kv.int_value(), i % 10 == 0 ? -i : i) << i;
+            }
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 14: MultiGet matches Get across the memtable and all levels
+TEST(LSMTreeTest, MultiGet) {
+    std::string dbPath = "test_lsm_multi_get";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(100, dbPath);
+        for (int i = 0; i < 1000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 0; i < 1000; i += 3) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 0; i < 1000; i += 7) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+
+        // Unsorted, with duplicates and missing keys
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 1100; i >= -50; i -= 3) {
+            keys.emplace_back(i, 0);
+        }
+        keys.emplace_back(42, 0);
+        keys.emplace_back(43, 0);
+        keys.emplace_back(43, 0);
+
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        ASSERT_EQ(results.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            KeyValueWrapper expected = lsmTree.get(keys[i]);
+            ASSERT_EQ(results[i].isEmpty(), expected.isEmpty()) << keys[i].kv.int_key();
+            if (!expected.isEmpty()) {
+                EXPECT_EQ(results[i].kv.int_key(), keys[i].kv.int_key());
+                EXPECT_EQ(results[i].kv.int_value(), expected.kv.int_value());
+            }
+        }
+        EXPECT_EQ(results[results.size() - 1].kv.int_value(), 43);
+        EXPECT_TRUE(results[results.size() - 3].isEmpty()); // 42 was deleted
+
+        // Same answers with SST-wide xor filters
+        lsmTree.setFilterType(SSTFilterType::XOR);
+        lsmTree.compactAll();
+        std::vector<KeyValueWrapper> compacted = lsmTree.multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(compacted[i].isEmpty(), results[i].isEmpty()) << keys[i].kv.int_key();
+            if (!results[i].isEmpty()) {
+                EXPECT_EQ(compacted[i].kv.int_value(), results[i].kv.int_value());
+            }
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 15: Concurrent readers on the same SSTs see consistent results
+TEST(LSMTreeTest, ConcurrentReads) {
+    std::string dbPath = "test_lsm_concurrent_reads";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 0; i < 10000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i * 3));
+        }
+
+        std::atomic<int> mismatches{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 8; ++t) {
+            readers.emplace_back([&lsmTree, &mismatches, t]() {
+                for (int i = t; i < 10000; i += 8) {
+                    KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+                    if (result.isEmpty() || result.kv.int_value() != i * 3) mismatches++;
+                }
+                std::vector<KeyValueWrapper> keys;
+                for (int i = t * 1000; i < t * 1000 + 500; ++i) {
+                    keys.emplace_back(i, 0);
+                }
+                std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    if (results[i].kv.int_value() != keys[i].kv.int_key() * 3) mismatches++;
+                }
+                std::vector<KeyValueWrapper> scanned;
+                lsmTree.scan(KeyValueWrapper(t * 1000, 0), KeyValueWrapper(t * 1000 + 999, 0), scanned);
+                if (scanned.size() != 1000) mismatches++;
+            });
+        }
+        // A writer between the readers only waits for them
+        lsmTree.put(KeyValueWrapper(20000, 1));
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        EXPECT_EQ(mismatches.load(), 0);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(20000, 0)).kv.int_value(), 1);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 16: Memory-mapped SSTs give the same answers as pread, including SSTs written later
+TEST(LSMTreeTest, MemoryMappedSSTs) {
+    std::string dbPath = "test_lsm_mmap";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 0; i < 5000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i * 2));
+        }
+        lsmTree.setSSTReadMode(SSTReadMode::MMAP);
+        EXPECT_EQ(lsmTree.getSSTReadMode(), SSTReadMode::MMAP);
+
+        for (int i = 0; i < 5000; i += 7) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            ASSERT_FALSE(result.isEmpty()) << i;
+            EXPECT_EQ(result.kv.int_value(), i * 2);
+        }
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(4099, 0), scanned);
+        ASSERT_EQ(scanned.size(), 4000u);
+        EXPECT_EQ(scanned.front().kv.int_key(), 100);
+        EXPECT_EQ(scanned.back().kv.int_key(), 4099);
+        std::vector<KeyValueWrapper> reversed;
+        ScanOptions reverse;
+        reverse.reverse = true;
+        lsmTree.scan(KeyValueWrapper(100, 0), KeyValueWrapper(4099, 0), reversed, reverse);
+        ASSERT_EQ(reversed.size(), 4000u);
+        EXPECT_EQ(reversed.front().kv.int_key(), 4099);
+
+        // Flushes, merges and compaction write new SSTs that are mapped too
+        for (int i = 0; i < 2000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        lsmTree.compactAll();
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 6000; i += 5) {
+            keys.emplace_back(i, 0);
+        }
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            int key = keys[i].kv.int_key();
+            if (key >= 5000) {
+                EXPECT_TRUE(results[i].isEmpty()) << key;
+            } else {
+                ASSERT_FALSE(results[i].isEmpty()) << key;
+                EXPECT_EQ(results[i].kv.int_value(), key < 2000 ? -key : key * 2);
+            }
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 17: Parallel subcompactions split levels into several SSTs that answer like one
+TEST(LSMTreeTest, ParallelSubcompactions) {
+    std::string dbPath = "test_lsm_subcompactions";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(1000, dbPath);
+        lsmTree.setMaxSubcompactions(4);
+        for (int i = 0; i < 20000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i * 2));
+        }
+        // Overwrite and delete some keys so the merges have to pick the newest versions
+        for (int i = 0; i < 20000; i += 3) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 1; i < 20000; i += 10) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+        lsmTree.compactAll();
+
+        size_t maxSSTs = 0;
+        for (size_t level = 1; level < lsmTree.getNumLevels(); ++level) {
+            maxSSTs = std::max(maxSSTs, lsmTree.getNumSSTsInLevel(static_cast<int>(level)));
+        }
+        EXPECT_GT(maxSSTs, 1u);
+
+        auto expected = [](int i) { return i % 3 == 0 ? -i : i * 2; };
+        for (int i = 0; i < 20000; i += 7) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            if (i % 10 == 1) {
+                EXPECT_TRUE(result.isEmpty()) << i;
+            } else {
+                ASSERT_FALSE(result.isEmpty()) << i;
+                EXPECT_EQ(result.kv.int_value(), expected(i));
+            }
+        }
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 20000; i += 11) {
+            keys.emplace_back(i, 0);
+        }
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            int key = keys[i].kv.int_key();
+            if (key % 10 == 1) {
+                EXPECT_TRUE(results[i].isEmpty()) << key;
+            } else {
+                ASSERT_FALSE(results[i].isEmpty()) << key;
+                EXPECT_EQ(results[i].kv.int_value(), expected(key));
+            }
+        }
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(19999, 0), scanned);
+        ASSERT_EQ(scanned.size(), 18000u);
+        for (size_t i = 1; i < scanned.size(); ++i) {
+            ASSERT_LT(scanned[i - 1].kv.int_key(), scanned[i].kv.int_key());
+        }
+    }
+    // The manifest lists every SST of a level
+    {
+        LSMTree reopened(1000, dbPath);
+        for (int i = 0; i < 20000; i += 13) {
+            KeyValueWrapper result = reopened.get(KeyValueWrapper(i, 0));
+            EXPECT_EQ(result.isEmpty(), i % 10 == 1) << i;
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 18: Compactions report the time of their read, merge and write stages
+TEST(LSMTreeTest, CompactionStageStats) {
+    std::string dbPath = "test_lsm_compaction_stats";
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        EXPECT_EQ(lsmTree.getCompactionStats().numCompactions, 0u);
+        for (int i = 0; i < 4000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        LSMTree::CompactionStats stats = lsmTree.getCompactionStats();
+        EXPECT_GT(stats.numCompactions, 0u);
+        EXPECT_GT(stats.wallSeconds, 0.0);
+        EXPECT_GT(stats.readBusySeconds, 0.0);
+        EXPECT_GT(stats.mergeBusySeconds, 0.0);
+        EXPECT_GT(stats.writeBusySeconds, 0.0);
+        EXPECT_LE(stats.writeBusySeconds, stats.wallSeconds);
+        lsmTree.printCompactionStats();
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 19: Snapshots keep reading the values they saw, through overwrites, flushes and compactions
+TEST(LSMTreeTest, SnapshotReads) {
+    std::string dbPath = "test_lsm_snapshots";
+    cleanUpDir(dbPath);
+    uint64_t lastSequenceNumber = 0;
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 0; i < 3000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        uint64_t snapshotSequenceNumber = lsmTree.getLastSequenceNumber();
+        std::shared_ptr<const Snapshot> snapshot = lsmTree.getSnapshot();
+
+        // Overwrite, delete and add keys, then push everything down the levels
+        for (int i = 0; i < 3000; i += 2) {
+            lsmTree.put(KeyValueWrapper(i, -i));
+        }
+        for (int i = 1; i < 3000; i += 10) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+        for (int i = 3000; i < 4000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        lsmTree.compactAll();
+        EXPECT_GT(lsmTree.getLastSequenceNumber(), snapshotSequenceNumber);
+
+        for (int i = 0; i < 4000; i += 7) {
+            KeyValueWrapper old = lsmTree.get(KeyValueWrapper(i, 0), *snapshot);
+            if (i >= 3000) {
+                EXPECT_TRUE(old.isEmpty()) << i;
+            } else {
+                ASSERT_FALSE(old.isEmpty()) << i;
+                EXPECT_EQ(old.kv.int_value(), i);
+            }
+            KeyValueWrapper latest = lsmTree.get(KeyValueWrapper(i, 0));
+            EXPECT_EQ(latest.isEmpty(), i < 3000 && i % 10 == 1) << i;
+        }
+
+        ScanOptions options;
+        options.snapshot = snapshot;
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(9999, 0), scanned, options);
+        ASSERT_EQ(scanned.size(), 3000u);
+        for (int i = 0; i < 3000; ++i) {
+            EXPECT_EQ(scanned[i].kv.int_value(), i);
+        }
+
+        std::unique_ptr<DBIterator> it = lsmTree.newIterator(snapshot);
+        int expected = 0;
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            EXPECT_EQ(std::get<int>(it->key()), expected);
+            EXPECT_EQ(std::get<int>(it->value()), expected);
+            expected++;
+        }
+        EXPECT_EQ(expected, 3000);
+        lastSequenceNumber = lsmTree.getLastSequenceNumber();
+    }
+    // Sequence numbers keep increasing across reopens
+    {
+        LSMTree reopened(500, dbPath);
+        EXPECT_GE(reopened.getLastSequenceNumber(), lastSequenceNumber);
+        reopened.put(KeyValueWrapper(1, 1));
+        EXPECT_GT(reopened.getLastSequenceNumber(), lastSequenceNumber);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 20: Tombstones are dropped at the bottommost level, and tombstone-heavy SSTs are compacted down
+TEST(LSMTreeTest, TombstoneElimination) {
+    std::string dbPath = "test_lsm_tombstones";
+    auto totalTombstones = [](const LSMTree& lsmTree) {
+        size_t total = 0;
+        for (size_t level = 1; level <= lsmTree.getNumLevels(); ++level) {
+            total += lsmTree.getNumTombstonesInLevel(static_cast<int>(level));
+        }
+        return total;
+    };
+    auto deleteKey = [](LSMTree& lsmTree, int key) {
+        KeyValueWrapper tombstone(key, 0);
+        tombstone.setTombstone(true);
+        lsmTree.put(tombstone);
+    };
+
+    // Without tombstone-triggered compaction, compactAll drops every tombstone
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        lsmTree.setTombstoneCompactionRatio(0);
+        for (int i = 0; i < 4000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 0; i < 4000; i += 2) {
+            deleteKey(lsmTree, i);
+        }
+        EXPECT_GT(totalTombstones(lsmTree), 0u);
+        lsmTree.compactAll();
+        EXPECT_EQ(totalTombstones(lsmTree), 0u);
+        EXPECT_GT(lsmTree.getCompactionStats().numTombstonesDropped, 0u);
+
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(3999, 0), scanned);
+        ASSERT_EQ(scanned.size(), 2000u);
+        for (const auto& kv : scanned) {
+            EXPECT_EQ(kv.kv.int_key() % 2, 1);
+        }
+    }
+    // The tombstone counts are stored in the SSTs' metadata pages
+    {
+        LSMTree reopened(500, dbPath);
+        EXPECT_EQ(totalTombstones(reopened), 0u);
+        EXPECT_TRUE(reopened.get(KeyValueWrapper(10, 0)).isEmpty());
+        EXPECT_EQ(reopened.get(KeyValueWrapper(11, 0)).kv.int_value(), 11);
+    }
+
+    // Flushes of deletes are pushed down and dropped without a full compaction
+    cleanUpDir(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 0; i < 4000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 0; i < 3000; ++i) {
+            deleteKey(lsmTree, i);
+        }
+        // Only the memtable may still hold tombstones
+        EXPECT_EQ(totalTombstones(lsmTree), 0u);
+        EXPECT_GT(lsmTree.getCompactionStats().numTombstonesDropped, 0u);
+        for (int i = 0; i < 4000; i += 13) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(i, 0)).isEmpty(), i < 3000) << i;
+        }
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 21: DeleteRange hides a key range with one write, and compaction drops the covered keys
+TEST(LSMTreeTest, DeleteRange) {
+    std::string dbPath = "test_lsm_delete_range";
+    cleanUpDir(dbPath);
+    auto isDeleted = [](int key) { return key >= 1000 && key < 3000 && key != 1500; };
+    auto check = [&isDeleted](LSMTree& lsmTree) {
+        for (int i = 0; i < 5000; i += 7) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            ASSERT_EQ(result.isEmpty(), isDeleted(i)) << i;
+        }
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1500, 0)).kv.int_value(), -1500);
+
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 5000; i += 11) {
+            keys.emplace_back(i, 0);
+        }
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(results[i].isEmpty(), isDeleted(keys[i].kv.int_key())) << keys[i].kv.int_key();
+        }
+
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(4999, 0), scanned);
+        ASSERT_EQ(scanned.size(), 3001u);
+        for (const auto& kv : scanned) {
+            EXPECT_FALSE(isDeleted(kv.kv.int_key())) << kv.kv.int_key();
+        }
+        ScanOptions reverse;
+        reverse.reverse = true;
+        scanned.clear();
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(4999, 0), scanned, reverse);
+        EXPECT_EQ(scanned.size(), 3001u);
+    };
+    {
+        LSMTree lsmTree(1000, dbPath);
+        for (int i = 0; i < 5000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        std::shared_ptr<const Snapshot> snapshot = lsmTree.getSnapshot();
+        uint64_t before = lsmTree.getLastSequenceNumber();
+        lsmTree.deleteRange(KeyValueWrapper(1000, 0), KeyValueWrapper(3000, 0));
+        EXPECT_EQ(lsmTree.getLastSequenceNumber(), before + 1);
+        lsmTree.put(KeyValueWrapper(1500, -1500));
+        // Still in the memtable
+        check(lsmTree);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(2000, 0), *snapshot).kv.int_value(), 2000);
+    }
+    {
+        // Replayed from the WAL, then flushed into the levels
+        LSMTree lsmTree(1000, dbPath);
+        check(lsmTree);
+        for (int i = 5000; i < 7000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 5000; i < 7000; ++i) {
+            KeyValueWrapper tombstone(i, 0);
+            tombstone.setTombstone(true);
+            lsmTree.put(tombstone);
+        }
+        check(lsmTree);
+
+        lsmTree.compactAll();
+        check(lsmTree);
+        size_t numKeys = 0;
+        for (const auto& levelStats : lsmTree.getFilterStats()) {
+            numKeys += levelStats.numKeys;
+        }
+        // The deletes of 6998 and 6999 are still in the memtable
+        EXPECT_EQ(numKeys, 3003u);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 22: Merge operands are folded with the values below them across flushes, compactions,
+// deletions and restarts
+TEST(LSMTreeTest, MergeOperator) {
+    std::string dbPath = "test_lsm_merge";
+    cleanUpDir(dbPath);
+    auto addOperator = std::make_shared<Int64AddOperator>();
+    const int numRounds = 20;
+    // Counters 0-49 start at 100 and 50-99 at nothing; every round adds 1. Counter 5 is
+    // deleted after round 9 and 60-69 are range deleted after round 14.
+    auto expected = [](int key) -> int64_t {
+        if (key == 5) {
+            return 10;
+        }
+        if (key >= 60 && key < 70) {
+            return 5;
+        }
+        return (key < 50 ? 100 : 0) + 20;
+    };
+    auto check = [&expected](LSMTree& lsmTree) {
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 100; ++i) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            ASSERT_FALSE(result.isMergeOperand()) << i;
+            ASSERT_EQ(result.kv.long_value(), expected(i)) << i;
+            keys.emplace_back(i, 0);
+        }
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(results[i].kv.long_value(), expected(i)) << i;
+        }
+        for (bool reverse : {false, true}) {
+            ScanOptions options;
+            options.reverse = reverse;
+            std::vector<KeyValueWrapper> scanned;
+            lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(99, 0), scanned, options);
+            ASSERT_EQ(scanned.size(), 100u);
+            for (const auto& kv : scanned) {
+                EXPECT_EQ(kv.kv.long_value(), expected(kv.kv.int_key())) << kv.kv.int_key();
+            }
+        }
+    };
+    {
+        LSMTree lsmTree(500, dbPath, addOperator);
+        for (int i = 0; i < 50; ++i) {
+            lsmTree.put(KeyValueWrapper(i, 100));
+        }
+        std::shared_ptr<const Snapshot> snapshot;
+        for (int round = 0; round < numRounds; ++round) {
+            for (int i = 0; i < 100; ++i) {
+                lsmTree.merge(KeyValueWrapper(i, 1));
+            }
+            if (round == 9) {
+                KeyValueWrapper tombstone(5, 0);
+                tombstone.setTombstone(true);
+                lsmTree.put(tombstone);
+                snapshot = lsmTree.getSnapshot();
+            }
+            if (round == 14) {
+                lsmTree.deleteRange(KeyValueWrapper(60, 0), KeyValueWrapper(70, 0));
+            }
+            // Filler pushing the operands into the levels
+            for (int j = 0; j < 450; ++j) {
+                lsmTree.put(KeyValueWrapper(10000 + j, round));
+            }
+        }
+        check(lsmTree);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(0, 0), *snapshot).kv.long_value(), 110);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(60, 0), *snapshot).kv.long_value(), 10);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(5, 0), *snapshot).isEmpty());
+
+        // Still in the memtable
+        lsmTree.merge(KeyValueWrapper(200, 7));
+        lsmTree.merge(KeyValueWrapper(200, 8));
+    }
+    {
+        // Replayed from the WAL, then fully compacted
+        LSMTree lsmTree(500, dbPath, addOperator);
+        check(lsmTree);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(200, 0)).kv.long_value(), 15);
+
+        lsmTree.compactAll();
+        check(lsmTree);
+        lsmTree.merge(KeyValueWrapper(200, 1));
+    }
+    {
+        // Without the operator, the operands left in the WAL cannot be applied
+        EXPECT_THROW(LSMTree(500, dbPath), std::runtime_error);
+    }
+    cleanUpDir(dbPath);
+
+    // Appends to string values
+    {
+        LSMTree lsmTree(50, dbPath, std::make_shared<StringAppendOperator>(","));
+        lsmTree.put(KeyValueWrapper("events", "open"));
+        for (int i = 0; i < 100; ++i) {
+            lsmTree.merge(KeyValueWrapper("events", std::to_string(i)));
+            lsmTree.put(KeyValueWrapper("filler" + std::to_string(i), ""));
+        }
+        std::string expectedLog = "open";
+        for (int i = 0; i < 100; ++i) {
+            expectedLog += "," + std::to_string(i);
+        }
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper("events", "")).kv.string_value(), expectedLog);
+        lsmTree.compactAll();
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper("events", "")).kv.string_value(), expectedLog);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 23: Expired entries are hidden from reads, never uncover older versions, and are
+// dropped by compaction
+TEST(LSMTreeTest, TimeToLive) {
+    std::string dbPath = "test_lsm_ttl";
+    cleanUpDir(dbPath);
+    const uint64_t past = KeyValueWrapper::currentTimeMillis() - 1;
+    // Keys 0-999 are live; 1000-1999 expired, 1000-1099 over an older live version
+    auto check = [](LSMTree& lsmTree) {
+        std::vector<KeyValueWrapper> keys;
+        for (int i = 0; i < 2000; i += 7) {
+            KeyValueWrapper result = lsmTree.get(KeyValueWrapper(i, 0));
+            ASSERT_EQ(result.isEmpty(), i >= 1000) << i;
+            keys.emplace_back(i, 0);
+        }
+        std::vector<KeyValueWrapper> results = lsmTree.multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            EXPECT_EQ(results[i].isEmpty(), keys[i].kv.int_key() >= 1000) << keys[i].kv.int_key();
+        }
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(1999, 0), scanned);
+        EXPECT_EQ(scanned.size(), 1000u);
+    };
+    uint64_t firstExpiry = 0;
+    uint64_t lastExpiry = 0;
+    {
+        LSMTree lsmTree(500, dbPath);
+        for (int i = 1000; i < 1100; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        for (int i = 0; i < 2000; ++i) {
+            KeyValueWrapper kv(i, i);
+            if (i < 1000) {
+                kv.setTTL(3600);
+            } else {
+                kv.expiresAt = past;
+            }
+            lsmTree.put(kv);
+        }
+        firstExpiry = lsmTree.get(KeyValueWrapper(0, 0)).expiresAt;
+        lastExpiry = lsmTree.get(KeyValueWrapper(999, 0)).expiresAt;
+        EXPECT_GT(firstExpiry, past + 3000 * 1000);
+        check(lsmTree);
+        // The last 100 puts are in the WAL
+    }
+    {
+        LSMTree lsmTree(500, dbPath);
+        check(lsmTree);
+        // Expiry times survive the WAL and the SSTs
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(0, 0)).expiresAt, firstExpiry);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(999, 0)).expiresAt, lastExpiry);
+
+        lsmTree.compactAll();
+        check(lsmTree);
+        size_t numKeys = 0;
+        for (const auto& levelStats : lsmTree.getFilterStats()) {
+            numKeys += levelStats.numKeys;
+        }
+        // Only live pairs remain, apart from the ones still in the memtable
+        EXPECT_LE(numKeys, 1000u);
+    }
+    cleanUpDir(dbPath);
+
+    // Default TTL, and cold SSTs reclaimed by the periodic compaction
+    {
+        LSMTree lsmTree(100, dbPath);
+        lsmTree.setDefaultTTL(1);
+        for (int i = 0; i < 150; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        KeyValueWrapper permanent(1000, 1);
+        permanent.expiresAt = past + 3600 * 1000;
+        lsmTree.put(permanent);
+        EXPECT_FALSE(lsmTree.get(KeyValueWrapper(5, 0)).isEmpty());
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(1), 1u);
+
+        lsmTree.setPeriodicCompactionSeconds(1);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (lsmTree.getNumSSTsInLevel(1) > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        // Level 1 is the bottommost, so the expired pairs are gone
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(1), 0u);
+        EXPECT_EQ(lsmTree.getCompactionStats().numExpiredEntries, 100u);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(5, 0)).isEmpty());
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(120, 0)).isEmpty());
+        EXPECT_FALSE(lsmTree.get(KeyValueWrapper(1000, 0)).isEmpty());
+        lsmTree.setPeriodicCompactionSeconds(0);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 24: Snapshot gets and iterator scans keep reading their SSTs while a flush pushes a
+// tombstone-dense level they hold down to the next level
+TEST(LSMTreeTest, SnapshotReadsDuringFlushCascades) {
+    std::string dbPath = "test_lsm_snapshot_concurrency";
+    for (int attempt = 0; attempt < 5; ++attempt) {
+        // Level 2 deletes keys 0-199 of level 4; level 3 is empty, so the next flush moves
+        // level 2 there
+        cleanUpDir(dbPath);
+        fs::create_directories(dbPath);
+        std::vector<KeyValueWrapper> tombstones, values;
+        for (int i = 0; i < 1000; ++i) {
+            values.emplace_back(i, i);
+            if (i < 200) {
+                tombstones.emplace_back(i, 0);
+                tombstones.back().setTombstone(true);
+            }
+        }
+        DiskBTree(dbPath + "/L2_SSTable_0.sst", tombstones);
+        DiskBTree(dbPath + "/L4_SSTable_1.sst", values);
+        VersionEdit layout;
+        layout.nextFileNumber = 2;
+        layout.levelCapacities = {{1, 100}, {2, 200}, {3, 400}, {4, 10000}};
+        layout.addedFiles.push_back({2, "L2_SSTable_0.sst", tombstones.front()});
+        layout.addedFiles.push_back({4, "L4_SSTable_1.sst", values.front()});
+        ManifestLog(dbPath + "/manifest.log", layout);
+
+        LSMTree lsmTree(100, dbPath);
+        // Memory-mapped SSTs fault if the move unmaps them under a reader
+        lsmTree.setSSTReadMode(SSTReadMode::MMAP);
+        std::shared_ptr<const Snapshot> snapshot = lsmTree.getSnapshot();
+
+        std::atomic<bool> done{false};
+        std::atomic<int> failures{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 2; ++t) {
+            readers.emplace_back([&]() {
+                do {
+                    std::unique_ptr<DBIterator> it = lsmTree.newIterator(snapshot);
+                    int expected = 200;
+                    for (it->SeekToFirst(); it->Valid(); it->Next(), ++expected) {
+                        if (std::get<int>(it->key()) != expected || std::get<int>(it->value()) != expected) {
+                            failures++;
+                        }
+                    }
+                    if (expected != 1000) {
+                        failures++;
+                    }
+                    for (int key = 0; key < 1000; key += 37) {
+                        KeyValueWrapper result = lsmTree.get(KeyValueWrapper(key, 0), *snapshot);
+                        if (key < 200 ? !result.isEmpty() : result.kv.int_value() != key) {
+                            failures++;
+                        }
+                    }
+                } while (!done);
+            });
+        }
+
+        for (int i = 2000; i < 2300; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        EXPECT_EQ(failures.load(), 0);
+        // The latest state still has the deletes
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(5, 0)).isEmpty());
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(500, 0)).kv.int_value(), 500);
+    }
+    cleanUpDir(dbPath);
+}
+
+// Test 25: An operand the merge operator rejects fails its write before it is logged; ones
+// that reach the WAL or the SSTs anyway are dropped on replay and compaction
+TEST(LSMTreeTest, RejectedMergeOperands) {
+    std::string dbPath = "test_lsm_merge_rejected";
+    cleanUpDir(dbPath);
+    auto addOperator = std::make_shared<Int64AddOperator>();
+    {
+        LSMTree lsmTree(1000, dbPath, addOperator);
+        lsmTree.put(KeyValueWrapper(1, "abc"));
+        EXPECT_THROW(lsmTree.merge(KeyValueWrapper(1, 1)), std::invalid_argument);
+
+        // The whole batch fails, also when the rejected operand folds onto its own put
+        WriteBatch batch;
+        batch.Put(KeyValueWrapper(2, 5));
+        batch.Put(KeyValueWrapper(3, "x"));
+        batch.Merge(KeyValueWrapper(3, 1));
+        EXPECT_THROW(lsmTree.write(batch), std::invalid_argument);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(2, 0)).isEmpty());
+
+        // Deleted first, the string value is not merged with
+        WriteBatch deleted;
+        deleted.Put(KeyValueWrapper(4, "x"));
+        deleted.DeleteRange(KeyValueWrapper(4, 0), KeyValueWrapper(5, 0));
+        deleted.Merge(KeyValueWrapper(4, 1));
+        lsmTree.write(deleted);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(4, 0)).kv.long_value(), 1);
+
+        // On disk the value below is not checked; compaction drops the operand
+        lsmTree.put(KeyValueWrapper(10, "abc"));
+        lsmTree.flush();
+        lsmTree.merge(KeyValueWrapper(10, 1));
+        lsmTree.flush();
+        lsmTree.compactAll();
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(10, 0)).kv.string_value(), "abc");
+        EXPECT_EQ(lsmTree.getCompactionStats().numMergeOperandsRejected, 1u);
+    }
+    {
+        LSMTree lsmTree(1000, dbPath, addOperator);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1, 0)).kv.string_value(), "abc");
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(4, 0)).kv.long_value(), 1);
+    }
+    cleanUpDir(dbPath);
+
+    // Operands logged under another operator are dropped when the WAL is replayed
+    {
+        LSMTree lsmTree(1000, dbPath, std::make_shared<StringAppendOperator>(","));
+        lsmTree.put(KeyValueWrapper(20, "a"));
+        lsmTree.merge(KeyValueWrapper(20, "b"));
+    }
+    {
+        LSMTree lsmTree(1000, dbPath, addOperator);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(20, 0)).kv.string_value(), "a");
+    }
+    cleanUpDir(dbPath);
+}
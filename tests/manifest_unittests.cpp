@@ -0,0 +1,249 @@
+//
+// ManifestTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "LSMTree.h"
+#include "Manifest.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+void removeManifestTestPath(const std::string& path) {
+    if (fs::exists(path)) {
+        fs::remove_all(path);
+    }
+}
+
+size_t numSSTFiles(const std::string& dir) {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        count += entry.path().extension() == ".sst";
+    }
+    return count;
+}
+}
+
+// Edits round-trip through the log; a torn last record is cut off on replay
+TEST(ManifestTest, ReplayAppliesEditsAndCutsTornTail) {
+    std::string dir = "test_manifest_log";
+    removeManifestTestPath(dir);
+    fs::create_directories(dir);
+    std::string path = dir + "/manifest.log";
+
+    VersionEdit snapshot;
+    snapshot.lastSequenceNumber = 10;
+    snapshot.nextFileNumber = 3;
+    snapshot.levelCapacities = {{1, 100}, {2, 200}};
+    snapshot.addedFiles.push_back({1, "L1_SSTable_1.sst", KeyValueWrapper(50, 0)});
+    snapshot.addedFiles.push_back({2, "L2_SSTable_2.sst", KeyValueWrapper(0, 0)});
+    snapshot.addedFiles.push_back({2, "L2_SSTable_0.sst", KeyValueWrapper(100, 0)});
+    size_t logSize = 0;
+    {
+        ManifestLog log(path, snapshot);
+        VersionEdit edit;
+        edit.lastSequenceNumber = 20;
+        edit.flushedSequenceNumber = 20;
+        edit.nextFileNumber = 4;
+        edit.removedFiles.push_back({1, "L1_SSTable_1.sst"});
+        edit.addedFiles.push_back({1, "L1_SSTable_3.sst", KeyValueWrapper(7, 0)});
+        log.append(edit);
+        EXPECT_EQ(log.getNumEdits(), 1u);
+        logSize = fs::file_size(path);
+    }
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn << "\x40\x00\x00\x00partial record";
+    }
+
+    ManifestState state;
+    EXPECT_EQ(ManifestLog::replay(path, state), 2u);
+    EXPECT_EQ(fs::file_size(path), logSize);
+    EXPECT_EQ(state.lastSequenceNumber, 20u);
+    EXPECT_EQ(state.flushedSequenceNumber, 20u);
+    EXPECT_EQ(state.nextFileNumber, 4u);
+    ASSERT_EQ(state.levelCapacities, (std::vector<size_t>{100, 200}));
+    EXPECT_EQ(state.sortedFiles(0), std::vector<std::string>{"L1_SSTable_3.sst"});
+    EXPECT_EQ(state.sortedFiles(1), (std::vector<std::string>{"L2_SSTable_2.sst", "L2_SSTable_0.sst"}));
+
+    // A snapshot of the state rebuilds it from nothing
+    ManifestState rebuilt;
+    rebuilt.apply(ManifestState::diff(ManifestState(), state));
+    EXPECT_EQ(rebuilt.sortedFiles(1), state.sortedFiles(1));
+    EXPECT_TRUE(ManifestState::diff(state, rebuilt).addedFiles.empty());
+    EXPECT_TRUE(ManifestState::diff(state, rebuilt).removedFiles.empty());
+
+    // A log of another format version, or without the header, is refused
+    {
+        std::fstream log(path, std::ios::binary | std::ios::in | std::ios::out);
+        log.seekp(sizeof(uint32_t));
+        uint32_t version = ManifestLog::FORMAT_VERSION + 1;
+        log.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    ManifestState other;
+    EXPECT_THROW(ManifestLog::replay(path, other), std::runtime_error);
+    {
+        std::ofstream log(path, std::ios::binary | std::ios::trunc);
+        log << "not a manifest";
+    }
+    EXPECT_THROW(ManifestLog::replay(path, other), std::runtime_error);
+    removeManifestTestPath(dir);
+}
+
+// Flushes and compactions are logged as they happen: a copy of the directory taken while
+// the tree is open (as after a crash) recovers every level, without leftover SSTs, and the
+// log is restarted from a snapshot instead of growing with every edit
+TEST(ManifestTest, RecoversLevelsWithoutSaveState) {
+    std::string dbPath = "test_manifest_recovery";
+    std::string crashPath = dbPath + "_crash";
+    removeManifestTestPath(dbPath);
+    removeManifestTestPath(crashPath);
+    {
+        LSMTree lsmTree(10, dbPath);
+        for (int i = 0; i < 1000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        // Past SNAPSHOT_INTERVAL edits the log was started over
+        EXPECT_LT(fs::file_size(dbPath + "/manifest.log"), 64u * 1024);
+        fs::copy(dbPath, crashPath, fs::copy_options::recursive);
+    }
+    {
+        LSMTree lsmTree(10, crashPath);
+        for (int i = 0; i < 1000; i += 3) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(i, 0)).kv.int_value(), i) << i;
+        }
+        size_t numSSTs = 0;
+        for (size_t level = 1; level < lsmTree.getNumLevels(); ++level) {
+            numSSTs += lsmTree.getNumSSTsInLevel(static_cast<int>(level));
+        }
+        EXPECT_EQ(numSSTFiles(crashPath), numSSTs);
+
+        // New SSTs do not reuse the names of live ones
+        for (int i = 1000; i < 1500; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        lsmTree.compactAll();
+    }
+    {
+        LSMTree lsmTree(10, crashPath);
+        for (int i = 0; i < 1500; i += 7) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(i, 0)).kv.int_value(), i) << i;
+        }
+    }
+    removeManifestTestPath(dbPath);
+    removeManifestTestPath(crashPath);
+}
+
+// A manifest.lsm written by older versions (one SST per level) is read once and replaced
+// by the log
+TEST(ManifestTest, MigratesLegacyManifest) {
+    std::string dbPath = "test_manifest_legacy";
+    removeManifestTestPath(dbPath);
+    fs::create_directories(dbPath);
+    std::vector<KeyValueWrapper> level1, level3;
+    for (int i = 0; i < 100; ++i) {
+        level1.emplace_back(i, i * 2);
+        level3.emplace_back(i + 50, -1);
+    }
+    DiskBTree(dbPath + "/L1_SSTable_0.sst", level1);
+    DiskBTree(dbPath + "/L3_SSTable_1.sst", level3);
+    {
+        //   size_t numLevels | per level: int level | size_t length | name (0 = none) | size_t capacity
+        std::ofstream ofs(dbPath + "/manifest.lsm", std::ios::binary);
+        std::vector<std::string> names = {"L1_SSTable_0.sst", "", "L3_SSTable_1.sst"};
+        size_t numLevels = names.size();
+        ofs.write(reinterpret_cast<const char*>(&numLevels), sizeof(numLevels));
+        for (size_t i = 0; i < names.size(); ++i) {
+            int level = static_cast<int>(i + 1);
+            size_t nameLength = names[i].size();
+            size_t capacity = 1000 << i;
+            ofs.write(reinterpret_cast<const char*>(&level), sizeof(level));
+            ofs.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+            ofs.write(names[i].data(), nameLength);
+            ofs.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+        }
+    }
+    auto check = [](LSMTree& lsmTree) {
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(42, 0)).kv.int_value(), 84);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(99, 0)).kv.int_value(), 198);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(120, 0)).kv.int_value(), -1);
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(1), 1u);
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(2), 0u);
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(3), 1u);
+    };
+    {
+        LSMTree lsmTree(1000, dbPath);
+        check(lsmTree);
+    }
+    EXPECT_FALSE(fs::exists(dbPath + "/manifest.lsm"));
+    EXPECT_TRUE(fs::exists(dbPath + "/manifest.log"));
+    {
+        LSMTree lsmTree(1000, dbPath);
+        check(lsmTree);
+    }
+    removeManifestTestPath(dbPath);
+}
+
+// Any other manifest.lsm layout is rejected rather than misread: here one with a sequence
+// number and a list of SSTs per level
+TEST(ManifestTest, RejectsUnknownLegacyLayout) {
+    std::string dbPath = "test_manifest_legacy_unknown";
+    removeManifestTestPath(dbPath);
+    fs::create_directories(dbPath);
+    std::vector<KeyValueWrapper> keyValues = {KeyValueWrapper(1, 1)};
+    DiskBTree(dbPath + "/L1_SSTable_0.sst", keyValues);
+    {
+        std::ofstream ofs(dbPath + "/manifest.lsm", std::ios::binary);
+        size_t numLevels = 1, numSSTs = 1, capacity = 1000;
+        uint64_t sequenceNumber = 7;
+        int level = 1;
+        std::string name = "L1_SSTable_0.sst";
+        size_t nameLength = name.size();
+        ofs.write(reinterpret_cast<const char*>(&numLevels), sizeof(numLevels));
+        ofs.write(reinterpret_cast<const char*>(&sequenceNumber), sizeof(sequenceNumber));
+        ofs.write(reinterpret_cast<const char*>(&level), sizeof(level));
+        ofs.write(reinterpret_cast<const char*>(&numSSTs), sizeof(numSSTs));
+        ofs.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        ofs.write(name.data(), nameLength);
+        ofs.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+    }
+    EXPECT_THROW(LSMTree(1000, dbPath), std::runtime_error);
+    EXPECT_TRUE(fs::exists(dbPath + "/manifest.lsm"));
+    removeManifestTestPath(dbPath);
+}
+
+// A level of many SSTs is opened from the manifest alone: every SST is found by the smallest
+// key the manifest recorded for it
+TEST(ManifestTest, OpensManySSTsFromManifest) {
+    std::string dbPath = "test_manifest_open";
+    removeManifestTestPath(dbPath);
+    fs::create_directories(dbPath);
+    const int numSSTs = 40;
+    VersionEdit snapshot;
+    snapshot.nextFileNumber = numSSTs;
+    snapshot.levelCapacities = {{1, 100}, {2, 10000}};
+    for (int i = 0; i < numSSTs; ++i) {
+        std::vector<KeyValueWrapper> keyValues;
+        for (int j = 0; j < 50; ++j) {
+            keyValues.emplace_back(i * 50 + j, i);
+        }
+        std::string fileName = "L2_SSTable_" + std::to_string(i) + ".sst";
+        DiskBTree(dbPath + "/" + fileName, keyValues);
+        snapshot.addedFiles.push_back({2, fileName, keyValues.front()});
+    }
+    ManifestLog(dbPath + "/manifest.log", snapshot);
+    {
+        LSMTree lsmTree(100, dbPath);
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(1), 0u);
+        EXPECT_EQ(lsmTree.getNumSSTsInLevel(2), static_cast<size_t>(numSSTs));
+        for (int key = 0; key < numSSTs * 50; key += 13) {
+            EXPECT_EQ(lsmTree.get(KeyValueWrapper(key, 0)).kv.int_value(), key / 50) << key;
+        }
+        std::vector<KeyValueWrapper> scanned;
+        lsmTree.scan(KeyValueWrapper(0, 0), KeyValueWrapper(numSSTs * 50, 0), scanned);
+        EXPECT_EQ(scanned.size(), static_cast<size_t>(numSSTs * 50));
+    }
+    removeManifestTestPath(dbPath);
+}
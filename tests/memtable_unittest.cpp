@@ -116,3 +116,22 @@ TEST(MemtableTest, ScanRange) {
     delete memtable;
     fs::remove_all("defaultDB");
 }
+
+// Test clearing the memtable while an iterator still walks the old entries
+TEST(MemtableTest, ClearKeepsOpenIterators) {
+    Memtable memtable(10);
+    for (int i = 0; i < 5; ++i) {
+        memtable.put(KeyValueWrapper(i, i * 100));
+    }
+    std::unique_ptr<Iterator> it = memtable.newIterator();
+    memtable.clear();
+    EXPECT_EQ(memtable.getCurrentSize(), 0);
+    EXPECT_TRUE(memtable.get(KeyValueWrapper(3, "")).isEmpty());
+
+    int expected = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        EXPECT_EQ(it->entry().kv.int_value(), expected * 100);
+        expected++;
+    }
+    EXPECT_EQ(expected, 5);
+}
@@ -0,0 +1,97 @@
+//
+// MergeOperatorTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "MergeOperator.h"
+#include "Memtable.h"
+
+namespace {
+KeyValueWrapper operand(int key, int value, uint64_t sequenceNumber) {
+    KeyValueWrapper kv(key, value);
+    kv.sequenceNumber = sequenceNumber;
+    kv.setMergeOperand(true);
+    return kv;
+}
+}
+
+// Operands apply oldest first onto the base; the result takes the newest operand's key and sequence number
+TEST(MergeOperatorTest, FoldAppliesOperandsOldestFirst) {
+    Int64AddOperator add;
+    KeyValueWrapper base(7, 100);
+    std::vector<KeyValueWrapper> operands = {operand(7, 3, 12), operand(7, 2, 11), operand(7, 1, 10)};
+
+    KeyValueWrapper result = add.fold(&base, operands);
+    EXPECT_EQ(result.kv.int_key(), 7);
+    EXPECT_EQ(result.kv.long_value(), 106);
+    EXPECT_EQ(result.sequenceNumber, 12u);
+    EXPECT_FALSE(result.isMergeOperand());
+    EXPECT_FALSE(result.isTombstone());
+
+    // Without a base, partially: still an operand, for the versions that may lie below
+    KeyValueWrapper partial = add.fold(nullptr, operands, true);
+    EXPECT_EQ(partial.kv.long_value(), 6);
+    EXPECT_TRUE(partial.isMergeOperand());
+    EXPECT_EQ(add.fold(&base, {partial}).kv.long_value(), 106);
+
+    EXPECT_THROW(add.fold(&base, {}), std::invalid_argument);
+    EXPECT_THROW(add.fold(nullptr, {KeyValueWrapper(7, "x")}), std::invalid_argument);
+
+    // Counting rejections instead: the rejected operand is skipped, and with nothing
+    // applied the base stands, or the key is deleted
+    size_t numRejected = 0;
+    std::vector<KeyValueWrapper> mixed = {operand(7, 3, 12), KeyValueWrapper(7, "x"), operand(7, 1, 10)};
+    EXPECT_EQ(add.fold(&base, mixed, false, &numRejected).kv.long_value(), 104);
+    EXPECT_EQ(numRejected, 1u);
+    KeyValueWrapper text(7, "text");
+    EXPECT_EQ(add.fold(&text, {operand(7, 1, 13)}, false, &numRejected).kv.string_value(), "text");
+    EXPECT_TRUE(add.fold(nullptr, {KeyValueWrapper(7, "x")}, false, &numRejected).isTombstone());
+    EXPECT_EQ(numRejected, 3u);
+
+    StringAppendOperator append("|");
+    KeyValueWrapper first("log", "a");
+    KeyValueWrapper second("log", "b");
+    EXPECT_EQ(append.fold(nullptr, {second, first}).kv.string_value(), "a|b");
+    KeyValueWrapper existing("log", "start");
+    EXPECT_EQ(append.fold(&existing, {second, first}).kv.string_value(), "start|a|b");
+}
+
+// The memtable folds each operand into the key's entry as it arrives
+TEST(MergeOperatorTest, MemtableFoldsEagerly) {
+    Int64AddOperator add;
+    Memtable memtable(100);
+
+    // No entry: the operand stays one, an older value may be on disk
+    memtable.merge(operand(1, 5, 1), add);
+    memtable.merge(operand(1, 2, 2), add);
+    KeyValueWrapper entry = memtable.get(KeyValueWrapper(1, 0));
+    EXPECT_TRUE(entry.isMergeOperand());
+    EXPECT_EQ(entry.kv.long_value(), 7);
+    EXPECT_EQ(entry.sequenceNumber, 2u);
+
+    // Onto a value
+    KeyValueWrapper value(2, 40);
+    value.sequenceNumber = 3;
+    memtable.put(value);
+    memtable.merge(operand(2, 2, 4), add);
+    entry = memtable.get(KeyValueWrapper(2, 0));
+    EXPECT_FALSE(entry.isMergeOperand());
+    EXPECT_EQ(entry.kv.long_value(), 42);
+
+    // Onto a deletion: nothing below counts
+    KeyValueWrapper tombstone(3, 0);
+    tombstone.sequenceNumber = 5;
+    tombstone.setTombstone(true);
+    memtable.put(tombstone);
+    memtable.merge(operand(3, 9, 6), add);
+    entry = memtable.get(KeyValueWrapper(3, 0));
+    EXPECT_FALSE(entry.isMergeOperand());
+    EXPECT_FALSE(entry.isTombstone());
+    EXPECT_EQ(entry.kv.long_value(), 9);
+
+    memtable.addRangeTombstone(RangeTombstone{KeyValueWrapper(10, 0), KeyValueWrapper(20, 0), 7});
+    memtable.merge(operand(15, 1, 8), add);
+    entry = memtable.get(KeyValueWrapper(15, 0));
+    EXPECT_FALSE(entry.isMergeOperand());
+    EXPECT_EQ(entry.kv.long_value(), 1);
+}
@@ -408,3 +408,52 @@ TEST(PageManagerTest, WritePageWithIncorrectPageSizeThrowsException) {
     std::filesystem::remove(fileName);
     std::filesystem::remove_all("test_db");
 }
+
+// Test reading pages through a memory mapping of the file
+TEST(PageManagerTest, MemoryMappedReads) {
+    std::filesystem::create_directories("test_db");
+    std::string fileName = "test_db/test_page_manager_mmap.dat";
+    if (std::filesystem::exists(fileName)) {
+        std::filesystem::remove(fileName);
+    }
+
+    std::vector<uint64_t> offsets;
+    {
+        PageManager writer(fileName);
+        for (int i = 0; i < 8; ++i) {
+            uint64_t offset = writer.allocatePage();
+            offsets.push_back(offset);
+            Page page(Page::PageType::LEAF_NODE);
+            page.addLeafEntry(KeyValueWrapper(i, "value" + std::to_string(i)));
+            writer.writePage(offset, page);
+        }
+    }
+
+    // A fresh PageManager has an empty buffer pool, so every read goes to the mapping
+    PageManager pageManager(fileName);
+    pageManager.setReadMode(SSTReadMode::MMAP);
+    EXPECT_EQ(pageManager.getReadMode(), SSTReadMode::MMAP);
+    pageManager.adviseAccess(offsets.front(), offsets.size() * 4096, true);
+    std::vector<Page> pages = pageManager.readPages(offsets);
+    ASSERT_EQ(pages.size(), offsets.size());
+    for (int i = 0; i < 8; ++i) {
+        Page page = pageManager.readPage(offsets[i]);
+        ASSERT_EQ(page.getLeafEntries().size(), 1);
+        EXPECT_EQ(page.getLeafEntries()[0].kv.int_key(), i);
+        EXPECT_EQ(page.getLeafEntries()[0].kv.string_value(), "value" + std::to_string(i));
+        EXPECT_EQ(pages[i].getLeafEntries()[0].kv.int_key(), i);
+    }
+    std::vector<char> raw = pageManager.readRawBytes(offsets[0], 4096);
+    Page rawPage(Page::PageType::LEAF_NODE);
+    rawPage.deserialize(raw);
+    EXPECT_EQ(rawPage.getLeafEntries()[0].kv.int_key(), 0);
+
+    // Pages past the mapping are read with pread
+    EXPECT_THROW(pageManager.readPage(offsets.back() + 4096), std::runtime_error);
+
+    pageManager.setReadMode(SSTReadMode::PREAD);
+    EXPECT_EQ(pageManager.readPage(offsets[3]).getLeafEntries()[0].kv.int_key(), 3);
+
+    pageManager.close();
+    std::filesystem::remove_all("test_db");
+}
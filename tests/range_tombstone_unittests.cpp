@@ -0,0 +1,85 @@
+//
+// RangeTombstoneTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "RangeTombstone.h"
+
+namespace {
+RangeTombstone makeTombstone(int start, int end, uint64_t sequenceNumber) {
+    return RangeTombstone{KeyValueWrapper(start, 0), KeyValueWrapper(end, 0), sequenceNumber};
+}
+
+KeyValueWrapper version(int key, uint64_t sequenceNumber) {
+    KeyValueWrapper kv(key, 0);
+    kv.sequenceNumber = sequenceNumber;
+    return kv;
+}
+}
+
+// Overlapping tombstones: each key is covered up to the newest tombstone containing it
+TEST(RangeTombstoneTest, OverlappingFragments) {
+    RangeTombstoneList list;
+    list.add(makeTombstone(10, 50, 5));
+    list.add(makeTombstone(30, 80, 9));
+    list.add(makeTombstone(40, 45, 2));
+    list.add(makeTombstone(60, 60, 20)); // empty, ignored
+    EXPECT_EQ(list.size(), 3u);
+
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(9, 0)), 0u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(10, 0)), 5u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(29, 0)), 5u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(30, 0)), 9u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(42, 0)), 9u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(79, 0)), 9u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(80, 0)), 0u);
+
+    // Only versions written before the covering tombstone are deleted
+    EXPECT_TRUE(list.covers(version(20, 4)));
+    EXPECT_FALSE(list.covers(version(20, 6)));
+    EXPECT_TRUE(list.covers(version(70, 8)));
+    EXPECT_FALSE(list.covers(version(90, 1)));
+}
+
+// The serialized block decodes to the same tombstones and coverage
+TEST(RangeTombstoneTest, SerializeRoundTrip) {
+    RangeTombstoneList list;
+    list.add(RangeTombstone{KeyValueWrapper("a", ""), KeyValueWrapper("c", ""), 3});
+    list.add(RangeTombstone{KeyValueWrapper("b", ""), KeyValueWrapper("z", ""), 7});
+
+    RangeTombstoneList decoded = RangeTombstoneList::deserialize(list.serialize());
+    ASSERT_EQ(decoded.size(), 2u);
+    EXPECT_EQ(decoded.getTombstones()[1].start.kv.string_key(), "b");
+    EXPECT_EQ(decoded.getTombstones()[1].sequenceNumber, 7u);
+    EXPECT_EQ(decoded.maxCoveringSequence(KeyValueWrapper("a", "")), 3u);
+    EXPECT_EQ(decoded.maxCoveringSequence(KeyValueWrapper("bb", "")), 7u);
+    EXPECT_EQ(decoded.maxCoveringSequence(KeyValueWrapper("z", "")), 0u);
+
+    std::vector<char> truncated = list.serialize();
+    truncated.resize(truncated.size() - 1);
+    EXPECT_THROW(RangeTombstoneList::deserialize(truncated), std::runtime_error);
+}
+
+// Fragments are built once for many adds, on the first lookup, and rebuilt after more adds;
+// copies and moves carry the tombstones whether or not their fragments were built
+TEST(RangeTombstoneTest, FragmentsBuiltOnLookup) {
+    RangeTombstoneList list;
+    const int numTombstones = 20000;
+    for (int i = 0; i < numTombstones; ++i) {
+        list.add(makeTombstone(i * 10, i * 10 + 5, static_cast<uint64_t>(i + 1)));
+    }
+    RangeTombstoneList copy(list);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(12, 0)), 2u);
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(17, 0)), 0u);
+    EXPECT_EQ(copy.maxCoveringSequence(KeyValueWrapper(199993, 0)), static_cast<uint64_t>(numTombstones));
+
+    list.add(makeTombstone(0, 100, 100000));
+    EXPECT_EQ(list.maxCoveringSequence(KeyValueWrapper(17, 0)), 100000u);
+    EXPECT_EQ(copy.maxCoveringSequence(KeyValueWrapper(17, 0)), 0u);
+
+    RangeTombstoneList moved(std::move(copy));
+    EXPECT_EQ(moved.size(), static_cast<size_t>(numTombstones));
+    EXPECT_EQ(moved.maxCoveringSequence(KeyValueWrapper(12, 0)), 2u);
+    RangeTombstoneList restored = RangeTombstoneList::deserialize(list.serialize());
+    EXPECT_EQ(restored.maxCoveringSequence(KeyValueWrapper(17, 0)), 100000u);
+}
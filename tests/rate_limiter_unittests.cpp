@@ -0,0 +1,100 @@
+//
+// RateLimiterTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "RateLimiter.h"
+#include "LSMTree.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Without a rate nothing waits; with one, bytes beyond the burst take bytes / rate
+TEST(RateLimiterTest, ThrottlesToRate) {
+    RateLimiter limiter;
+    auto start = Clock::now();
+    for (int i = 0; i < 100; ++i) {
+        limiter.request(1 << 20, RateLimiter::Priority::LOW);
+    }
+    EXPECT_LT(secondsSince(start), 0.1);
+    EXPECT_EQ(limiter.getTotalBytes(RateLimiter::Priority::LOW), 100u << 20);
+
+    // 4 MB/s: 1 MB takes 250 ms from an empty bucket
+    limiter.setBytesPerSecond(RateLimiter::Priority::LOW, 4 << 20);
+    EXPECT_EQ(limiter.getBytesPerSecond(RateLimiter::Priority::LOW), 4u << 20);
+    start = Clock::now();
+    limiter.request(1 << 20, RateLimiter::Priority::LOW);
+    limiter.request(1 << 20, RateLimiter::Priority::LOW);
+    double elapsed = secondsSince(start);
+    EXPECT_GE(elapsed, 0.4);
+    EXPECT_LT(elapsed, 2.0);
+    EXPECT_GT(limiter.getTotalWaitSeconds(RateLimiter::Priority::LOW), 0.3);
+
+    // The other priority has its own budget
+    start = Clock::now();
+    limiter.request(8 << 20, RateLimiter::Priority::HIGH);
+    EXPECT_LT(secondsSince(start), 0.1);
+    EXPECT_EQ(limiter.getTotalWaitSeconds(RateLimiter::Priority::HIGH), 0.0);
+}
+
+// Raising the rate wakes a writer waiting on the old one
+TEST(RateLimiterTest, RateChangeWakesWaiters) {
+    RateLimiter limiter(0, 1 << 20);
+    auto start = Clock::now();
+    std::thread writer([&limiter]() { limiter.request(8 << 20, RateLimiter::Priority::LOW); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    limiter.setBytesPerSecond(RateLimiter::Priority::LOW, 0);
+    writer.join();
+    // 8 s at the old rate
+    EXPECT_LT(secondsSince(start), 2.0);
+}
+
+// Flushes are charged to the HIGH budget and compactions to the LOW one
+TEST(RateLimiterTest, LSMTreeChargesFlushesAndCompactions) {
+    std::string dbPath = "test_rate_limiter_db";
+    fs::remove_all(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        lsmTree.setCompactionRateLimit(64 << 20);
+        for (int i = 0; i < 3000; ++i) {
+            lsmTree.put(KeyValueWrapper(i, i));
+        }
+        const RateLimiter& limiter = lsmTree.getRateLimiter();
+        EXPECT_EQ(limiter.getBytesPerSecond(RateLimiter::Priority::LOW), 64u << 20);
+        EXPECT_EQ(limiter.getBytesPerSecond(RateLimiter::Priority::HIGH), 0u);
+        EXPECT_GT(limiter.getTotalBytes(RateLimiter::Priority::HIGH), 0u);
+        EXPECT_GT(limiter.getTotalBytes(RateLimiter::Priority::LOW), 0u);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1234, 0)).kv.int_value(), 1234);
+    }
+    fs::remove_all(dbPath);
+}
+
+// Column families write under one budget: a family's flushes are charged to the limits
+// set on the database's default tree
+TEST(RateLimiterTest, ColumnFamiliesShareOneBudget) {
+    std::string dbPath = "test_rate_limiter_families";
+    fs::remove_all(dbPath);
+    {
+        LSMTree lsmTree(500, dbPath);
+        std::shared_ptr<ColumnFamilyShared> shared = lsmTree.shareWithColumnFamilies(nullptr);
+        LSMTree family(100, dbPath + "/cf_1", ColumnFamilyHandle(1, "family"), shared);
+        lsmTree.setFlushRateLimit(256 << 20);
+
+        const RateLimiter& limiter = family.getRateLimiter();
+        EXPECT_EQ(&limiter, &lsmTree.getRateLimiter());
+        EXPECT_EQ(limiter.getBytesPerSecond(RateLimiter::Priority::HIGH), 256u << 20);
+        for (int i = 0; i < 250; ++i) {
+            family.put(KeyValueWrapper(i, i));
+        }
+        EXPECT_GT(lsmTree.getRateLimiter().getTotalBytes(RateLimiter::Priority::HIGH), 0u);
+        EXPECT_EQ(family.get(KeyValueWrapper(42, 0)).kv.int_value(), 42);
+    }
+    fs::remove_all(dbPath);
+}
@@ -0,0 +1,127 @@
+//
+// SstWriterTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "SstWriter.h"
+#include "PageManager.h"
+#include "DiskBTree.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// Pages come back at the offsets appendPage returned, across buffer flushes
+TEST(SstWriterTest, AppendAndRewritePages) {
+    std::string fileName = "test_sst_writer.sst";
+    fs::remove(fileName);
+
+    const size_t pageSize = 4096;
+    std::vector<uint64_t> offsets;
+    {
+        // A buffer of three pages, so most pages are written before finish()
+        SstWriter writer(fileName, pageSize, 3 * pageSize, 2 * pageSize);
+        writer.appendPage(Page(Page::PageType::SST_METADATA));
+        for (int i = 0; i < 10; ++i) {
+            Page page(Page::PageType::LEAF_NODE);
+            page.addLeafEntry(KeyValueWrapper(i, i * 10));
+            offsets.push_back(writer.appendPage(page));
+            EXPECT_EQ(offsets.back(), (i + 1) * pageSize);
+        }
+        std::string raw(5000, 'x');
+        EXPECT_EQ(writer.appendRegion(raw.data(), raw.size()), 11 * pageSize);
+        EXPECT_EQ(writer.getOffset(), 13 * pageSize);
+
+        // Offset 0 was written out already, the last leaf is still buffered
+        Page metadataPage(Page::PageType::SST_METADATA);
+        metadataPage.setMetadata(offsets[4], offsets.front(), offsets.back(), fileName);
+        writer.rewritePage(0, metadataPage);
+        Page lastLeaf(Page::PageType::LEAF_NODE);
+        lastLeaf.addLeafEntry(KeyValueWrapper(99, 990));
+        writer.rewritePage(offsets.back(), lastLeaf);
+        EXPECT_THROW(writer.rewritePage(writer.getOffset(), lastLeaf), std::runtime_error);
+        writer.finish();
+        EXPECT_THROW(writer.finish(), std::runtime_error);
+    }
+    EXPECT_EQ(fs::file_size(fileName), 13 * pageSize);
+
+    PageManager pageManager(fileName, pageSize);
+    uint64_t rootOffset, leafBegin, leafEnd;
+    std::string name;
+    pageManager.readPage(0).getMetadata(rootOffset, leafBegin, leafEnd, name);
+    EXPECT_EQ(rootOffset, offsets[4]);
+    EXPECT_EQ(leafBegin, offsets.front());
+    EXPECT_EQ(leafEnd, offsets.back());
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_EQ(pageManager.readPage(offsets[i]).getLeafEntries()[0].kv.int_key(), i);
+    }
+    EXPECT_EQ(pageManager.readPage(offsets.back()).getLeafEntries()[0].kv.int_key(), 99);
+    std::vector<char> region = pageManager.readRawBytes(11 * pageSize, 2 * pageSize);
+    EXPECT_EQ(region[4999], 'x');
+    EXPECT_EQ(region[5000], 0);
+    pageManager.close();
+    fs::remove(fileName);
+}
+
+// An SST built through small write buffers has its leaves linked in both directions
+TEST(SstWriterTest, DiskBTreeLeavesLinked) {
+    std::string fileName = "test_sst_writer_tree.sst";
+    fs::remove(fileName);
+
+    std::vector<KeyValueWrapper> kvs;
+    for (int i = 0; i < 5000; ++i) {
+        kvs.emplace_back(i, i);
+    }
+    SSTBuildOptions options;
+    options.writeBufferSize = 4096;
+    options.bytesPerSync = 64 * 1024;
+    {
+        DiskBTree sst(fileName, kvs, 4096, options);
+    }
+
+    DiskBTree sst(fileName);
+    int expected = 0;
+    uint64_t offset = sst.getLeafBeginOffset();
+    uint64_t previous = 0;
+    while (offset != 0) {
+        Page page = sst.pageManager->readPage(offset);
+        EXPECT_EQ(page.getPrevLeafOffset(), previous);
+        for (const auto& kv : page.getLeafEntries()) {
+            EXPECT_EQ(kv.kv.int_key(), expected++);
+        }
+        previous = offset;
+        offset = page.getNextLeafOffset();
+    }
+    EXPECT_EQ(expected, 5000);
+    EXPECT_EQ(previous, sst.getLeafEndOffset());
+    std::unique_ptr<KeyValueWrapper> found(sst.search(KeyValueWrapper(4321, 0)));
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->kv.int_value(), 4321);
+    fs::remove(fileName);
+}
+
+// Writing pages on the background thread produces the same file as writing them inline
+TEST(SstWriterTest, BackgroundWriterSameBytes) {
+    std::vector<KeyValueWrapper> kvs;
+    for (int i = 0; i < 20000; ++i) {
+        kvs.emplace_back(i, "value_" + std::to_string(i));
+    }
+    std::vector<std::vector<char>> contents;
+    for (bool pipelined : {false, true}) {
+        std::string fileName = "test_sst_writer_background.sst";
+        fs::remove(fileName);
+        SSTBuildOptions options;
+        options.filterType = SSTFilterType::XOR;
+        options.prefixLength = 3;
+        options.writeBufferSize = 8 * 4096;
+        options.pipelinedWrites = pipelined;
+        {
+            DiskBTree sst(fileName, kvs, 4096, options);
+        }
+        PageManager pageManager(fileName);
+        contents.push_back(pageManager.readRawBytes(0, fs::file_size(fileName)));
+        pageManager.close();
+        fs::remove(fileName);
+    }
+    ASSERT_EQ(contents[0].size(), contents[1].size());
+    EXPECT_TRUE(contents[0] == contents[1]);
+}
@@ -0,0 +1,326 @@
+//
+// WriteBatchTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "WriteBatch.h"
+#include "WAL.h"
+#include "LSMTree.h"
+#include "VeloxDB.h"
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+void removeWriteBatchTestPath(const std::string& path) {
+    if (fs::exists(path)) {
+        fs::remove_all(path);
+    }
+}
+}
+
+// Records decode in order with consecutive sequence numbers
+TEST(WriteBatchTest, EncodeDecode) {
+    WriteBatch batch;
+    EXPECT_EQ(batch.Count(), 0u);
+    batch.Put(1, 100);
+    batch.Put("key", "value");
+    batch.Delete(2);
+    batch.setSequence(1000);
+    EXPECT_EQ(batch.Count(), 3u);
+
+    std::vector<KeyValueWrapper> records;
+    WriteBatch copy = WriteBatch::fromRep(batch.getRep());
+    copy.forEach([&records](KeyValueWrapper& kv) { records.push_back(kv); });
+    ASSERT_EQ(records.size(), 3u);
+
+    EXPECT_EQ(records[0].kv.int_key(), 1);
+    EXPECT_EQ(records[0].kv.int_value(), 100);
+    EXPECT_FALSE(records[0].isTombstone());
+    EXPECT_EQ(records[1].kv.string_key(), "key");
+    EXPECT_EQ(records[1].kv.string_value(), "value");
+    EXPECT_EQ(records[2].kv.int_key(), 2);
+    EXPECT_TRUE(records[2].isTombstone());
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].sequenceNumber, 1000 + i);
+    }
+
+    batch.Clear();
+    EXPECT_EQ(batch.Count(), 0u);
+    EXPECT_EQ(batch.ApproximateSize(), WriteBatch::HEADER_SIZE);
+}
+
+// DeleteRange records carry both bounds and need a range handler
+TEST(WriteBatchTest, DeleteRangeRecords) {
+    WriteBatch batch;
+    batch.Put(1, 100);
+    batch.DeleteRange(KeyValueWrapper("tenant1/", ""), KeyValueWrapper("tenant2/", ""));
+    batch.Put(2, 200);
+    batch.setSequence(50);
+    EXPECT_EQ(batch.Count(), 3u);
+
+    std::vector<KeyValueWrapper> records;
+    std::vector<RangeTombstone> ranges;
+    WriteBatch copy = WriteBatch::fromRep(batch.getRep());
+    copy.forEach([&records](KeyValueWrapper& kv) { records.push_back(kv); },
+                 [&ranges](RangeTombstone& tombstone) { ranges.push_back(tombstone); });
+    ASSERT_EQ(records.size(), 2u);
+    ASSERT_EQ(ranges.size(), 1u);
+    EXPECT_EQ(records[1].sequenceNumber, 52u);
+    EXPECT_EQ(ranges[0].start.kv.string_key(), "tenant1/");
+    EXPECT_EQ(ranges[0].end.kv.string_key(), "tenant2/");
+    EXPECT_EQ(ranges[0].sequenceNumber, 51u);
+
+    EXPECT_THROW(copy.forEach([](KeyValueWrapper&) {}), std::runtime_error);
+}
+
+// Merge records decode as merge operands, and need a merge operator to be written
+TEST(WriteBatchTest, MergeRecords) {
+    WriteBatch batch;
+    batch.Put(1, 100);
+    EXPECT_FALSE(batch.HasMerge());
+    batch.Merge(1, 5);
+    batch.Delete(2);
+    EXPECT_TRUE(batch.HasMerge());
+
+    std::vector<KeyValueWrapper> records;
+    WriteBatch::fromRep(batch.getRep()).forEach([&records](KeyValueWrapper& kv) { records.push_back(kv); });
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_FALSE(records[0].isMergeOperand());
+    EXPECT_TRUE(records[1].isMergeOperand());
+    EXPECT_EQ(records[1].kv.int_value(), 5);
+    EXPECT_FALSE(records[2].isMergeOperand());
+    EXPECT_TRUE(records[2].isTombstone());
+
+    std::string dbPath = "test_write_batch_merge";
+    removeWriteBatchTestPath(dbPath);
+    {
+        LSMTree lsmTree(1000, dbPath);
+        EXPECT_THROW(lsmTree.write(batch), std::runtime_error);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(1, 0)).isEmpty());
+
+        lsmTree.setMergeOperator(std::make_shared<Int64AddOperator>());
+        lsmTree.write(batch);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1, 0)).kv.long_value(), 105);
+    }
+    removeWriteBatchTestPath(dbPath);
+}
+
+// Expiry times travel with Put and Merge records; SetDefaultExpiry fills in the missing ones
+TEST(WriteBatchTest, ExpiryRecords) {
+    WriteBatch batch;
+    KeyValueWrapper expiring(1, 100);
+    expiring.expiresAt = 5000;
+    batch.Put(expiring);
+    batch.Put(2, 200);
+    batch.Delete(3);
+    batch.Merge(4, 1);
+    batch.SetDefaultExpiry(9000);
+    EXPECT_TRUE(batch.HasMerge());
+
+    std::vector<KeyValueWrapper> records;
+    WriteBatch::fromRep(batch.getRep()).forEach([&records](KeyValueWrapper& kv) { records.push_back(kv); });
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].expiresAt, 5000u);
+    EXPECT_EQ(records[0].kv.int_value(), 100);
+    EXPECT_EQ(records[1].expiresAt, 9000u);
+    EXPECT_EQ(records[1].kv.int_value(), 200);
+    EXPECT_EQ(records[2].expiresAt, 0u);
+    EXPECT_TRUE(records[2].isTombstone());
+    EXPECT_EQ(records[3].expiresAt, 9000u);
+    EXPECT_TRUE(records[3].isMergeOperand());
+    EXPECT_TRUE(records[1].isExpired(9000));
+    EXPECT_FALSE(records[1].isExpired(8999));
+}
+
+// Records carry their column family; forEach, HasMerge and SetDefaultExpiry only see one family's
+TEST(WriteBatchTest, ColumnFamilyRecords) {
+    ColumnFamilyHandle users(1, "users");
+    ColumnFamilyHandle counters(7, "counters");
+    WriteBatch batch;
+    batch.Put(1, 100);
+    batch.Put(users, 1, 200);
+    KeyValueWrapper expiring(2, 300);
+    expiring.expiresAt = 5000;
+    batch.Put(users, expiring);
+    batch.Merge(counters, 3, 1);
+    batch.Delete(users, 4);
+    batch.DeleteRange(users, KeyValueWrapper(10, ""), KeyValueWrapper(20, ""));
+    batch.SetDefaultExpiry(9000, users.getId());
+    batch.setSequence(50);
+
+    EXPECT_EQ(batch.Count(), 6u);
+    EXPECT_EQ(batch.ColumnFamilyIds(), std::vector<uint32_t>({0, 1, 7}));
+    EXPECT_FALSE(batch.HasMerge());
+    EXPECT_FALSE(batch.HasMerge(users.getId()));
+    EXPECT_TRUE(batch.HasMerge(counters.getId()));
+
+    WriteBatch decoded = WriteBatch::fromRep(batch.getRep());
+    std::vector<KeyValueWrapper> defaultRecords, userRecords, counterRecords;
+    std::vector<RangeTombstone> userRanges;
+    decoded.forEach([&defaultRecords](KeyValueWrapper& kv) { defaultRecords.push_back(kv); });
+    decoded.forEach([&userRecords](KeyValueWrapper& kv) { userRecords.push_back(kv); },
+                    [&userRanges](RangeTombstone& tombstone) { userRanges.push_back(tombstone); }, users.getId());
+    decoded.forEach([&counterRecords](KeyValueWrapper& kv) { counterRecords.push_back(kv); }, nullptr,
+                    counters.getId());
+
+    ASSERT_EQ(defaultRecords.size(), 1u);
+    EXPECT_EQ(defaultRecords[0].kv.int_value(), 100);
+    EXPECT_EQ(defaultRecords[0].sequenceNumber, 50u);
+    EXPECT_EQ(defaultRecords[0].expiresAt, 0u);
+
+    ASSERT_EQ(userRecords.size(), 3u);
+    EXPECT_EQ(userRecords[0].kv.int_value(), 200);
+    EXPECT_EQ(userRecords[0].sequenceNumber, 51u);
+    EXPECT_EQ(userRecords[0].expiresAt, 9000u);
+    EXPECT_EQ(userRecords[1].expiresAt, 5000u);
+    EXPECT_TRUE(userRecords[2].isTombstone());
+    EXPECT_EQ(userRecords[2].sequenceNumber, 54u);
+    ASSERT_EQ(userRanges.size(), 1u);
+    EXPECT_EQ(userRanges[0].start.kv.int_key(), 10);
+    EXPECT_EQ(userRanges[0].sequenceNumber, 55u);
+
+    ASSERT_EQ(counterRecords.size(), 1u);
+    EXPECT_TRUE(counterRecords[0].isMergeOperand());
+    EXPECT_EQ(counterRecords[0].sequenceNumber, 53u);
+    EXPECT_EQ(counterRecords[0].expiresAt, 0u);
+}
+
+// A rolled segment is replayed before the current one until it is removed
+TEST(WriteBatchTest, WALRollReplaysRolledSegmentFirst) {
+    std::string dir = "test_wal_roll";
+    removeWriteBatchTestPath(dir);
+    fs::create_directories(dir);
+    std::string path = dir + "/wal.log";
+    auto replayKeys = [&path]() {
+        std::vector<int> keys;
+        WAL::replay(path, [&keys](const WriteBatch& batch) {
+            batch.forEach([&keys](KeyValueWrapper& kv) { keys.push_back(kv.kv.int_key()); });
+        });
+        return keys;
+    };
+
+    WAL wal(path);
+    WriteBatch first;
+    first.Put(1, 1);
+    wal.append(first);
+    EXPECT_EQ(wal.getSize(), fs::file_size(path));
+
+    wal.roll();
+    EXPECT_EQ(wal.getSize(), 0u);
+    EXPECT_TRUE(fs::exists(WAL::rolledSegmentPath(path)));
+    EXPECT_THROW(wal.roll(), std::logic_error);
+    WriteBatch second;
+    second.Put(2, 2);
+    wal.append(second);
+    EXPECT_EQ(replayKeys(), std::vector<int>({1, 2}));
+
+    wal.removeRolledSegment();
+    EXPECT_FALSE(fs::exists(WAL::rolledSegmentPath(path)));
+    EXPECT_EQ(replayKeys(), std::vector<int>({2}));
+
+    removeWriteBatchTestPath(dir);
+}
+
+// A torn record at the end of the log is dropped and cut off
+TEST(WriteBatchTest, WALReplayStopsAtTornRecord) {
+    std::string dir = "test_wal_replay";
+    removeWriteBatchTestPath(dir);
+    fs::create_directories(dir);
+    std::string path = dir + "/wal.log";
+    {
+        WAL wal(path);
+        for (int i = 0; i < 3; ++i) {
+            WriteBatch batch;
+            batch.Put(i, i * 10);
+            batch.setSequence(i + 1);
+            wal.append(batch);
+        }
+    }
+    uintmax_t completeSize = fs::file_size(path);
+    {
+        // Simulate a crash in the middle of an append
+        std::ofstream ofs(path, std::ios::binary | std::ios::app);
+        uint32_t size = 100;
+        ofs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        ofs.write("torn", 4);
+    }
+
+    std::vector<int> keys;
+    size_t numBatches = WAL::replay(path, [&keys](const WriteBatch& batch) {
+        batch.forEach([&keys](KeyValueWrapper& kv) { keys.push_back(kv.kv.int_key()); });
+    });
+    EXPECT_EQ(numBatches, 3u);
+    EXPECT_EQ(keys, std::vector<int>({0, 1, 2}));
+    EXPECT_EQ(fs::file_size(path), completeSize);
+
+    removeWriteBatchTestPath(dir);
+}
+
+// A batch gets one sequence range, and unflushed writes survive a restart through the WAL
+TEST(WriteBatchTest, LSMTreeWriteAndRecover) {
+    std::string dbPath = "test_lsm_write_batch";
+    removeWriteBatchTestPath(dbPath);
+    {
+        LSMTree lsmTree(1000, dbPath);
+        lsmTree.put(KeyValueWrapper(1, 1));
+
+        WriteBatch batch;
+        for (int i = 0; i < 100; ++i) {
+            batch.Put(i, i * 10);
+        }
+        batch.Delete(50);
+        lsmTree.write(batch);
+        EXPECT_EQ(batch.Count(), 101u);
+
+        // Later records of the batch win over earlier ones and over older puts
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1, 0)).kv.int_value(), 10);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(50, 0)).isEmpty());
+        KeyValueWrapper last = lsmTree.get(KeyValueWrapper(99, 0));
+        EXPECT_EQ(last.sequenceNumber, batch.getSequence() + 99);
+
+        // Newer than every record of the batch
+        lsmTree.put(KeyValueWrapper(99, -1));
+        EXPECT_GT(lsmTree.get(KeyValueWrapper(99, 0)).sequenceNumber, batch.getSequence() + 100);
+    }
+    {
+        // Nothing was flushed; the memtable is rebuilt from the WAL
+        LSMTree lsmTree(1000, dbPath);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(0, 0)).kv.int_value(), 0);
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(1, 0)).kv.int_value(), 10);
+        EXPECT_TRUE(lsmTree.get(KeyValueWrapper(50, 0)).isEmpty());
+        EXPECT_EQ(lsmTree.get(KeyValueWrapper(99, 0)).kv.int_value(), -1);
+    }
+    removeWriteBatchTestPath(dbPath);
+}
+
+// Batches crossing the memtable threshold are flushed whole and the WAL is reset
+TEST(WriteBatchTest, VeloxDBWriteFlushesAndResetsWAL) {
+    std::string dbName = "test_db_write_batch";
+    removeWriteBatchTestPath(dbName);
+
+    auto db = std::make_unique<VeloxDB>(100);
+    db->Open(dbName);
+    for (int round = 0; round < 5; ++round) {
+        WriteBatch batch;
+        for (int i = 0; i < 60; ++i) {
+            int key = round * 60 + i;
+            batch.Put(key, key * 2);
+        }
+        db->Write(batch);
+    }
+
+    // 300 records in batches of 60: flushes after 120 and 240, 60 records remain logged
+    std::vector<int> keys;
+    WAL::replay(dbName + "/wal.log", [&keys](const WriteBatch& batch) {
+        batch.forEach([&keys](KeyValueWrapper& kv) { keys.push_back(kv.kv.int_key()); });
+    });
+    EXPECT_EQ(keys.size(), 60u);
+
+    for (int key = 0; key < 300; ++key) {
+        EXPECT_EQ(db->Get(key).kv.int_value(), key * 2) << key;
+    }
+    db->Close();
+    removeWriteBatchTestPath(dbName);
+}
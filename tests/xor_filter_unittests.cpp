@@ -0,0 +1,123 @@
+//
+// XorFilterTest.cpp
+//
+
+#include <gtest/gtest.h>
+#include "XorFilter.h"
+#include "BloomFilter.h"
+#include "DiskBTree.h"
+#include "KeyValue.h"
+#include <filesystem>
+#include <cmath>
+#include <vector>
+#include <string>
+
+namespace {
+std::vector<uint64_t> xorHashes(int begin, int end) {
+    std::vector<uint64_t> hashes;
+    for (int i = begin; i < end; ++i) {
+        hashes.push_back(XorFilter::hashKey(KeyValueWrapper(i, 0)));
+    }
+    return hashes;
+}
+}
+
+// Every inserted key must be reported as possibly present
+TEST(XorFilterTest, NoFalseNegatives) {
+    XorFilter filter(xorHashes(0, 10000));
+    EXPECT_EQ(filter.getNumKeys(), 10000);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(filter.possiblyContains(KeyValueWrapper(i, 0)));
+    }
+}
+
+// String keys hash by key only, the value does not matter
+TEST(XorFilterTest, StringKeys) {
+    std::vector<uint64_t> hashes;
+    for (int i = 0; i < 500; ++i) {
+        hashes.push_back(XorFilter::hashKey(KeyValueWrapper("key_" + std::to_string(i), "value")));
+    }
+    XorFilter filter(hashes);
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_TRUE(filter.possiblyContains(KeyValueWrapper("key_" + std::to_string(i), "")));
+    }
+}
+
+// The false positive rate is close to 1/256
+TEST(XorFilterTest, FalsePositiveRate) {
+    XorFilter filter(xorHashes(0, 10000));
+    int falsePositives = 0;
+    const int numQueries = 100000;
+    for (int i = 10000; i < 10000 + numQueries; ++i) {
+        if (filter.possiblyContains(KeyValueWrapper(i, 0))) {
+            falsePositives++;
+        }
+    }
+    double rate = static_cast<double>(falsePositives) / numQueries;
+    EXPECT_LT(rate, 2 * XorFilter::FALSE_POSITIVE_RATE);
+}
+
+// Smaller than a Bloom filter with the same false positive rate
+TEST(XorFilterTest, SmallerThanBloomFilter) {
+    const size_t n = 10000;
+    XorFilter filter(xorHashes(0, n));
+    // Bloom filter needs -ln(p) / ln(2)^2 bits per key for p = 1/256
+    double bloomBitsPerKey = -std::log(XorFilter::FALSE_POSITIVE_RATE) / (std::log(2.0) * std::log(2.0));
+    size_t bloomBytes = BloomFilter::serializedSizeForBits(BloomFilter::bitsForKeys(n, bloomBitsPerKey));
+    EXPECT_LT(filter.getSerializedSize(), bloomBytes);
+    EXPECT_LT(8.0 * filter.getSerializedSize() / n, 10.0);
+}
+
+// Serialize and deserialize round trip
+TEST(XorFilterTest, SerializeDeserialize) {
+    XorFilter filter(xorHashes(0, 1000));
+    std::vector<char> data = filter.serialize();
+    EXPECT_EQ(data.size(), filter.getSerializedSize());
+
+    XorFilter restored;
+    restored.deserialize(data);
+    EXPECT_EQ(restored.getNumKeys(), filter.getNumKeys());
+    for (int i = 0; i < 2000; ++i) {
+        KeyValueWrapper kv(i, 0);
+        EXPECT_EQ(restored.possiblyContains(kv), filter.possiblyContains(kv));
+    }
+}
+
+// An SST built with the xor filter stores it in its filter region and reloads it on open
+TEST(XorFilterTest, DiskBTreeFilterRegion) {
+    std::string fileName = "test_xor_filter_region.sst";
+    std::filesystem::remove(fileName);
+
+    std::vector<KeyValueWrapper> keyValues;
+    for (int i = 0; i < 2000; i += 2) {
+        keyValues.emplace_back(i, i * 10);
+    }
+
+    SSTBuildOptions options;
+    options.filterType = SSTFilterType::XOR;
+    size_t filterBytes = 0;
+    {
+        DiskBTree btree(fileName, keyValues, 4096, options);
+        EXPECT_EQ(btree.getFilterType(), SSTFilterType::XOR);
+        filterBytes = btree.getFilterBytes();
+        EXPECT_GT(filterBytes, 0);
+        // Fixed header and slack dominate less as the SST grows; still below a 1/256 Bloom filter
+        EXPECT_LT(btree.getFilterBitsPerKey(), 11.5);
+    }
+
+    DiskBTree reopened(fileName);
+    EXPECT_EQ(reopened.getFilterType(), SSTFilterType::XOR);
+    EXPECT_EQ(reopened.getFilterBytes(), filterBytes);
+    for (int i = 0; i < 2000; ++i) {
+        KeyValueWrapper* result = reopened.search(KeyValueWrapper(i, 0));
+        if (i % 2 == 0) {
+            ASSERT_NE(result, nullptr);
+            EXPECT_EQ(result->kv.int_value(), i * 10);
+        } else {
+            EXPECT_EQ(result, nullptr);
+        }
+        delete result;
+    }
+
+    std::filesystem::remove(fileName);
+}